@@ -28,6 +28,7 @@ public class GitSourceControl : ModuleRules
 			//?	"LevelEditor",
 				"SourceControl",
 				"Projects",
+				"GitSourceControlCore",
 			}
 		);
 
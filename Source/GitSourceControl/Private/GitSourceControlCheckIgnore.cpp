@@ -0,0 +1,244 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlCheckIgnore.h"
+
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "ISourceControlModule.h"
+
+namespace GitCheckIgnoreConstants
+{
+	/** The maximum number of files we write at once to the standard input of the process (to stay below the size of the pipe buffer) */
+	const int32 MaxFilesPerBatch = 32;
+
+	/** Number of NUL terminated fields per file in the output of "check-ignore -z --verbose --non-matching": <source> <linenum> <pattern> <pathname> */
+	const int32 FieldsPerFile = 4;
+
+	/** Time to wait for the answers of the process before giving up */
+	const double Timeout = 10.0;
+}
+
+FGitCheckIgnore::~FGitCheckIgnore()
+{
+	Close();
+}
+
+void FGitCheckIgnore::Init(const FString& InPathToGitBinary, const FString& InRepositoryRoot)
+{
+	FScopeLock ScopeLock(&ProcessCriticalSection);
+	if((PathToGitBinary != InPathToGitBinary) || (RepositoryRoot != InRepositoryRoot))
+	{
+		StopProcess();
+		EmptyCache();
+		PathToGitBinary = InPathToGitBinary;
+		RepositoryRoot = InRepositoryRoot;
+		bProcessFailed = false;
+	}
+}
+
+void FGitCheckIgnore::Close()
+{
+	FScopeLock ScopeLock(&ProcessCriticalSection);
+	StopProcess();
+	EmptyCache();
+	bProcessFailed = false;
+}
+
+void FGitCheckIgnore::EmptyCache()
+{
+	FRWScopeLock ScopeLock(CacheLock, SLT_Write);
+	IgnoredCache.Empty();
+}
+
+bool FGitCheckIgnore::FindCached(const FString& InFile, bool& bOutIgnored) const
+{
+	FRWScopeLock ScopeLock(CacheLock, SLT_ReadOnly);
+	if(const bool* bIgnored = IgnoredCache.Find(InFile))
+	{
+		bOutIgnored = *bIgnored;
+		return true;
+	}
+	return false;
+}
+
+TSet<FString> FGitCheckIgnore::GetIgnoredFiles(const TArray<FString>& InFiles)
+{
+	TSet<FString> IgnoredFiles;
+
+	FScopeLock ScopeLock(&ProcessCriticalSection);
+
+	CheckIgnoreFilesTimeStamps();
+
+	TArray<FString> FilesToQuery;
+	{
+		FRWScopeLock CacheScopeLock(CacheLock, SLT_ReadOnly);
+		for(const FString& File : InFiles)
+		{
+			if(const bool* bIgnored = IgnoredCache.Find(File))
+			{
+				if(*bIgnored)
+				{
+					IgnoredFiles.Add(File);
+				}
+			}
+			else
+			{
+				FilesToQuery.Add(File);
+			}
+		}
+	}
+
+	if((FilesToQuery.Num() == 0) || bProcessFailed || RepositoryRoot.IsEmpty())
+	{
+		return IgnoredFiles;
+	}
+	if(!ProcessHandle.IsValid() && !StartProcess())
+	{
+		return IgnoredFiles;
+	}
+
+	FString RelativeTo = RepositoryRoot;
+	if(!RelativeTo.EndsWith(TEXT("/")))
+	{
+		RelativeTo += TEXT("/");
+	}
+
+	for(int32 FirstFile = 0; FirstFile < FilesToQuery.Num(); FirstFile += GitCheckIgnoreConstants::MaxFilesPerBatch)
+	{
+		const int32 NumFiles = FMath::Min(GitCheckIgnoreConstants::MaxFilesPerBatch, FilesToQuery.Num() - FirstFile);
+
+		// Paths relative to the root of the repository, each terminated by a NUL character
+		TArray<uint8> Input;
+		for(int32 FileIndex = FirstFile; FileIndex < FirstFile + NumFiles; FileIndex++)
+		{
+			FString RelativeFile = FilesToQuery[FileIndex];
+			FPaths::MakePathRelativeTo(RelativeFile, *RelativeTo);
+			FTCHARToUTF8 Utf8File(*RelativeFile);
+			Input.Append(reinterpret_cast<const uint8*>(Utf8File.Get()), Utf8File.Length());
+			Input.Add(0);
+		}
+
+		// Write the paths while reading the answers, until there is one answer for each path
+		TArray<FString> Fields;
+		TArray<uint8> PendingOutput;
+		int32 InputOffset = 0;
+		const double TimeLimit = FPlatformTime::Seconds() + GitCheckIgnoreConstants::Timeout;
+		while(Fields.Num() < NumFiles * GitCheckIgnoreConstants::FieldsPerFile)
+		{
+			if(InputOffset < Input.Num())
+			{
+				int32 BytesWritten = 0;
+				FPlatformProcess::WritePipe(StdInWrite, Input.GetData() + InputOffset, Input.Num() - InputOffset, &BytesWritten);
+				InputOffset += BytesWritten;
+			}
+
+			TArray<uint8> Output;
+			if(FPlatformProcess::ReadPipeToArray(StdOutRead, Output))
+			{
+				PendingOutput.Append(MoveTemp(Output));
+				int32 FieldStart = 0;
+				for(int32 Index = 0; Index < PendingOutput.Num(); Index++)
+				{
+					if(PendingOutput[Index] == 0)
+					{
+						const FUTF8ToTCHAR Field(reinterpret_cast<const ANSICHAR*>(PendingOutput.GetData() + FieldStart), Index - FieldStart);
+						Fields.Emplace(Field.Length(), Field.Get());
+						FieldStart = Index + 1;
+					}
+				}
+				PendingOutput.RemoveAt(0, FieldStart);
+			}
+			else if(!FPlatformProcess::IsProcRunning(ProcessHandle) || (FPlatformTime::Seconds() > TimeLimit))
+			{
+				UE_LOG(LogSourceControl, Warning, TEXT("git check-ignore did not answer: ignored files will be reported as unchanged"));
+				StopProcess();
+				bProcessFailed = true;
+				return IgnoredFiles;
+			}
+			else
+			{
+				FPlatformProcess::Sleep(0.0001f);
+			}
+		}
+
+		FRWScopeLock CacheScopeLock(CacheLock, SLT_Write);
+		for(int32 FileIndex = 0; FileIndex < NumFiles; FileIndex++)
+		{
+			// A non-matching file has an empty pattern, and a negated pattern "!pattern" means the file is explicitly not ignored
+			const FString& Pattern = Fields[FileIndex * GitCheckIgnoreConstants::FieldsPerFile + 2];
+			const bool bIgnored = !Pattern.IsEmpty() && !Pattern.StartsWith(TEXT("!"));
+			const FString& File = FilesToQuery[FirstFile + FileIndex];
+			IgnoredCache.Add(File, bIgnored);
+			if(bIgnored)
+			{
+				IgnoredFiles.Add(File);
+			}
+		}
+	}
+
+	return IgnoredFiles;
+}
+
+bool FGitCheckIgnore::StartProcess()
+{
+	verify(FPlatformProcess::CreatePipe(StdOutRead, StdOutWrite));
+	verify(FPlatformProcess::CreatePipe(StdInRead, StdInWrite, true));
+
+	const FString Parameters = FString::Printf(TEXT("-C \"%s\" check-ignore --stdin -z --verbose --non-matching"), *RepositoryRoot);
+	UE_LOG(LogSourceControl, Log, TEXT("StartProcess: 'git %s'"), *Parameters);
+
+	const bool bLaunchDetached = false;
+	const bool bLaunchHidden = true;
+	const bool bLaunchReallyHidden = bLaunchHidden;
+	ProcessHandle = FPlatformProcess::CreateProc(*PathToGitBinary, *Parameters, bLaunchDetached, bLaunchHidden, bLaunchReallyHidden, nullptr, 0, *RepositoryRoot, StdOutWrite, StdInRead);
+	if(!ProcessHandle.IsValid())
+	{
+		UE_LOG(LogSourceControl, Warning, TEXT("Failed to launch 'git check-ignore': ignored files will be reported as unchanged"));
+		StopProcess();
+		bProcessFailed = true;
+		return false;
+	}
+
+	return true;
+}
+
+void FGitCheckIgnore::StopProcess()
+{
+	if(ProcessHandle.IsValid())
+	{
+		FPlatformProcess::TerminateProc(ProcessHandle);
+		FPlatformProcess::CloseProc(ProcessHandle);
+	}
+	if(StdOutRead || StdOutWrite)
+	{
+		FPlatformProcess::ClosePipe(StdOutRead, StdOutWrite);
+		StdOutRead = StdOutWrite = nullptr;
+	}
+	if(StdInRead || StdInWrite)
+	{
+		FPlatformProcess::ClosePipe(StdInRead, StdInWrite);
+		StdInRead = StdInWrite = nullptr;
+	}
+}
+
+void FGitCheckIgnore::CheckIgnoreFilesTimeStamps()
+{
+	// NOTE only the ignore files at the root of the repository are watched; a change in a .gitignore of a subdirectory needs a reconnection
+	const FDateTime NewGitIgnoreTimeStamp = IFileManager::Get().GetTimeStamp(*(RepositoryRoot / TEXT(".gitignore")));
+	const FDateTime NewInfoExcludeTimeStamp = IFileManager::Get().GetTimeStamp(*(RepositoryRoot / TEXT(".git/info/exclude")));
+	if((NewGitIgnoreTimeStamp != GitIgnoreTimeStamp) || (NewInfoExcludeTimeStamp != InfoExcludeTimeStamp))
+	{
+		// git check-ignore reads each ignore file only once, so the process needs to be restarted
+		StopProcess();
+		EmptyCache();
+		bProcessFailed = false;
+		GitIgnoreTimeStamp = NewGitIgnoreTimeStamp;
+		InfoExcludeTimeStamp = NewInfoExcludeTimeStamp;
+	}
+}
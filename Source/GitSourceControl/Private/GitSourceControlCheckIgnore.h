@@ -0,0 +1,79 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "GenericPlatform/GenericPlatformProcess.h"
+
+/**
+ * Answer the "ignored" state of files lazily, only for the files the Editor asks about,
+ * instead of making every "git status" walk ignored trees (Intermediate/, Saved/, DerivedDataCache/...) with "--ignored".
+ *
+ * Keeps one long-running "git check-ignore --stdin -z --verbose --non-matching" process, and caches its answers.
+ * The cache is flushed (and the process restarted) when the .gitignore at the root or the .git/info/exclude file changes.
+ * Thread-safe: queried by the status of worker threads, and by the game thread for the cached answers only.
+ */
+class GITSOURCECONTROL_API FGitCheckIgnore
+{
+public:
+	~FGitCheckIgnore();
+
+	/** Set the Git binary and repository to use; does not start the process yet */
+	void Init(const FString& InPathToGitBinary, const FString& InRepositoryRoot);
+
+	/** Stop the process and flush the cache */
+	void Close();
+
+	/**
+	 * Find which of the provided files are ignored, asking git only for the files not already in the cache.
+	 * @param	InFiles			Absolute filenames, in the repository
+	 * @returns the subset of InFiles that are ignored
+	 */
+	TSet<FString> GetIgnoredFiles(const TArray<FString>& InFiles);
+
+	/**
+	 * Find in the cache if the file is ignored, without running any git command.
+	 * @returns true if the file was found in the cache
+	 */
+	bool FindCached(const FString& InFile, bool& bOutIgnored) const;
+
+private:
+	bool StartProcess();
+	void StopProcess();
+
+	/** Flush the cache and stop the process if any of the ignore files changed since the last query */
+	void CheckIgnoreFilesTimeStamps();
+
+	/** Flush the cache of ignored states */
+	void EmptyCache();
+
+	/** A critical section for the process, held during the I/O with it */
+	FCriticalSection ProcessCriticalSection;
+
+	/** A lock for the cache only, never held during the I/O with the process, so that FindCached() never waits for git */
+	mutable FRWLock CacheLock;
+
+	FString PathToGitBinary;
+	FString RepositoryRoot;
+
+	/** The long-running "git check-ignore" process and its pipes */
+	FProcHandle ProcessHandle;
+	void* StdOutRead = nullptr;
+	void* StdOutWrite = nullptr;
+	void* StdInRead = nullptr;
+	void* StdInWrite = nullptr;
+
+	/** Set if the process failed to start or to answer (ie. Git older than 1.8.2), to avoid trying again at each status */
+	bool bProcessFailed = false;
+
+	/** Ignored state of files, by absolute filename */
+	TMap<FString, bool> IgnoredCache;
+
+	/** Time stamps of the root .gitignore and of .git/info/exclude when the cache was filled */
+	FDateTime GitIgnoreTimeStamp;
+	FDateTime InfoExcludeTimeStamp;
+};
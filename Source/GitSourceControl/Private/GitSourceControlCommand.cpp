@@ -5,18 +5,24 @@
 
 #include "GitSourceControlCommand.h"
 
+#include "HAL/PlatformTime.h"
 #include "Modules/ModuleManager.h"
+#include "ISourceControlModule.h"
 #include "GitSourceControlModule.h"
+#include "GitSourceControlUtils.h"
 
 FGitSourceControlCommand::FGitSourceControlCommand(const TSharedRef<class ISourceControlOperation, ESPMode::ThreadSafe>& InOperation, const TSharedRef<class IGitSourceControlWorker, ESPMode::ThreadSafe>& InWorker, const FSourceControlOperationComplete& InOperationCompleteDelegate)
 	: Operation(InOperation)
 	, Worker(InWorker)
 	, OperationCompleteDelegate(InOperationCompleteDelegate)
-	, bExecuteProcessed(0)
+	, bExecuteStarted(false)
+	, bExecuteProcessed(false)
+	, CompletionQueue(nullptr)
 	, bCommandSuccessful(false)
 	, bConnectionDropped(false)
 	, bAutoDelete(true)
 	, Concurrency(EConcurrency::Synchronous)
+	, NumProcesses(0)
 {
 	// grab the providers settings here, so we don't access them once the worker thread is launched
 	check(IsInGameThread());
@@ -28,15 +34,34 @@ FGitSourceControlCommand::FGitSourceControlCommand(const TSharedRef<class ISourc
 
 bool FGitSourceControlCommand::DoWork()
 {
+	bExecuteStarted = true;
+	SCOPED_NAMED_EVENT_FSTRING(Worker->GetName().ToString(), FColor::Turquoise);
+	SCOPE_CYCLE_COUNTER(STAT_GitExecuteWorker);
+	const FGitScopedWorkerName ScopedWorkerName(Worker->GetName());
+	const int32 NumProcessesBefore = GitSourceControlCore::GetNumProcessesOnThread();
+	const double StartTime = FPlatformTime::Seconds();
 	bCommandSuccessful = Worker->Execute(*this);
-	FPlatformAtomics::InterlockedExchange(&bExecuteProcessed, 1);
+	NumProcesses = GitSourceControlCore::GetNumProcessesOnThread() - NumProcessesBefore;
+	UE_LOG(LogSourceControl, Log, TEXT("%s of %d file(s): %d git process(es) in %.3lfs"), *Worker->GetName().ToString(), Files.Num(), NumProcesses, FPlatformTime::Seconds() - StartTime);
+	const bool bSuccessful = bCommandSuccessful;
+	bExecuteProcessed = true;
 
-	return bCommandSuccessful;
+	// NOTE the game thread can delete the command as soon as it is in the queue
+	if(CompletionQueue != nullptr)
+	{
+		CompletionQueue->Enqueue(this);
+	}
+
+	return bSuccessful;
 }
 
 void FGitSourceControlCommand::Abandon()
 {
-	FPlatformAtomics::InterlockedExchange(&bExecuteProcessed, 1);
+	bExecuteProcessed = true;
+	if(CompletionQueue != nullptr)
+	{
+		CompletionQueue->Enqueue(this);
+	}
 }
 
 void FGitSourceControlCommand::DoThreadedWork()
@@ -61,5 +86,25 @@ ECommandResult::Type FGitSourceControlCommand::ReturnResults()
 	ECommandResult::Type Result = bCommandSuccessful ? ECommandResult::Succeeded : ECommandResult::Failed;
 	OperationCompleteDelegate.ExecuteIfBound(Operation, Result);
 
+	// and the same for each operation joined to this command
+	for (const TPair<FSourceControlOperationRef, FSourceControlOperationComplete>& JoinedOperation : JoinedOperations)
+	{
+		for (const FString& String : InfoMessages)
+		{
+			JoinedOperation.Key->AddInfoMessge(FText::FromString(String));
+		}
+		for (const FString& String : ErrorMessages)
+		{
+			JoinedOperation.Key->AddErrorMessge(FText::FromString(String));
+		}
+		JoinedOperation.Value.ExecuteIfBound(JoinedOperation.Key, Result);
+	}
+
 	return Result;
 }
+
+void FGitSourceControlCommand::JoinOperation(const FSourceControlOperationRef& InOperation, const FSourceControlOperationComplete& InOperationCompleteDelegate)
+{
+	check(IsInGameThread());
+	JoinedOperations.Emplace(InOperation, InOperationCompleteDelegate);
+}
@@ -8,11 +8,19 @@
 #include "CoreMinimal.h"
 #include "ISourceControlProvider.h"
 #include "Misc/IQueuedWork.h"
+#include "Containers/Queue.h"
+
+#include <atomic>
+
+class FGitSourceControlCommand;
+
+/** Queue of the commands completed by the worker threads, drained by the game thread (multiple producers, single consumer) */
+typedef TQueue<FGitSourceControlCommand*, EQueueMode::Mpsc> FGitSourceControlCompletionQueue;
 
 /**
  * Used to execute Git commands multi-threaded.
  */
-class FGitSourceControlCommand : public IQueuedWork
+class GITSOURCECONTROL_API FGitSourceControlCommand : public IQueuedWork
 {
 public:
 
@@ -41,6 +49,9 @@ public:
 	/** Save any results and call any registered callbacks. */
 	ECommandResult::Type ReturnResults();
 
+	/** Attach another operation to this command, so that its completion delegate is also called with the results of this command */
+	void JoinOperation(const FSourceControlOperationRef& InOperation, const FSourceControlOperationComplete& InOperationCompleteDelegate);
+
 public:
 	/** Path to the Git binary */
 	FString PathToGitBinary;
@@ -60,8 +71,17 @@ public:
 	/** Delegate to notify when this operation completes */
 	FSourceControlOperationComplete OperationCompleteDelegate;
 
+	/** Other operations (and their delegates) sharing the results of this command (see FGitSourceControlProvider::QueueStatusRequest()) */
+	TArray<TPair<FSourceControlOperationRef, FSourceControlOperationComplete>> JoinedOperations;
+
+	/**If true, this command has been started by the source control thread (so it cannot be joined anymore)*/
+	std::atomic<bool> bExecuteStarted;
+
 	/**If true, this command has been processed by the source control thread*/
-	volatile int32 bExecuteProcessed;
+	std::atomic<bool> bExecuteProcessed;
+
+	/** Queue where the command pushes itself when processed, to be handed back to the game thread (set when issued) */
+	FGitSourceControlCompletionQueue* CompletionQueue;
 
 	/**If true, the source control command succeeded*/
 	bool bCommandSuccessful;
@@ -81,6 +101,9 @@ public:
 	/** Whether we are running multi-treaded or not*/
 	EConcurrency::Type Concurrency;
 
+	/** Number of git processes launched by the worker, for the log */
+	int32 NumProcesses;
+
 	/** Files to perform this operation on */
 	TArray<FString> Files;
 
@@ -0,0 +1,155 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlConfig.h"
+
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/Paths.h"
+#include "GitSourceControlUtils.h"
+
+/** Normalize the name of a variable: the section and the name are case-insensitive, but the subsection (ie. "origin" in "remote.origin.url") is not */
+static FString NormalizeKey(const FString& InKey)
+{
+	int32 FirstDot = INDEX_NONE;
+	int32 LastDot = INDEX_NONE;
+	if(!InKey.FindChar(TEXT('.'), FirstDot) || !InKey.FindLastChar(TEXT('.'), LastDot) || (FirstDot == LastDot))
+	{
+		return InKey.ToLower();
+	}
+	return InKey.Left(FirstDot).ToLower() + InKey.Mid(FirstDot, LastDot - FirstDot) + InKey.Mid(LastDot).ToLower();
+}
+
+/** Path of the global config file, to notice its creation (Git uses HOME, else the user profile under Windows) */
+static FString GetGlobalConfigFile()
+{
+	FString HomeDir = FPlatformMisc::GetEnvironmentVariable(TEXT("HOME"));
+#if PLATFORM_WINDOWS
+	if(HomeDir.IsEmpty())
+	{
+		HomeDir = FPlatformMisc::GetEnvironmentVariable(TEXT("USERPROFILE"));
+	}
+#endif
+	return HomeDir.IsEmpty() ? FString() : FPaths::Combine(HomeDir, TEXT(".gitconfig"));
+}
+
+/** Apply the "url.<base>.insteadOf" rewrite with the longest matching prefix, like "git remote get-url" does */
+static FString RewriteUrl(const FString& InUrl, const TMap<FString, FString>& InUrlBaseByPrefix)
+{
+	const TPair<FString, FString>* LongestMatch = nullptr;
+	for(const auto& UrlBase : InUrlBaseByPrefix)
+	{
+		if(InUrl.StartsWith(UrlBase.Key, ESearchCase::CaseSensitive) && ((LongestMatch == nullptr) || (UrlBase.Key.Len() > LongestMatch->Key.Len())))
+		{
+			LongestMatch = &UrlBase;
+		}
+	}
+	return LongestMatch ? LongestMatch->Value + InUrl.RightChop(LongestMatch->Key.Len()) : InUrl;
+}
+
+TSharedRef<const FGitConfig, ESPMode::ThreadSafe> FGitConfig::Load(const FString& InPathToGitBinary, const FString& InRepositoryRoot)
+{
+	TSharedRef<FGitConfig, ESPMode::ThreadSafe> Config = MakeShared<FGitConfig, ESPMode::ThreadSafe>();
+
+	// Watch the repository and global config files even if they do not exist yet
+	if(!InRepositoryRoot.IsEmpty())
+	{
+		Config->FileTimeStamps.Add(FPaths::Combine(InRepositoryRoot, TEXT(".git/config")));
+	}
+	const FString GlobalConfigFile = GetGlobalConfigFile();
+	if(!GlobalConfigFile.IsEmpty())
+	{
+		Config->FileTimeStamps.Add(GlobalConfigFile);
+	}
+
+	// NOTE: "-z" would be more robust to values with newlines, but the output of the process is read as a NUL terminated string
+	TArray<FString> InfoMessages;
+	TArray<FString> ErrorMessages;
+	TArray<FString> Parameters;
+	Parameters.Add(TEXT("--list"));
+	Parameters.Add(TEXT("--show-origin"));
+	GitSourceControlCore::RunCommand(TEXT("config"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), InfoMessages, ErrorMessages);
+
+	// URL rewrites "url.<base>.insteadOf=<prefix>", by prefix (a multi-valued variable, so not found in Values)
+	TMap<FString, FString> UrlBaseByPrefix;
+
+	// Each line is "<origin>\t<key>=<value>", like "file:.git/config	user.name=John Doe" ("<key>" alone for a boolean set to true)
+	for(const FString& Line : InfoMessages)
+	{
+		FString Origin;
+		FString Variable;
+		if(!Line.Split(TEXT("\t"), &Origin, &Variable))
+		{
+			continue;
+		}
+
+		if(Origin.RemoveFromStart(TEXT("file:")))
+		{
+			// Origin paths are quoted if they contain special characters, and relative to the repository for the local config
+			Origin.TrimQuotesInline();
+			if(FPaths::IsRelative(Origin) && !InRepositoryRoot.IsEmpty())
+			{
+				Origin = FPaths::Combine(InRepositoryRoot, Origin);
+			}
+			Config->FileTimeStamps.Add(Origin);
+		}
+
+		FString Key;
+		FString Value;
+		if(!Variable.Split(TEXT("="), &Key, &Value))
+		{
+			Key = Variable;
+			Value = TEXT("true");
+		}
+		FString NormalizedKey = NormalizeKey(Key);
+		if(NormalizedKey.StartsWith(TEXT("url."), ESearchCase::CaseSensitive) && NormalizedKey.EndsWith(TEXT(".insteadof"), ESearchCase::CaseSensitive))
+		{
+			// NOTE the base URL is the subsection, which can contain dots itself
+			UrlBaseByPrefix.Add(Value, NormalizedKey.Mid(4, NormalizedKey.Len() - 4 - 10));
+		}
+		Config->Values.Add(MoveTemp(NormalizedKey), MoveTemp(Value));
+	}
+
+	for(auto& FileTimeStamp : Config->FileTimeStamps)
+	{
+		FileTimeStamp.Value = IFileManager::Get().GetTimeStamp(*FileTimeStamp.Key);
+	}
+
+	if(const FString* UserName = Config->FindValue(TEXT("user.name")))
+	{
+		Config->UserName = *UserName;
+	}
+	if(const FString* UserEmail = Config->FindValue(TEXT("user.email")))
+	{
+		Config->UserEmail = *UserEmail;
+	}
+	if(const FString* RemoteUrl = Config->FindValue(TEXT("remote.origin.url")))
+	{
+		Config->RemoteUrl = RewriteUrl(*RemoteUrl, UrlBaseByPrefix);
+	}
+	if(const FString* LfsUrl = Config->FindValue(TEXT("lfs.url")))
+	{
+		Config->LfsUrl = *LfsUrl;
+	}
+
+	return Config;
+}
+
+const FString* FGitConfig::FindValue(const FString& InKey) const
+{
+	return Values.Find(NormalizeKey(InKey));
+}
+
+bool FGitConfig::IsOutdated() const
+{
+	for(const auto& FileTimeStamp : FileTimeStamps)
+	{
+		if(IFileManager::Get().GetTimeStamp(*FileTimeStamp.Key) != FileTimeStamp.Value)
+		{
+			return true;
+		}
+	}
+	return false;
+}
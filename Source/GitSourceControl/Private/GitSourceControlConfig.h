@@ -0,0 +1,53 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Snapshot of the Git config of the repository (including the global and system config),
+ * read by a single "git config --list --show-origin" instead of one "git config <key>" per value.
+ *
+ * Immutable once loaded: a new snapshot is loaded when any of the config files changed (see IsOutdated()).
+ */
+class FGitConfig
+{
+public:
+	/**
+	 * Read the whole config with a single git command
+	 * @param	InPathToGitBinary	The path to the Git binary
+	 * @param	InRepositoryRoot	The Git repository from where to run the command (can be empty, for the global config only)
+	 */
+	static TSharedRef<const FGitConfig, ESPMode::ThreadSafe> Load(const FString& InPathToGitBinary, const FString& InRepositoryRoot);
+
+	/**
+	 * Find the value of a config variable (the last one, ie. the one that takes precedence, if it is set in multiple files)
+	 * @param	InKey		Name of the variable, like "user.name" (the section and the name are case-insensitive, but not the subsection)
+	 */
+	const FString* FindValue(const FString& InKey) const;
+
+	/** Tell if any of the config files changed (or got created) since this snapshot was loaded */
+	bool IsOutdated() const;
+
+	/** Git config user.name (from local repository, else globally) */
+	FString UserName;
+
+	/** Git config user.email (from local repository, else globally) */
+	FString UserEmail;
+
+	/** URL of the "origin" defaut remote server (remote.origin.url, rewritten by any matching url.<base>.insteadOf) */
+	FString RemoteUrl;
+
+	/** URL of the Git LFS server if configured explicitly (lfs.url) */
+	FString LfsUrl;
+
+private:
+	/** Values of all variables, by lowercase name (except the subsection) */
+	TMap<FString, FString> Values;
+
+	/** Time stamps of the config files when loaded, including expected files that did not exist */
+	TMap<FString, FDateTime> FileTimeStamps;
+};
@@ -19,11 +19,30 @@ void FGitSourceControlConsole::Register()
 			FConsoleCommandWithArgsDelegate::CreateRaw(this, &FGitSourceControlConsole::ExecuteGitConsoleCommand)
 		);
 	}
+	if (!CommandMetricsConsoleCommand.IsValid())
+	{
+		CommandMetricsConsoleCommand = MakeUnique<FAutoConsoleCommand>(
+			TEXT("git.CommandMetrics"),
+			TEXT("Log the latency histogram of each git command, and the time spent in git by each worker, from the last thousand git processes.\n")
+			TEXT("Type 'git.CommandMetrics 20' to also log the last 20 processes."),
+			FConsoleCommandWithArgsDelegate::CreateRaw(this, &FGitSourceControlConsole::ExecuteCommandMetricsConsoleCommand)
+		);
+	}
+	if (!StatusMetricsConsoleCommand.IsValid())
+	{
+		StatusMetricsConsoleCommand = MakeUnique<FAutoConsoleCommand>(
+			TEXT("git.StatusMetrics"),
+			TEXT("Log the number and duration of the status commands run in each Git repository (main repository, submodules and nested repositories)."),
+			FConsoleCommandDelegate::CreateRaw(this, &FGitSourceControlConsole::ExecuteStatusMetricsConsoleCommand)
+		);
+	}
 }
 
 void FGitSourceControlConsole::Unregister()
 {
 	GitConsoleCommand.Reset();
+	StatusMetricsConsoleCommand.Reset();
+	CommandMetricsConsoleCommand.Reset();
 }
 
 void FGitSourceControlConsole::ExecuteGitConsoleCommand(const TArray<FString>& a_args)
@@ -48,7 +67,82 @@ void FGitSourceControlConsole::ExecuteGitConsoleCommand(const TArray<FString>& a
 
 	FString Results;
 	FString Errors;
-	GitSourceControlUtils::RunCommandInternalRaw(Command, PathToGitBinary, RepositoryRoot, Parameters, TArray<FString>(), Results, Errors);
+	GitSourceControlCore::RunCommandInternalRaw(Command, PathToGitBinary, RepositoryRoot, Parameters, TArray<FString>(), Results, Errors);
 
 	UE_LOG(LogSourceControl, Log, TEXT("Output:\n%s"), *Results);
 }
+
+void FGitSourceControlConsole::ExecuteStatusMetricsConsoleCommand()
+{
+	const TMap<FString, FGitRepositoryStatusMetrics> Metrics = GitSourceControlUtils::GetRepositoryStatusMetrics();
+	for (const auto& RepositoryMetrics : Metrics)
+	{
+		const FGitRepositoryStatusMetrics& Value = RepositoryMetrics.Value;
+		UE_LOG(LogSourceControl, Log, TEXT("'%s': %d status on %d files, last %.3lfs, max %.3lfs, average %.3lfs"), *RepositoryMetrics.Key,
+			Value.NumStatus, Value.NumFiles, Value.LastDuration, Value.MaxDuration, (Value.NumStatus > 0) ? Value.TotalDuration / Value.NumStatus : 0.0);
+	}
+}
+
+void FGitSourceControlConsole::ExecuteCommandMetricsConsoleCommand(const TArray<FString>& a_args)
+{
+	// Upper bounds of the buckets of the histograms, in milliseconds (the last bucket has no bound)
+	static const double BucketBounds[] = { 10.0, 25.0, 50.0, 100.0, 250.0, 500.0, 1000.0, 2500.0, 5000.0 };
+	static const int32 NumBuckets = UE_ARRAY_COUNT(BucketBounds) + 1;
+
+	const TArray<FGitCommandRecord> Records = GitSourceControlCore::GetCommandRecords();
+
+	// Durations by command, and total duration by worker
+	TMap<FString, TArray<double>> DurationsByCommand;
+	TMap<FName, TPair<int32, double>> DurationByWorker;
+	for (const FGitCommandRecord& Record : Records)
+	{
+		DurationsByCommand.FindOrAdd(Record.Command).Add(Record.Duration * 1000.0);
+		TPair<int32, double>& WorkerDuration = DurationByWorker.FindOrAdd(Record.Worker, TPair<int32, double>(0, 0.0));
+		WorkerDuration.Key++;
+		WorkerDuration.Value += Record.Duration;
+	}
+
+	UE_LOG(LogSourceControl, Log, TEXT("%d git process(es) recorded:"), Records.Num());
+	for (auto& CommandDurations : DurationsByCommand)
+	{
+		TArray<double>& Durations = CommandDurations.Value;
+		Durations.Sort();
+		int32 Buckets[NumBuckets] = {};
+		for (const double Duration : Durations)
+		{
+			int32 Bucket = 0;
+			while ((Bucket < NumBuckets - 1) && (Duration >= BucketBounds[Bucket]))
+			{
+				Bucket++;
+			}
+			Buckets[Bucket]++;
+		}
+		FString Histogram;
+		for (int32 Bucket = 0; Bucket < NumBuckets; Bucket++)
+		{
+			if (Bucket < NumBuckets - 1)
+			{
+				Histogram += FString::Printf(TEXT(" <%.0lfms:%d"), BucketBounds[Bucket], Buckets[Bucket]);
+			}
+			else
+			{
+				Histogram += FString::Printf(TEXT(" >=%.0lfms:%d"), BucketBounds[Bucket - 1], Buckets[Bucket]);
+			}
+		}
+		UE_LOG(LogSourceControl, Log, TEXT("'git %s': %d process(es), median %.1lfms, p95 %.1lfms, max %.1lfms |%s"), *CommandDurations.Key, Durations.Num(),
+			Durations[Durations.Num() / 2], Durations[FMath::Min(Durations.Num() * 95 / 100, Durations.Num() - 1)], Durations.Last(), *Histogram);
+	}
+	for (const auto& WorkerDuration : DurationByWorker)
+	{
+		UE_LOG(LogSourceControl, Log, TEXT("%s: %d process(es) in %.3lfs"), WorkerDuration.Key.IsNone() ? TEXT("(no worker)") : *WorkerDuration.Key.ToString(), WorkerDuration.Value.Key, WorkerDuration.Value.Value);
+	}
+
+	// Optionally, the last processes
+	const int32 NumLastRecords = (a_args.Num() > 0) ? FMath::Clamp(FCString::Atoi(*a_args[0]), 0, Records.Num()) : 0;
+	for (int32 Index = Records.Num() - NumLastRecords; Index < Records.Num(); Index++)
+	{
+		const FGitCommandRecord& Record = Records[Index];
+		UE_LOG(LogSourceControl, Log, TEXT("'git %s' by %s: %.1lfms, ReturnCode=%d, %d/%d output/error char(s)"), *Record.Command, *Record.Worker.ToString(),
+			Record.Duration * 1000.0, Record.ReturnCode, Record.OutputSize, Record.ErrorSize);
+	}
+}
@@ -21,6 +21,18 @@ private:
 	// Git Command Line Interface: Run 'git' commands directly from the Unreal Editor Console.
 	void ExecuteGitConsoleCommand(const TArray<FString>& a_args);
 
+	// Log the metrics of the status commands of each repository (main and nested ones)
+	void ExecuteStatusMetricsConsoleCommand();
+
+	// Log the latency histogram of each git command, and the time spent in git by each worker, from the last processes recorded
+	void ExecuteCommandMetricsConsoleCommand(const TArray<FString>& a_args);
+
 	/** Console command for interacting with 'git' CLI directly */
 	TUniquePtr<FAutoConsoleCommand> GitConsoleCommand;
+
+	/** Console command for the status metrics */
+	TUniquePtr<FAutoConsoleCommand> StatusMetricsConsoleCommand;
+
+	/** Console command for the latencies of the git commands */
+	TUniquePtr<FAutoConsoleCommand> CommandMetricsConsoleCommand;
 };
\ No newline at end of file
@@ -207,7 +207,7 @@ bool FGitSourceControlMenu::StashAwayAnyModifications()
 	TArray<FString> InfoMessages;
 	TArray<FString> ErrorMessages;
 	// Check if there is any modification to the working tree
-	const bool bStatusOk = GitSourceControlUtils::RunCommand(TEXT("status"), PathToGitBinary, PathToRespositoryRoot, ParametersStatus, TArray<FString>(), InfoMessages, ErrorMessages);
+	const bool bStatusOk = GitSourceControlCore::RunCommand(TEXT("status"), PathToGitBinary, PathToRespositoryRoot, ParametersStatus, TArray<FString>(), InfoMessages, ErrorMessages);
 	if ((bStatusOk) && (InfoMessages.Num() > 0))
 	{
 		// Ask the user before stashing
@@ -216,7 +216,7 @@ bool FGitSourceControlMenu::StashAwayAnyModifications()
 		if (Choice == EAppReturnType::Ok)
 		{
 			const TArray<FString> ParametersStash{ "save \"Stashed by Unreal Engine Git Plugin\"" };
-			bStashMadeBeforeSync = GitSourceControlUtils::RunCommand(TEXT("stash"), PathToGitBinary, PathToRespositoryRoot, ParametersStash, TArray<FString>(), InfoMessages, ErrorMessages);
+			bStashMadeBeforeSync = GitSourceControlCore::RunCommand(TEXT("stash"), PathToGitBinary, PathToRespositoryRoot, ParametersStash, TArray<FString>(), InfoMessages, ErrorMessages);
 			if (!bStashMadeBeforeSync)
 			{
 				FMessageLog SourceControlLog("SourceControl");
@@ -245,7 +245,7 @@ void FGitSourceControlMenu::ReApplyStashedModifications()
 		const TArray<FString> ParametersStash{ "pop" };
 		TArray<FString> InfoMessages;
 		TArray<FString> ErrorMessages;
-		const bool bUnstashOk = GitSourceControlUtils::RunCommand(TEXT("stash"), PathToGitBinary, PathToRespositoryRoot, ParametersStash, TArray<FString>(), InfoMessages, ErrorMessages);
+		const bool bUnstashOk = GitSourceControlCore::RunCommand(TEXT("stash"), PathToGitBinary, PathToRespositoryRoot, ParametersStash, TArray<FString>(), InfoMessages, ErrorMessages);
 		if (!bUnstashOk)
 		{
 			FMessageLog SourceControlLog("SourceControl");
@@ -287,12 +287,12 @@ void FGitSourceControlMenu::SyncClicked()
 				Parameters.Add(DiffOrigin);
 
 				// Get changed files remote and on local commits (we need to determine which ones are local commits)
-				GitSourceControlUtils::RunCommand(TEXT("diff"), PathToGitBinary, PathToRepositoryRoot, Parameters, TArray<FString>(), ChangedFiles, ErrorMessages);
+				GitSourceControlCore::RunCommand(TEXT("diff"), PathToGitBinary, PathToRepositoryRoot, Parameters, TArray<FString>(), ChangedFiles, ErrorMessages);
 
 				// Handle uncommitted changes
 				TArray<FString> LocalChangedFiles;
 				const TArray<FString> ParametersStatus{"--porcelain --untracked-files=no"};
-				GitSourceControlUtils::RunCommand(TEXT("status"), PathToGitBinary, PathToRepositoryRoot, ParametersStatus, TArray<FString>(), LocalChangedFiles, ErrorMessages);
+				GitSourceControlCore::RunCommand(TEXT("status"), PathToGitBinary, PathToRepositoryRoot, ParametersStatus, TArray<FString>(), LocalChangedFiles, ErrorMessages);
 
 				for(FString& Filename: LocalChangedFiles)
 				{
@@ -322,7 +322,7 @@ void FGitSourceControlMenu::SyncClicked()
 			const bool bStashed = StashAwayAnyModifications();
 			if (bStashed)
 			{
-				TSharedRef<FSync, ESPMode::ThreadSafe> SyncOperation = ISourceControlOperation::Create<FSync>();
+				TSharedRef<FGitSyncAll, ESPMode::ThreadSafe> SyncOperation = ISourceControlOperation::Create<FGitSyncAll>();
 #if ENGINE_MAJOR_VERSION == 5
 				const ECommandResult::Type Result = Provider.Execute(SyncOperation, FSourceControlChangelistPtr(), TArray<FString>(), EConcurrency::Asynchronous, FSourceControlOperationComplete::CreateRaw(this, &FGitSourceControlMenu::OnSourceControlOperationComplete));
 #else
@@ -533,7 +533,27 @@ void FGitSourceControlMenu::OnSourceControlOperationComplete(const FSourceContro
 {
 	RemoveInProgressNotification();
 
-	if ((InOperation->GetName() == "Sync") || (InOperation->GetName() == "Revert"))
+	if ((InOperation->GetName() == "SyncAll") && (InResult == ECommandResult::Succeeded))
+	{
+		// Unstash any modifications if a stash was made at the beginning of the Sync operation
+		ReApplyStashedModifications();
+		// Reload only the loaded packages of the files actually changed by the Sync (the other packages unlinked at the beginning are still up to date in memory)
+		TArray<UPackage*> ChangedPackages;
+		for (const FString& ChangedFile : StaticCastSharedRef<FGitSyncAll>(InOperation)->ChangedFiles)
+		{
+			FString PackageName;
+			if (FPackageName::TryConvertFilenameToLongPackageName(ChangedFile, PackageName))
+			{
+				if (UPackage* Package = FindPackage(nullptr, *PackageName))
+				{
+					ChangedPackages.AddUnique(Package);
+				}
+			}
+		}
+		ReloadPackages(ChangedPackages);
+		PackagesToReload.Empty();
+	}
+	else if ((InOperation->GetName() == "Sync") || (InOperation->GetName() == "SyncAll") || (InOperation->GetName() == "Revert"))
 	{
 		// Unstash any modifications if a stash was made at the beginning of the Sync operation
 		ReApplyStashedModifications();
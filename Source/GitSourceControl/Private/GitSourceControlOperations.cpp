@@ -5,18 +5,37 @@
 
 #include "GitSourceControlOperations.h"
 
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
 #include "Misc/Paths.h"
 #include "Modules/ModuleManager.h"
 #include "SourceControlOperations.h"
 #include "ISourceControlModule.h"
 #include "GitSourceControlModule.h"
 #include "GitSourceControlCommand.h"
+#include "GitSourceControlLockClient.h"
 #include "GitSourceControlUtils.h"
 #include "Logging/MessageLog.h"
 #include "Misc/MessageDialog.h"
 
+#if PLATFORM_MAC || PLATFORM_LINUX
+#include <sys/stat.h>
+#endif
+
 #define LOCTEXT_NAMESPACE "GitSourceControl"
 
+namespace GitSourceControlConstants
+{
+	/** Age in seconds under which a lock confirmed by a status is trusted, so that CheckOut does not lock the file again */
+	const double MaxCachedLockAge = 60.0;
+
+	/** Age in seconds under which a state of an unchanged file is trusted without running git, when locks can change on the server */
+	const double MaxCachedLfsStateAge = 60.0;
+
+	/** Age in seconds of the last fetch above which CheckOut reports that it cannot tell reliably if the files are current */
+	const double MaxFetchAge = 3600.0;
+}
+
 FName FGitPush::GetName() const
 {
 	return "Push";
@@ -28,6 +47,11 @@ FText FGitPush::GetInProgressString() const
 	return LOCTEXT("SourceControl_Push", "Pushing local commits to remote origin...");
 }
 
+FName FGitSyncAll::GetName() const
+{
+	return "SyncAll";
+}
+
 
 FName FGitConnectWorker::GetName() const
 {
@@ -42,12 +66,13 @@ bool FGitConnectWorker::Execute(FGitSourceControlCommand& InCommand)
 	// Check Git Availability
 	if((InCommand.PathToGitBinary.Len() > 0) && GitSourceControlUtils::CheckGitAvailability(InCommand.PathToGitBinary))
 	{
-		// Now update the status of assets in Content/ directory and also Config files
-		TArray<FString> ProjectDirs;
-		ProjectDirs.Add(FPaths::ConvertRelativePathToFull(FPaths::ProjectContentDir()));
-		ProjectDirs.Add(FPaths::ConvertRelativePathToFull(FPaths::ProjectConfigDir()));
-		InCommand.bCommandSuccessful = GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, ProjectDirs, InCommand.ErrorMessages, States);
-		if(!InCommand.bCommandSuccessful || InCommand.ErrorMessages.Num() > 0)
+		// Only validate the repository: the status of Content/ and Config/ is then scanned in the background by the provider,
+		// and the LFS lock server is checked by a separate probe, so that source control is available as soon as possible
+		TArray<FString> InfoMessages;
+		TArray<FString> Parameters;
+		Parameters.Add(TEXT("--is-inside-work-tree"));
+		InCommand.bCommandSuccessful = GitSourceControlCore::RunCommand(TEXT("rev-parse"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Parameters, TArray<FString>(), InfoMessages, InCommand.ErrorMessages);
+		if(!InCommand.bCommandSuccessful || (InfoMessages.Num() == 0) || (InfoMessages[0] != TEXT("true")))
 		{
 			Operation->SetErrorText(LOCTEXT("NotAGitRepository", "Failed to enable Git source control. You need to initialize the project as a Git repository first."));
 			InCommand.bCommandSuccessful = false;
@@ -55,12 +80,6 @@ bool FGitConnectWorker::Execute(FGitSourceControlCommand& InCommand)
 		else
 		{
 			GitSourceControlUtils::GetCommitInfo(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.CommitId, InCommand.CommitSummary);
-
-			if(InCommand.bUsingGitLfsLocking)
-			{
-				// Check server connection by checking lock status (when using Git LFS file Locking worflow)
-				InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommand(TEXT("lfs locks"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), TArray<FString>(), InCommand.InfoMessages, InCommand.ErrorMessages);
-			}
 		}
 	}
 	else
@@ -72,9 +91,42 @@ bool FGitConnectWorker::Execute(FGitSourceControlCommand& InCommand)
 	return InCommand.bCommandSuccessful;
 }
 
-bool FGitConnectWorker::UpdateStates() const
+bool FGitConnectWorker::UpdateStates()
 {
-	return GitSourceControlUtils::UpdateCachedStates(States);
+	// No state: the content is scanned afterward, see FGitSourceControlProvider::QueueContentScan()
+	return false;
+}
+
+/**
+ * Derive the states of files after a successful operation from their cached states, instead of running a status on them.
+ * @param	InFiles				Files of the operation
+ * @param	InDeriveState		Update a copy of the cached state of a file to its state after the operation, or return false if it cannot tell
+ * @param	OutStates			Populated with the derived states
+ * @returns the files whose state could not be derived, which still need a status
+ */
+static TArray<FString> DeriveStates(const TArray<FString>& InFiles, TFunctionRef<bool(FGitSourceControlState&)> InDeriveState, TArray<FGitSourceControlState>& OutStates)
+{
+	// Use a snapshot of the cache, since this is called from a worker thread
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	TArray<FGitSourceControlState> CachedStates = GitSourceControl.GetProvider().GetCachedStates(InFiles);
+
+	TArray<FString> FilesToUpdate;
+	const FDateTime Now = FDateTime::Now();
+	for(FGitSourceControlState& State : CachedStates)
+	{
+		if(InDeriveState(State))
+		{
+			State.bStale = false;
+			State.Fingerprint = FGitFileFingerprint();
+			State.TimeStamp = Now;
+			OutStates.Add(MoveTemp(State));
+		}
+		else
+		{
+			FilesToUpdate.Add(State.LocalFilename);
+		}
+	}
+	return FilesToUpdate;
 }
 
 FName FGitCheckOutWorker::GetName() const
@@ -89,17 +141,88 @@ bool FGitCheckOutWorker::Execute(FGitSourceControlCommand& InCommand)
 	if(InCommand.bUsingGitLfsLocking)
 	{
 		// lock files: execute the LFS command on relative filenames
+		// (skip the files that the cache recently confirmed to be already locked by us, to save a round trip to the LFS server,
+		// but not the ones only marked as locked by an optimistic CheckOut, which are stale until confirmed)
+		FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+		const TArray<FGitSourceControlState> CachedStates = GitSourceControl.GetProvider().GetCachedStates(InCommand.Files);
+		const FDateTime FreshLimit = FDateTime::Now() - FTimespan::FromSeconds(GitSourceControlConstants::MaxCachedLockAge);
+		TArray<FString> FilesToLock;
+		TSet<FString> ConfirmedLockedFiles;
+		for(const auto& State : CachedStates)
+		{
+			if((State.LockState != ELockState::Locked) || State.bStale || (State.TimeStamp < FreshLimit))
+			{
+				FilesToLock.Add(State.LocalFilename);
+			}
+			else
+			{
+				ConfirmedLockedFiles.Add(State.LocalFilename);
+			}
+		}
+
 		InCommand.bCommandSuccessful = true;
-		const TArray<FString> RelativeFiles = GitSourceControlUtils::RelativeFilenames(InCommand.Files, InCommand.PathToRepositoryRoot);
-		for(const auto& RelativeFile : RelativeFiles)
+
+		// Warn before locking a file that has a newer version on the server, else the changes will have to be redone after the next pull
+		// (from the files changed upstream as of the last fetch: no network round trip, and only a few file stats once cached)
+		const double StartTime = FPlatformTime::Seconds();
+		TArray<FString> OutdatedFiles;
+		FDateTime LastFetchTime;
+		const bool bCacheHit = GitSourceControlUtils::GetNewerFilesOnServer(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, FilesToLock, OutdatedFiles, LastFetchTime);
+		UE_LOG(LogSourceControl, Log, TEXT("CheckOut: checked that %d file(s) are current in %.3lfms (cache %s)"), FilesToLock.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0, bCacheHit ? TEXT("hit") : TEXT("miss"));
+		if((LastFetchTime != FDateTime::MinValue()) && ((FDateTime::Now() - LastFetchTime).GetTotalSeconds() > GitSourceControlConstants::MaxFetchAge))
 		{
-			TArray<FString> OneFile;
-			OneFile.Add(RelativeFile);
-			InCommand.bCommandSuccessful &= GitSourceControlUtils::RunCommand(TEXT("lfs lock"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), OneFile, InCommand.InfoMessages, InCommand.ErrorMessages);
+			UE_LOG(LogSourceControl, Log, TEXT("CheckOut: the last fetch is %d minutes old, newer versions on the server might not be known"), (int32)(FDateTime::Now() - LastFetchTime).GetTotalMinutes());
+		}
+		if(OutdatedFiles.Num() > 0)
+		{
+			const bool bRefuseOutdated = GitSourceControl.AccessSettings().IsRefuseOutdatedCheckOutEnabled();
+			for(const FString& OutdatedFile : OutdatedFiles)
+			{
+				InCommand.ErrorMessages.Add(FString::Printf(bRefuseOutdated ? TEXT("'%s' not checked out: there is a newer version on the server, Sync first") : TEXT("'%s' has a newer version on the server: Sync it before editing it"), *OutdatedFile));
+			}
+			if(bRefuseOutdated)
+			{
+				FilesToLock.RemoveAll([&OutdatedFiles](const FString& File) { return OutdatedFiles.Contains(File); });
+				InCommand.bCommandSuccessful = false;
+			}
+		}
+
+		const TArray<FString> RelativeFiles = GitSourceControlUtils::RelativeFilenames(FilesToLock, InCommand.PathToRepositoryRoot);
+		for(int32 Index = 0; Index < RelativeFiles.Num(); Index++)
+		{
+			if(GitSourceControlCore::LockFile(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, RelativeFiles[Index], InCommand.InfoMessages, InCommand.ErrorMessages))
+			{
+				LockedFiles.Add(FilesToLock[Index]);
+			}
+			else
+			{
+				InCommand.bCommandSuccessful = false;
+			}
 		}
 
-		// now update the status of our files
-		GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, InCommand.Files, InCommand.ErrorMessages, States);
+		// now update the states of our files: locked by us if the lock succeeded, and a status for the files whose lock failed
+		// (probably locked by someone else) or was refused as outdated, since their cached state can be the one of an optimistic CheckOut
+		const FString LfsUserName = GitSourceControl.AccessSettings().GetLfsUserName();
+		const TArray<FString> FilesToUpdate = DeriveStates(InCommand.Files, [&](FGitSourceControlState& State)
+		{
+			if(LockedFiles.Contains(State.LocalFilename))
+			{
+				State.LockState = ELockState::Locked;
+				State.LockUser = LfsUserName;
+				return true;
+			}
+			// not locked by this command: only keep a lock of ours confirmed recently (not a stale one, marked by an optimistic CheckOut)
+			if(ConfirmedLockedFiles.Contains(State.LocalFilename) && (State.LockState == ELockState::Locked) && !State.bStale)
+			{
+				LockedFiles.Add(State.LocalFilename);
+				return true;
+			}
+			return false;
+		}, States);
+		if(FilesToUpdate.Num() > 0)
+		{
+			GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, FilesToUpdate, InCommand.ErrorMessages, States);
+		}
 	}
 	else
 	{
@@ -109,9 +232,9 @@ bool FGitCheckOutWorker::Execute(FGitSourceControlCommand& InCommand)
 	return InCommand.bCommandSuccessful;
 }
 
-bool FGitCheckOutWorker::UpdateStates() const
+bool FGitCheckOutWorker::UpdateStates()
 {
-	return GitSourceControlUtils::UpdateCachedStates(States);
+	return GitSourceControlUtils::UpdateCachedStates(MoveTemp(States));
 }
 
 static FText ParseCommitResults(const TArray<FString>& InResults)
@@ -132,19 +255,26 @@ const TArray<FString> GetLockedFiles(const TArray<FString>& InFiles)
 	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
 	FGitSourceControlProvider& Provider = GitSourceControl.GetProvider();
 
-	TArray<TSharedRef<ISourceControlState, ESPMode::ThreadSafe>> LocalStates;
-	Provider.GetState(InFiles, LocalStates, EStateCacheUsage::Use);
+	// Use a snapshot of the cache, since this is called from a worker thread
+	const TArray<FGitSourceControlState> LocalStates = Provider.GetCachedStates(InFiles);
 	for(const auto& State : LocalStates)
 	{
-		if(State->IsCheckedOut())
+		if(State.IsCheckedOut())
 		{
-			LockedFiles.Add(State->GetFilename());
+			LockedFiles.Add(State.LocalFilename);
 		}
 	}
 
 	return LockedFiles;
 }
 
+/** Unlock files with "git lfs unlock" on batches of relative filenames, instead of one process per file */
+static bool UnlockFiles(FGitSourceControlCommand& InCommand, const TArray<FString>& InFiles)
+{
+	const TArray<FString> RelativeFiles = GitSourceControlUtils::RelativeFilenames(InFiles, InCommand.PathToRepositoryRoot);
+	return GitSourceControlCore::UnlockFiles(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, RelativeFiles, InCommand.InfoMessages, InCommand.ErrorMessages);
+}
+
 FName FGitCheckInWorker::GetName() const
 {
 	return "CheckIn";
@@ -156,6 +286,10 @@ bool FGitCheckInWorker::Execute(FGitSourceControlCommand& InCommand)
 
 	TSharedRef<FCheckIn, ESPMode::ThreadSafe> Operation = StaticCastSharedRef<FCheckIn>(InCommand.Operation);
 
+	bool bCommitted = false;
+	bool bUnlocked = false;
+	bool bUnlockFailed = false;
+
 	// make a temp file to place our commit message in
 	FGitScopedTempFile CommitMsgFile(Operation->GetDescription());
 	if(CommitMsgFile.GetFilename().Len() > 0)
@@ -166,20 +300,20 @@ bool FGitCheckInWorker::Execute(FGitSourceControlCommand& InCommand)
 		ParamCommitMsgFilename += TEXT("\"");
 		Parameters.Add(ParamCommitMsgFilename);
 
-		InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommit(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Parameters, InCommand.Files, InCommand.InfoMessages, InCommand.ErrorMessages);
+		InCommand.bCommandSuccessful = GitSourceControlCore::RunCommit(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Parameters, InCommand.Files, InCommand.InfoMessages, InCommand.ErrorMessages);
+		bCommitted = InCommand.bCommandSuccessful;
 		if(InCommand.bCommandSuccessful)
 		{
-			// Remove any deleted files from status cache
+			// Remove any deleted files from status cache (from the game thread, in UpdateStates())
 			FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
 			FGitSourceControlProvider& Provider = GitSourceControl.GetProvider();
 
-			TArray<TSharedRef<ISourceControlState, ESPMode::ThreadSafe>> LocalStates;
-			Provider.GetState(InCommand.Files, LocalStates, EStateCacheUsage::Use);
+			const TArray<FGitSourceControlState> LocalStates = Provider.GetCachedStates(InCommand.Files);
 			for(const auto& State : LocalStates)
 			{
-				if(State->IsDeleted())
+				if(State.IsDeleted())
 				{
-					Provider.RemoveFileFromCache(State->GetFilename());
+					DeletedFiles.Add(State.LocalFilename);
 				}
 			}
 
@@ -196,7 +330,7 @@ bool FGitCheckInWorker::Execute(FGitSourceControlCommand& InCommand)
                 // TODO Configure origin
                 Parameters2.Add(TEXT("origin"));
                 Parameters2.Add(TEXT("HEAD"));
-				InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommand(TEXT("push"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Parameters2, TArray<FString>(), InCommand.InfoMessages, InCommand.ErrorMessages);
+				InCommand.bCommandSuccessful = GitSourceControlCore::RunCommand(TEXT("push"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Parameters2, TArray<FString>(), InCommand.InfoMessages, InCommand.ErrorMessages);
 				if(!InCommand.bCommandSuccessful)
 				{
 					// if out of date, pull first, then try again
@@ -232,29 +366,50 @@ bool FGitCheckInWorker::Execute(FGitSourceControlCommand& InCommand)
 					const TArray<FString> LockedFiles = GetLockedFiles(InCommand.Files);
 					if(LockedFiles.Num() > 0)
 					{
-						const TArray<FString> RelativeFiles = GitSourceControlUtils::RelativeFilenames(LockedFiles, InCommand.PathToRepositoryRoot);
-						for(const auto& RelativeFile : RelativeFiles)
-						{
-							TArray<FString> OneFile;
-							OneFile.Add(RelativeFile);
-							GitSourceControlUtils::RunCommand(TEXT("lfs unlock"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), OneFile, InCommand.InfoMessages, InCommand.ErrorMessages);
-						}
+						bUnlocked = UnlockFiles(InCommand, LockedFiles);
+						bUnlockFailed = !bUnlocked;
 					}
 				}
 			}
 		}
 	}
 
-	// now update the status of our files
-	GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, InCommand.Files, InCommand.ErrorMessages, States);
+	// now update the states of our files: committed files are unchanged (and unlocked if the unlock succeeded), and deleted ones are removed from the cache
+	TArray<FString> FilesToUpdate = InCommand.Files;
+	if(bCommitted && !bUnlockFailed)
+	{
+		TArray<FString> CommittedFiles = InCommand.Files;
+		CommittedFiles.RemoveAll([this](const FString& File) { return DeletedFiles.Contains(File); });
+		FilesToUpdate = DeriveStates(CommittedFiles, [bUnlocked](FGitSourceControlState& State)
+		{
+			State.WorkingCopyState = EWorkingCopyState::Unchanged;
+			if(bUnlocked)
+			{
+				State.LockState = ELockState::NotLocked;
+				State.LockUser.Empty();
+			}
+			return true;
+		}, States);
+	}
+	if(FilesToUpdate.Num() > 0)
+	{
+		GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, FilesToUpdate, InCommand.ErrorMessages, States);
+	}
 	GitSourceControlUtils::GetCommitInfo(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.CommitId, InCommand.CommitSummary);
 
 	return InCommand.bCommandSuccessful;
 }
 
-bool FGitCheckInWorker::UpdateStates() const
+bool FGitCheckInWorker::UpdateStates()
 {
-	return GitSourceControlUtils::UpdateCachedStates(States);
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	FGitSourceControlProvider& Provider = GitSourceControl.GetProvider();
+	for(const FString& DeletedFile : DeletedFiles)
+	{
+		Provider.RemoveFileFromCache(DeletedFile);
+	}
+
+	return GitSourceControlUtils::UpdateCachedStates(MoveTemp(States));
 }
 
 FName FGitMarkForAddWorker::GetName() const
@@ -266,17 +421,32 @@ bool FGitMarkForAddWorker::Execute(FGitSourceControlCommand& InCommand)
 {
 	check(InCommand.Operation->GetName() == GetName());
 
-	InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommand(TEXT("add"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), InCommand.Files, InCommand.InfoMessages, InCommand.ErrorMessages);
+	InCommand.bCommandSuccessful = GitSourceControlCore::RunCommand(TEXT("add"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), InCommand.Files, InCommand.InfoMessages, InCommand.ErrorMessages);
 
-	// now update the status of our files
-	GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, InCommand.Files, InCommand.ErrorMessages, States);
+	// now update the states of our files: untracked files are now added, and added or modified ones keep their state
+	TArray<FString> FilesToUpdate = InCommand.Files;
+	if(InCommand.bCommandSuccessful)
+	{
+		FilesToUpdate = DeriveStates(InCommand.Files, [](FGitSourceControlState& State)
+		{
+			if(State.WorkingCopyState == EWorkingCopyState::NotControlled)
+			{
+				State.WorkingCopyState = EWorkingCopyState::Added;
+			}
+			return (State.WorkingCopyState == EWorkingCopyState::Added) || (State.WorkingCopyState == EWorkingCopyState::Modified);
+		}, States);
+	}
+	if(FilesToUpdate.Num() > 0)
+	{
+		GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, FilesToUpdate, InCommand.ErrorMessages, States);
+	}
 
 	return InCommand.bCommandSuccessful;
 }
 
-bool FGitMarkForAddWorker::UpdateStates() const
+bool FGitMarkForAddWorker::UpdateStates()
 {
-	return GitSourceControlUtils::UpdateCachedStates(States);
+	return GitSourceControlUtils::UpdateCachedStates(MoveTemp(States));
 }
 
 FName FGitDeleteWorker::GetName() const
@@ -288,17 +458,30 @@ bool FGitDeleteWorker::Execute(FGitSourceControlCommand& InCommand)
 {
 	check(InCommand.Operation->GetName() == GetName());
 
-	InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommand(TEXT("rm"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), InCommand.Files, InCommand.InfoMessages, InCommand.ErrorMessages);
+	InCommand.bCommandSuccessful = GitSourceControlCore::RunCommand(TEXT("rm"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), InCommand.Files, InCommand.InfoMessages, InCommand.ErrorMessages);
 
-	// now update the status of our files
-	GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, InCommand.Files, InCommand.ErrorMessages, States);
+	// now update the states of our files: tracked files are now deleted (and keep their lock until committed)
+	TArray<FString> FilesToUpdate = InCommand.Files;
+	if(InCommand.bCommandSuccessful)
+	{
+		FilesToUpdate = DeriveStates(InCommand.Files, [](FGitSourceControlState& State)
+		{
+			const bool bTracked = (State.WorkingCopyState == EWorkingCopyState::Unchanged) || (State.WorkingCopyState == EWorkingCopyState::Deleted) || (State.WorkingCopyState == EWorkingCopyState::Missing);
+			State.WorkingCopyState = EWorkingCopyState::Deleted;
+			return bTracked;
+		}, States);
+	}
+	if(FilesToUpdate.Num() > 0)
+	{
+		GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, FilesToUpdate, InCommand.ErrorMessages, States);
+	}
 
 	return InCommand.bCommandSuccessful;
 }
 
-bool FGitDeleteWorker::UpdateStates() const
+bool FGitDeleteWorker::UpdateStates()
 {
-	return GitSourceControlUtils::UpdateCachedStates(States);
+	return GitSourceControlUtils::UpdateCachedStates(MoveTemp(States));
 }
 
 
@@ -308,33 +491,31 @@ void GetMissingVsExistingFiles(const TArray<FString>& InFiles, TArray<FString>&
 	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
 	FGitSourceControlProvider& Provider = GitSourceControl.GetProvider();
 
-	const TArray<FString> Files = (InFiles.Num() > 0) ? (InFiles) : (Provider.GetFilesInCache());
-
-	TArray<TSharedRef<ISourceControlState, ESPMode::ThreadSafe>> LocalStates;
-	Provider.GetState(Files, LocalStates, EStateCacheUsage::Use);
+	// Use a snapshot of the cache (of all the files in it if none is specified), since this is called from a worker thread
+	const TArray<FGitSourceControlState> LocalStates = Provider.GetCachedStates(InFiles);
 	for(const auto& State : LocalStates)
 	{
-		if(FPaths::FileExists(State->GetFilename()))
+		if(FPaths::FileExists(State.LocalFilename))
 		{
-			if(State->IsAdded())
+			if(State.IsAdded())
 			{
-				OutAllExistingFiles.Add(State->GetFilename());
+				OutAllExistingFiles.Add(State.LocalFilename);
 			}
-			else if(State->IsModified())
+			else if(State.IsModified())
 			{
-				OutOtherThanAddedExistingFiles.Add(State->GetFilename());
-				OutAllExistingFiles.Add(State->GetFilename());
+				OutOtherThanAddedExistingFiles.Add(State.LocalFilename);
+				OutAllExistingFiles.Add(State.LocalFilename);
 			}
-			else if(State->CanRevert()) // for locked but unmodified files
+			else if(State.CanRevert()) // for locked but unmodified files
 			{
-				OutOtherThanAddedExistingFiles.Add(State->GetFilename());
+				OutOtherThanAddedExistingFiles.Add(State.LocalFilename);
 			}
 		}
 		else
 		{
-			if (State->IsSourceControlled())
+			if (State.IsSourceControlled())
 			{
-				OutMissingFiles.Add(State->GetFilename());
+				OutMissingFiles.Add(State.LocalFilename);
 			}
 		}
 	}
@@ -347,6 +528,12 @@ FName FGitRevertWorker::GetName() const
 
 bool FGitRevertWorker::Execute(FGitSourceControlCommand& InCommand)
 {
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	if(GitSourceControl.GetProvider().GetGitVersion().bHasRestore)
+	{
+		return ExecuteRestore(InCommand);
+	}
+
 	// Filter files by status to use the right "revert" commands on them
 	TArray<FString> MissingFiles;
 	TArray<FString> AllExistingFiles;
@@ -357,17 +544,17 @@ bool FGitRevertWorker::Execute(FGitSourceControlCommand& InCommand)
 	if(MissingFiles.Num() > 0)
 	{
 		// "Added" files that have been deleted needs to be removed from source control
-		InCommand.bCommandSuccessful &= GitSourceControlUtils::RunCommand(TEXT("rm"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), MissingFiles, InCommand.InfoMessages, InCommand.ErrorMessages);
+		InCommand.bCommandSuccessful &= GitSourceControlCore::RunCommand(TEXT("rm"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), MissingFiles, InCommand.InfoMessages, InCommand.ErrorMessages);
 	}
 	if(AllExistingFiles.Num() > 0)
 	{
 		// reset any changes already added to the index
-		InCommand.bCommandSuccessful &= GitSourceControlUtils::RunCommand(TEXT("reset"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), AllExistingFiles, InCommand.InfoMessages, InCommand.ErrorMessages);
+		InCommand.bCommandSuccessful &= GitSourceControlCore::RunCommand(TEXT("reset"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), AllExistingFiles, InCommand.InfoMessages, InCommand.ErrorMessages);
 	}
 	if(OtherThanAddedExistingFiles.Num() > 0)
 	{
 		// revert any changes in working copy (this would fails if the asset was in "Added" state, since after "reset" it is now "untracked")
-		InCommand.bCommandSuccessful &= GitSourceControlUtils::RunCommand(TEXT("checkout"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), OtherThanAddedExistingFiles, InCommand.InfoMessages, InCommand.ErrorMessages);
+		InCommand.bCommandSuccessful &= GitSourceControlCore::RunCommand(TEXT("checkout"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), OtherThanAddedExistingFiles, InCommand.InfoMessages, InCommand.ErrorMessages);
 	}
 
 	if(InCommand.bUsingGitLfsLocking)
@@ -377,13 +564,7 @@ bool FGitRevertWorker::Execute(FGitSourceControlCommand& InCommand)
 		const TArray<FString> LockedFiles = GetLockedFiles(OtherThanAddedExistingFiles);
 		if(LockedFiles.Num() > 0)
 		{
-			const TArray<FString> RelativeFiles = GitSourceControlUtils::RelativeFilenames(LockedFiles, InCommand.PathToRepositoryRoot);
-			for(const auto& RelativeFile : RelativeFiles)
-			{
-				TArray<FString> OneFile;
-				OneFile.Add(RelativeFile);
-				GitSourceControlUtils::RunCommand(TEXT("lfs unlock"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), OneFile, InCommand.InfoMessages, InCommand.ErrorMessages);
-			}
+			UnlockFiles(InCommand, LockedFiles);
 		}
 	}
 
@@ -403,9 +584,114 @@ bool FGitRevertWorker::Execute(FGitSourceControlCommand& InCommand)
 	return InCommand.bCommandSuccessful;
 }
 
-bool FGitRevertWorker::UpdateStates() const
+bool FGitRevertWorker::ExecuteRestore(FGitSourceControlCommand& InCommand)
+{
+	// Plan the revert from a snapshot of the cached states (of all the files in it if none is specified)
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	const TArray<FGitSourceControlState> CachedStates = GitSourceControl.GetProvider().GetCachedStates(InCommand.Files);
+	TArray<FString> FilesToUnstage;	// Added (or renamed/copied) files: only removed from the index, the files themselves are kept (as untracked)
+	TArray<FString> FilesToRestore;	// Modified, deleted or conflicted files: restored from HEAD, both in the index and in the working copy
+	TArray<FString> FilesToUnlock;
+	TArray<FString> FilesToRescan;	// Files whose state after the revert cannot be told from the plan
+	for(const FGitSourceControlState& State : CachedStates)
+	{
+		switch(State.WorkingCopyState)
+		{
+		case EWorkingCopyState::Added:
+			FilesToUnstage.Add(State.LocalFilename);
+			break;
+		case EWorkingCopyState::Renamed:
+		case EWorkingCopyState::Copied:
+			FilesToUnstage.Add(State.LocalFilename);
+			FilesToRescan.Add(State.LocalFilename);
+			break;
+		case EWorkingCopyState::Modified:
+		case EWorkingCopyState::Deleted:
+		case EWorkingCopyState::Missing:
+			FilesToRestore.Add(State.LocalFilename);
+			break;
+		case EWorkingCopyState::Conflicted:
+			FilesToRestore.Add(State.LocalFilename);
+			FilesToRescan.Add(State.LocalFilename);
+			break;
+		default:
+			break;
+		}
+		// unlock only locked files, that is, not Added files
+		if(InCommand.bUsingGitLfsLocking && State.IsCheckedOut() && !State.IsAdded())
+		{
+			FilesToUnlock.Add(State.LocalFilename);
+		}
+	}
+
+	// At most two passes of "git restore" (by batches of files), instead of "rm", "reset" and "checkout"
+	InCommand.bCommandSuccessful = true;
+	if(FilesToUnstage.Num() > 0)
+	{
+		TArray<FString> Parameters;
+		Parameters.Add(TEXT("--staged"));
+		Parameters.Add(TEXT("--"));
+		InCommand.bCommandSuccessful &= GitSourceControlCore::RunCommand(TEXT("restore"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Parameters, FilesToUnstage, InCommand.InfoMessages, InCommand.ErrorMessages);
+	}
+	if(FilesToRestore.Num() > 0)
+	{
+		TArray<FString> Parameters;
+		Parameters.Add(TEXT("--staged"));
+		Parameters.Add(TEXT("--worktree"));
+		Parameters.Add(TEXT("--"));
+		InCommand.bCommandSuccessful &= GitSourceControlCore::RunCommand(TEXT("restore"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Parameters, FilesToRestore, InCommand.InfoMessages, InCommand.ErrorMessages);
+	}
+	bool bUnlocked = true;
+	if(FilesToUnlock.Num() > 0)
+	{
+		bUnlocked = UnlockFiles(InCommand, FilesToUnlock);
+	}
+
+	if(!InCommand.bCommandSuccessful || !bUnlocked)
+	{
+		// Something went wrong: the outcome is not known, so update the status of all the files
+		TArray<FString> FilesToUpdate;
+		for(const FGitSourceControlState& State : CachedStates)
+		{
+			FilesToUpdate.Add(State.LocalFilename);
+		}
+		GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, FilesToUpdate, InCommand.ErrorMessages, States);
+		return InCommand.bCommandSuccessful;
+	}
+
+	// Derive the states after the revert from the plan, and only update the status of the few files it cannot tell
+	const FDateTime Now = FDateTime::Now();
+	for(const FGitSourceControlState& CachedState : CachedStates)
+	{
+		if(FilesToRescan.Contains(CachedState.LocalFilename))
+		{
+			continue;
+		}
+		const bool bUnstaged = FilesToUnstage.Contains(CachedState.LocalFilename);
+		const bool bRestored = FilesToRestore.Contains(CachedState.LocalFilename);
+		const bool bUnlockedFile = FilesToUnlock.Contains(CachedState.LocalFilename);
+		if(!bUnstaged && !bRestored && !bUnlockedFile)
+		{
+			continue;
+		}
+		FGitSourceControlState& State = States.Emplace_GetRef(CachedState.LocalFilename, CachedState.bUsingGitLfsLocking);
+		State.WorkingCopyState = bUnstaged ? EWorkingCopyState::NotControlled : (bRestored ? EWorkingCopyState::Unchanged : CachedState.WorkingCopyState);
+		State.LockState = bUnlockedFile ? ELockState::NotLocked : CachedState.LockState;
+		State.LockUser = bUnlockedFile ? FString() : CachedState.LockUser;
+		State.bNewerVersionOnServer = CachedState.bNewerVersionOnServer;
+		State.TimeStamp = Now;
+	}
+	if(FilesToRescan.Num() > 0)
+	{
+		GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, FilesToRescan, InCommand.ErrorMessages, States);
+	}
+
+	return InCommand.bCommandSuccessful;
+}
+
+bool FGitRevertWorker::UpdateStates()
 {
-	return GitSourceControlUtils::UpdateCachedStates(States);
+	return GitSourceControlUtils::UpdateCachedStates(MoveTemp(States));
 }
 
 FName FGitSyncWorker::GetName() const
@@ -415,6 +701,11 @@ FName FGitSyncWorker::GetName() const
 
 bool FGitSyncWorker::Execute(FGitSourceControlCommand& InCommand)
 {
+	// remember the current commit, to find the files changed by the pull (ORIG_HEAD is not updated when the pull has nothing to do)
+	FString PreviousCommitId;
+	FString PreviousCommitSummary;
+	GitSourceControlUtils::GetCommitInfo(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, PreviousCommitId, PreviousCommitSummary);
+
 	// pull the branch to get remote changes by rebasing any local commits (not merging them to avoid complex graphs)
 	TArray<FString> Parameters;
 	Parameters.Add(TEXT("--rebase"));
@@ -422,18 +713,73 @@ bool FGitSyncWorker::Execute(FGitSourceControlCommand& InCommand)
 	// TODO Configure origin
 	Parameters.Add(TEXT("origin"));
 	Parameters.Add(TEXT("HEAD"));
-	InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommand(TEXT("pull"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Parameters, TArray<FString>(), InCommand.InfoMessages, InCommand.ErrorMessages);
-
-	// now update the status of our files
-	GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, InCommand.Files, InCommand.ErrorMessages, States);
+	InCommand.bCommandSuccessful = GitSourceControlCore::RunCommand(TEXT("pull"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Parameters, TArray<FString>(), InCommand.InfoMessages, InCommand.ErrorMessages);
 	GitSourceControlUtils::GetCommitInfo(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.CommitId, InCommand.CommitSummary);
 
+	// list the files changed by the pull
+	TArray<FString> ChangedFiles;
+	if(!PreviousCommitId.IsEmpty() && (InCommand.CommitId != PreviousCommitId))
+	{
+		TArray<FString> Results;
+		TArray<FString> DiffParameters;
+		DiffParameters.Add(TEXT("--name-only"));
+		DiffParameters.Add(PreviousCommitId);
+		DiffParameters.Add(TEXT("HEAD"));
+		if(GitSourceControlCore::RunCommand(TEXT("diff"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, DiffParameters, TArray<FString>(), Results, InCommand.ErrorMessages))
+		{
+			ChangedFiles = GitSourceControlUtils::AbsoluteFilenames(Results, InCommand.PathToRepositoryRoot);
+		}
+	}
+	UE_LOG(LogSourceControl, Log, TEXT("Sync: %d file(s) changed"), ChangedFiles.Num());
+	if(InCommand.Operation->GetName() == "SyncAll")
+	{
+		StaticCastSharedRef<FGitSyncAll>(InCommand.Operation)->ChangedFiles = ChangedFiles;
+	}
+
+	// now update the states of the requested files and of the files changed by the pull: unchanged files that still exist are still unchanged,
+	// and current unless still behind the upstream branch; files removed by the pull leave the cache, and the others (with local changes) get a status
+	TArray<FString> Files = InCommand.Files;
+	for(const FString& ChangedFile : ChangedFiles)
+	{
+		if(FPaths::FileExists(ChangedFile))
+		{
+			Files.AddUnique(ChangedFile);
+		}
+		else
+		{
+			DeletedFiles.Add(ChangedFile);
+		}
+	}
+	TArray<FString> FilesToUpdate = Files;
+	if(InCommand.bCommandSuccessful && (Files.Num() > 0))
+	{
+		TArray<FString> NewerFiles;
+		FDateTime LastFetchTime;
+		GitSourceControlUtils::GetNewerFilesOnServer(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Files, NewerFiles, LastFetchTime);
+		FilesToUpdate = DeriveStates(Files, [&NewerFiles](FGitSourceControlState& State)
+		{
+			State.bNewerVersionOnServer = NewerFiles.Contains(State.LocalFilename);
+			return (State.WorkingCopyState == EWorkingCopyState::Unchanged) && FPaths::FileExists(State.LocalFilename);
+		}, States);
+	}
+	if(FilesToUpdate.Num() > 0)
+	{
+		GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, FilesToUpdate, InCommand.ErrorMessages, States);
+	}
+
 	return InCommand.bCommandSuccessful;
 }
 
-bool FGitSyncWorker::UpdateStates() const
+bool FGitSyncWorker::UpdateStates()
 {
-	return GitSourceControlUtils::UpdateCachedStates(States);
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	FGitSourceControlProvider& Provider = GitSourceControl.GetProvider();
+	for(const FString& DeletedFile : DeletedFiles)
+	{
+		Provider.RemoveFileFromCache(DeletedFile);
+	}
+
+	return GitSourceControlUtils::UpdateCachedStates(MoveTemp(States));
 }
 
 
@@ -451,7 +797,7 @@ bool FGitPushWorker::Execute(FGitSourceControlCommand& InCommand)
 	{
 		TMap<FString, FString> Locks;
 		// Get locks as relative paths
-		GitSourceControlUtils::GetAllLocks(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, false, InCommand.ErrorMessages, Locks);
+		GitSourceControlCore::GetAllLocks(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, false, InCommand.ErrorMessages, Locks);
 		if(Locks.Num() > 0)
 		{		
 			// test to see what lfs files we would push, and compare to locked files, unlock after if push OK
@@ -465,7 +811,7 @@ bool FGitPushWorker::Execute(FGitSourceControlCommand& InCommand)
 			LfsPushParameters.Add(BranchName);
 			TArray<FString> LfsPushInfoMessages;
 			TArray<FString> LfsPushErrMessages;
-			InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommand(TEXT("lfs"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, LfsPushParameters, TArray<FString>(), LfsPushInfoMessages, LfsPushErrMessages);
+			InCommand.bCommandSuccessful = GitSourceControlCore::RunCommand(TEXT("lfs"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, LfsPushParameters, TArray<FString>(), LfsPushInfoMessages, LfsPushErrMessages);
 
 			if(InCommand.bCommandSuccessful)
 			{
@@ -501,7 +847,7 @@ bool FGitPushWorker::Execute(FGitSourceControlCommand& InCommand)
 	// TODO Configure origin
 	Parameters.Add(TEXT("origin"));
 	Parameters.Add(TEXT("HEAD"));
-	InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommand(TEXT("push"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Parameters, TArray<FString>(), InCommand.InfoMessages, InCommand.ErrorMessages);
+	InCommand.bCommandSuccessful = GitSourceControlCore::RunCommand(TEXT("push"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, Parameters, TArray<FString>(), InCommand.InfoMessages, InCommand.ErrorMessages);
 
 	if(InCommand.bCommandSuccessful && InCommand.bUsingGitLfsLocking && FilesToUnlock.Num() > 0)
 	{
@@ -510,7 +856,7 @@ bool FGitPushWorker::Execute(FGitSourceControlCommand& InCommand)
 		{
 			TArray<FString> OneFile;
 			OneFile.Add(FileToUnlock);
-			bool bUnlocked = GitSourceControlUtils::RunCommand(TEXT("lfs unlock"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), OneFile, InCommand.InfoMessages, InCommand.ErrorMessages);
+			bool bUnlocked = GitSourceControlCore::UnlockFiles(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, OneFile, InCommand.InfoMessages, InCommand.ErrorMessages);
 			if (!bUnlocked)
 			{
 				// Report but don't fail, it's not essential
@@ -528,9 +874,9 @@ bool FGitPushWorker::Execute(FGitSourceControlCommand& InCommand)
 	return InCommand.bCommandSuccessful;
 }
 
-bool FGitPushWorker::UpdateStates() const
+bool FGitPushWorker::UpdateStates()
 {
-	return GitSourceControlUtils::UpdateCachedStates(States);
+	return GitSourceControlUtils::UpdateCachedStates(MoveTemp(States));
 }
 
 FName FGitUpdateStatusWorker::GetName() const
@@ -538,22 +884,150 @@ FName FGitUpdateStatusWorker::GetName() const
 	return "UpdateStatus";
 }
 
+/** Inode number of a file, where the platform exposes it cheaply (else 0, and the creation time of the file is the only hint that it has been replaced) */
+static uint64 GetFileInode(const FString& InFilename)
+{
+#if PLATFORM_MAC || PLATFORM_LINUX
+	struct stat FileInfo;
+	if(stat(TCHAR_TO_UTF8(*InFilename), &FileInfo) == 0)
+	{
+		return static_cast<uint64>(FileInfo.st_ino);
+	}
+#endif
+	return 0;
+}
+
+void FGitUpdateStatusWorker::FilterUnchangedFiles(const FGitSourceControlCommand& InCommand, TMap<FString, FGitFileFingerprint>& OutFingerprints, TArray<FString>& OutFilesToUpdate)
+{
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+
+	// Stat everything before running git, so that a file modified during the status is not considered up to date afterward
+	const FDateTime IndexModificationTime = IFileManager::Get().GetTimeStamp(*(InCommand.PathToRepositoryRoot / TEXT(".git/index")));
+	if(IndexModificationTime == FDateTime::MinValue())
+	{
+		// No index (new repository, or .git is a file pointing to another directory): nothing can be trusted
+		OutFilesToUpdate = InCommand.Files;
+		return;
+	}
+
+	// In UTC, like the time stamps of the files, to tell if they are racy
+	const FDateTime Now = FDateTime::UtcNow();
+	const FDateTime FreshLimit = Now - FTimespan::FromSeconds(GitSourceControlConstants::MaxCachedLfsStateAge);
+	const TArray<FGitSourceControlState> CachedStates = GitSourceControl.GetProvider().GetCachedStates(InCommand.Files);
+	for(const FGitSourceControlState& CachedState : CachedStates)
+	{
+		const FFileStatData StatData = IFileManager::Get().GetStatData(*CachedState.LocalFilename);
+		if(StatData.bIsValid && StatData.bIsDirectory)
+		{
+			// A directory status is always run
+			OutFilesToUpdate.Add(CachedState.LocalFilename);
+			continue;
+		}
+
+		FGitFileFingerprint Fingerprint;
+		if(StatData.bIsValid)
+		{
+			Fingerprint.Size = StatData.FileSize;
+			Fingerprint.ModificationTime = StatData.ModificationTime;
+			Fingerprint.CreationTime = StatData.CreationTime;
+			Fingerprint.Inode = GetFileInode(CachedState.LocalFilename);
+		}
+		Fingerprint.IndexModificationTime = IndexModificationTime;
+		Fingerprint.StatusTime = Now;
+
+		// Locks of other users and new commits on the server are not visible in the fingerprint, so only trust recent states when using LFS locking
+		const bool bFresh = !InCommand.bUsingGitLfsLocking || (CachedState.Fingerprint.StatusTime >= FreshLimit);
+		if(!CachedState.IsUnknown() && CachedState.Fingerprint.IsValid() && !CachedState.Fingerprint.IsRacy() && (CachedState.Fingerprint == Fingerprint) && bFresh)
+		{
+			// Unchanged: confirm the cached state as is (this also clears its stale flag)
+			States.Add(CachedState);
+		}
+		else
+		{
+			OutFingerprints.Add(CachedState.LocalFilename, Fingerprint);
+			OutFilesToUpdate.Add(CachedState.LocalFilename);
+		}
+	}
+
+	UE_LOG(LogSourceControl, Log, TEXT("UpdateStatus: %d/%d files unchanged since their last status"), InCommand.Files.Num() - OutFilesToUpdate.Num(), InCommand.Files.Num());
+}
+
+void FGitUpdateStatusWorker::AddMissingFilesOfScannedDirectories(const FGitSourceControlCommand& InCommand)
+{
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+
+	TSet<FString> FilesWithStatus;
+	FilesWithStatus.Reserve(States.Num());
+	for(const FGitSourceControlState& State : States)
+	{
+		FilesWithStatus.Add(State.LocalFilename);
+	}
+
+	// Only the dirty files can be untracked files, that git does not report once deleted: the other ones are tracked and unchanged
+	const FDateTime Now = FDateTime::Now();
+	for(const FString& File : GitSourceControl.GetProvider().GetDirtyFilesInDirectories(ScannedDirectories))
+	{
+		if(!FilesWithStatus.Contains(File) && !FPaths::FileExists(File))
+		{
+			// Same as a file not found in the results of a status and that does not exist (see ParseFileStatusResult())
+			FGitSourceControlState& State = States.Emplace_GetRef(File, InCommand.bUsingGitLfsLocking);
+			State.WorkingCopyState = EWorkingCopyState::NotControlled;
+			State.LockState = ELockState::NotLocked;
+			State.TimeStamp = Now;
+		}
+	}
+}
+
 bool FGitUpdateStatusWorker::Execute(FGitSourceControlCommand& InCommand)
 {
 	check(InCommand.Operation->GetName() == GetName());
 
 	TSharedRef<FUpdateStatus, ESPMode::ThreadSafe> Operation = StaticCastSharedRef<FUpdateStatus>(InCommand.Operation);
 
+	bool bGitRun = true;
 	if(InCommand.Files.Num() > 0)
 	{
-		InCommand.bCommandSuccessful = GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, InCommand.Files, InCommand.ErrorMessages, States);
-		GitSourceControlUtils::RemoveRedundantErrors(InCommand, TEXT("' is outside repository"));
+		// Only run git on the files that may have changed since their state was computed (unless their history is also requested)
+		TMap<FString, FGitFileFingerprint> Fingerprints;
+		TArray<FString> FilesToUpdate;
+		if(Operation->ShouldUpdateHistory())
+		{
+			FilesToUpdate = InCommand.Files;
+		}
+		else
+		{
+			FilterUnchangedFiles(InCommand, Fingerprints, FilesToUpdate);
+		}
+
+		if(FilesToUpdate.Num() > 0)
+		{
+			TArray<FGitSourceControlState> UpdatedStates;
+			InCommand.bCommandSuccessful = GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, FilesToUpdate, InCommand.ErrorMessages, UpdatedStates, &ScannedDirectories);
+			GitSourceControlUtils::RemoveRedundantErrors(InCommand, TEXT("' is outside repository"));
+			if(InCommand.bCommandSuccessful)
+			{
+				for(FGitSourceControlState& State : UpdatedStates)
+				{
+					if(const FGitFileFingerprint* Fingerprint = Fingerprints.Find(State.LocalFilename))
+					{
+						State.Fingerprint = *Fingerprint;
+					}
+				}
+			}
+			States.Append(MoveTemp(UpdatedStates));
+		}
+		else
+		{
+			InCommand.bCommandSuccessful = true;
+			bGitRun = false;
+		}
 
 		if(Operation->ShouldUpdateHistory())
 		{
 			for(int32 Index = 0; Index < States.Num(); Index++)
 			{
-				FString& File = InCommand.Files[Index];
+				// States do not match InCommand.Files one to one in case of a directory status
+				const FString& File = States[Index].LocalFilename;
 				TGitSourceControlHistory History;
 
 				if(States[Index].IsConflicted())
@@ -573,32 +1047,46 @@ bool FGitUpdateStatusWorker::Execute(FGitSourceControlCommand& InCommand)
 		TArray<FString> ProjectDirs;
 		ProjectDirs.Add(FPaths::ConvertRelativePathToFull(FPaths::ProjectContentDir()));
 		ProjectDirs.Add(FPaths::ConvertRelativePathToFull(FPaths::ProjectConfigDir()));
-		InCommand.bCommandSuccessful = GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, ProjectDirs, InCommand.ErrorMessages, States);
+		InCommand.bCommandSuccessful = GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, ProjectDirs, InCommand.ErrorMessages, States, &ScannedDirectories);
 	}
 
-	GitSourceControlUtils::GetCommitInfo(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.CommitId, InCommand.CommitSummary);
+	if(InCommand.bCommandSuccessful && (ScannedDirectories.Num() > 0))
+	{
+		AddMissingFilesOfScannedDirectories(InCommand);
+	}
+
+	if(bGitRun)
+	{
+		GitSourceControlUtils::GetCommitInfo(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.CommitId, InCommand.CommitSummary);
+	}
 
 	// don't use the ShouldUpdateModifiedState() hint here as it is specific to Perforce: the above normal Git status has already told us this information (like Git and Mercurial)
 
 	return InCommand.bCommandSuccessful;
 }
 
-bool FGitUpdateStatusWorker::UpdateStates() const
+bool FGitUpdateStatusWorker::UpdateStates()
 {
-	bool bUpdated = GitSourceControlUtils::UpdateCachedStates(States);
+	bool bUpdated = GitSourceControlUtils::UpdateCachedStates(MoveTemp(States), ScannedDirectories);
 
 	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>( "GitSourceControl" );
 	FGitSourceControlProvider& Provider = GitSourceControl.GetProvider();
 
 	const FDateTime Now = FDateTime::Now();
 
-	// add history, if any
-	for(const auto& History : Histories)
+	// add history, if any (and if it changed)
+	FRWScopeLock ScopeLock(Provider.GetStateCacheLock(), SLT_Write);
+	for(auto& History : Histories)
 	{
-		TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> State = Provider.GetStateInternal(History.Key);
-		State->History = History.Value;
-		State->TimeStamp = Now;
-		bUpdated = true;
+		// The states of these files have just been added to the cache above
+		TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe>* State = Provider.FindStateInternal(History.Key);
+		if((State != nullptr) && !GitSourceControlUtils::IsSameHistory((*State)->History, History.Value))
+		{
+			(*State)->History = MoveTemp(History.Value);
+			(*State)->TimeStamp = Now;
+			Provider.MarkStateChanged(History.Key);
+			bUpdated = true;
+		}
 	}
 
 	return bUpdated;
@@ -617,14 +1105,14 @@ bool FGitCopyWorker::Execute(FGitSourceControlCommand& InCommand)
 	// but after a Move the Editor create a redirector file with the old asset name that points to the new asset.
 	// The redirector needs to be commited with the new asset to perform a real rename.
 	// => the following is to "MarkForAdd" the redirector, but it still need to be committed by selecting the whole directory and "check-in"
-	InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommand(TEXT("add"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), InCommand.Files, InCommand.InfoMessages, InCommand.ErrorMessages);
+	InCommand.bCommandSuccessful = GitSourceControlCore::RunCommand(TEXT("add"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), InCommand.Files, InCommand.InfoMessages, InCommand.ErrorMessages);
 
 	return InCommand.bCommandSuccessful;
 }
 
-bool FGitCopyWorker::UpdateStates() const
+bool FGitCopyWorker::UpdateStates()
 {
-	return GitSourceControlUtils::UpdateCachedStates(States);
+	return GitSourceControlUtils::UpdateCachedStates(MoveTemp(States));
 }
 
 FName FGitResolveWorker::GetName() const
@@ -638,7 +1126,7 @@ bool FGitResolveWorker::Execute( class FGitSourceControlCommand& InCommand )
 
 	// mark the conflicting files as resolved:
 	TArray<FString> Results;
-	InCommand.bCommandSuccessful = GitSourceControlUtils::RunCommand(TEXT("add"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), InCommand.Files, Results, InCommand.ErrorMessages);
+	InCommand.bCommandSuccessful = GitSourceControlCore::RunCommand(TEXT("add"), InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, TArray<FString>(), InCommand.Files, Results, InCommand.ErrorMessages);
 
 	// now update the status of our files
 	GitSourceControlUtils::RunUpdateStatus(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot, InCommand.bUsingGitLfsLocking, InCommand.Files, InCommand.ErrorMessages, States);
@@ -646,9 +1134,9 @@ bool FGitResolveWorker::Execute( class FGitSourceControlCommand& InCommand )
 	return InCommand.bCommandSuccessful;
 }
 
-bool FGitResolveWorker::UpdateStates() const
+bool FGitResolveWorker::UpdateStates()
 {
-	return GitSourceControlUtils::UpdateCachedStates(States);
+	return GitSourceControlUtils::UpdateCachedStates(MoveTemp(States));
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -10,6 +10,7 @@
 #include "GitSourceControlState.h"
 
 #include "ISourceControlOperation.h"
+#include "SourceControlOperations.h"
 
 /**
  * Internal operation used to push local commits to configured remote origin
@@ -23,20 +24,29 @@ public:
 	virtual FText GetInProgressString() const override;
 };
 
+/**
+ * Internal operation used by the menu to sync (pull) the whole repository, reporting the files changed by the pull
+*/
+class GITSOURCECONTROL_API FGitSyncAll : public FSync
+{
+public:
+	// ISourceControlOperation interface
+	virtual FName GetName() const override;
+
+	/** Files changed by the pull, from the previous HEAD to the new one (absolute paths), to reload only their packages */
+	TArray<FString> ChangedFiles;
+};
+
 /** Called when first activated on a project, and then at project load time.
- *  Look for the root directory of the git repository (where the ".git/" subdirectory is located). */
-class FGitConnectWorker : public IGitSourceControlWorker
+ *  Only validate the Git binary and the repository, the content being scanned in the background afterward. */
+class GITSOURCECONTROL_API FGitConnectWorker : public IGitSourceControlWorker
 {
 public:
 	virtual ~FGitConnectWorker() {}
 	// IGitSourceControlWorker interface
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
-	virtual bool UpdateStates() const override;
-
-public:
-	/** Temporary states for results */
-	TArray<FGitSourceControlState> States;
+	virtual bool UpdateStates() override;
 };
 
 /** Lock (check-out) a set of files using Git LFS 2. */
@@ -47,11 +57,14 @@ public:
 	// IGitSourceControlWorker interface
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
-	virtual bool UpdateStates() const override;
+	virtual bool UpdateStates() override;
 
 public:
 	/** Temporary states for results */
 	TArray<FGitSourceControlState> States;
+
+	/** Files confirmed to be locked by us: locked by this command, or recently confirmed to be already locked */
+	TSet<FString> LockedFiles;
 };
 
 /** Commit (check-in) a set of files to the local depot. */
@@ -62,11 +75,14 @@ public:
 	// IGitSourceControlWorker interface
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
-	virtual bool UpdateStates() const override;
+	virtual bool UpdateStates() override;
 
 public:
 	/** Temporary states for results */
 	TArray<FGitSourceControlState> States;
+
+	/** Deleted files committed, to be removed from the cache */
+	TArray<FString> DeletedFiles;
 };
 
 /** Add an untraked file to source control (so only a subset of the git add command). */
@@ -77,7 +93,7 @@ public:
 	// IGitSourceControlWorker interface
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
-	virtual bool UpdateStates() const override;
+	virtual bool UpdateStates() override;
 
 public:
 	/** Temporary states for results */
@@ -92,7 +108,7 @@ public:
 	// IGitSourceControlWorker interface
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
-	virtual bool UpdateStates() const override;
+	virtual bool UpdateStates() override;
 
 public:
 	/** Temporary states for results */
@@ -107,26 +123,33 @@ public:
 	// IGitSourceControlWorker interface
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
-	virtual bool UpdateStates() const override;
+	virtual bool UpdateStates() override;
+
+private:
+	/** Revert with "git restore" (Git 2.23+), planned from the cached states, which also tell the states after the revert */
+	bool ExecuteRestore(class FGitSourceControlCommand& InCommand);
 
 public:
 	/** Temporary states for results */
 	TArray<FGitSourceControlState> States;
 };
 
-/** Git pull --rebase to update branch from its configured remote */
-class FGitSyncWorker : public IGitSourceControlWorker
+/** Git pull --rebase to update branch from its configured remote (for both the Sync and SyncAll operations) */
+class GITSOURCECONTROL_API FGitSyncWorker : public IGitSourceControlWorker
 {
 public:
 	virtual ~FGitSyncWorker() {}
 	// IGitSourceControlWorker interface
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
-	virtual bool UpdateStates() const override;
+	virtual bool UpdateStates() override;
 
 public:
 	/** Temporary states for results */
 	TArray<FGitSourceControlState> States;
+
+	/** Files deleted by the pull, to be removed from the cache */
+	TArray<FString> DeletedFiles;
 };
 
 /** Git push to publish branch for its configured remote */
@@ -137,7 +160,7 @@ public:
 	// IGitSourceControlWorker interface
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
-	virtual bool UpdateStates() const override;
+	virtual bool UpdateStates() override;
 
 public:
 	/** Temporary states for results */
@@ -152,12 +175,31 @@ public:
 	// IGitSourceControlWorker interface
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
-	virtual bool UpdateStates() const override;
+	virtual bool UpdateStates() override;
+
+private:
+	/**
+	 * Stat the files, and keep in States the cached state of the ones that did not change since their last status,
+	 * so that git only runs on the other ones.
+	 * @param	OutFingerprints		Stat data of the files to update, to store with their new states
+	 * @param	OutFilesToUpdate	Files (and directories) that need a git status
+	 */
+	void FilterUnchangedFiles(const class FGitSourceControlCommand& InCommand, TMap<FString, FGitFileFingerprint>& OutFingerprints, TArray<FString>& OutFilesToUpdate);
+
+	/**
+	 * Add to States the dirty files of the scanned directories (see FGitSourceControlProvider::GetDirtyFilesInDirectories())
+	 * that are not reported by the status and that do not exist anymore, as "NotControlled",
+	 * since the provider gives the implicit "Unchanged" state to the other ones without stat'ing them.
+	 */
+	void AddMissingFilesOfScannedDirectories(const class FGitSourceControlCommand& InCommand);
 
 public:
 	/** Temporary states for results */
 	TArray<FGitSourceControlState> States;
 
+	/** Directories for which any file not in States is implicitly "Unchanged" */
+	TArray<FString> ScannedDirectories;
+
 	/** Map of filenames to history */
 	TMap<FString, TGitSourceControlHistory> Histories;
 };
@@ -170,7 +212,7 @@ public:
 	// IGitSourceControlWorker interface
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
-	virtual bool UpdateStates() const override;
+	virtual bool UpdateStates() override;
 
 public:
 	/** Temporary states for results */
@@ -184,7 +226,7 @@ public:
 	virtual ~FGitResolveWorker() {}
 	virtual FName GetName() const override;
 	virtual bool Execute(class FGitSourceControlCommand& InCommand) override;
-	virtual bool UpdateStates() const override;
+	virtual bool UpdateStates() override;
 	
 private:
 	/** Temporary states for results */
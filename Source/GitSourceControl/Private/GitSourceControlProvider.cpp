@@ -5,14 +5,20 @@
 
 #include "GitSourceControlProvider.h"
 
+#include "Async/Async.h"
+#include "HAL/PlatformFilemanager.h"
 #include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
 #include "Misc/Paths.h"
 #include "Misc/QueuedThreadPool.h"
+#include "Misc/ScopeLock.h"
 #include "Modules/ModuleManager.h"
 #include "Widgets/DeclarativeSyntaxSupport.h"
 #include "GitSourceControlCommand.h"
 #include "ISourceControlModule.h"
+#include "GitSourceControlLockClient.h"
 #include "GitSourceControlModule.h"
+#include "GitSourceControlOperations.h"
 #include "GitSourceControlUtils.h"
 #include "SGitSourceControlSettings.h"
 #include "Logging/MessageLog.h"
@@ -25,6 +31,24 @@
 
 static FName ProviderName("Git LFS 2");
 
+namespace GitSourceControlConstants
+{
+	/** Time during which asynchronous "UpdateStatus" requests are merged into one status command, by priority */
+	const double StatusAggregationWindow[static_cast<int32>(EGitStatusPriority::Num)] = { 0.02, 0.1, 0.5 };
+
+	/** Asynchronous "UpdateStatus" requests on up to this number of files are for files visible in the Editor */
+	const int32 MaxFilesInteractiveStatus = 64;
+
+	/** Maximum number of aggregated status commands running at the same time */
+	const int32 MaxRunningStatusCommands = 2;
+
+	/** Minimum time between two broadcasts of the state changes (each one refreshes the Content Browser) */
+	const double MinStateChangedBroadcastInterval = 0.25;
+
+	/** Minimum time between two checks of the config files, done in the thread pool */
+	const double MinConfigCheckInterval = 1.0;
+}
+
 void FGitSourceControlProvider::Init(bool bForceConnection)
 {
 	// Init() is called multiple times at startup: do not check git each time
@@ -62,7 +86,23 @@ void FGitSourceControlProvider::CheckGitAvailability()
 	if(!PathToGitBinary.IsEmpty())
 	{
 		UE_LOG(LogSourceControl, Log, TEXT("Using '%s'"), *PathToGitBinary);
-		bGitAvailable = GitSourceControlUtils::CheckGitAvailability(PathToGitBinary, &GitVersion);
+		const double StartTime = FPlatformTime::Seconds();
+
+		// The version and capabilities of the same binaries are saved by a previous run, else probed (and saved)
+		GitVersion = FGitVersion();
+		const bool bProbeCacheHit = GitSourceControlUtils::LoadCachedGitVersion(PathToGitBinary, GitVersion);
+		if(bProbeCacheHit)
+		{
+			bGitAvailable = true;
+		}
+		else
+		{
+			bGitAvailable = GitSourceControlUtils::CheckGitAvailability(PathToGitBinary, &GitVersion);
+			if(bGitAvailable)
+			{
+				GitSourceControlUtils::SaveCachedGitVersion(PathToGitBinary, GitVersion);
+			}
+		}
 		if(bGitAvailable)
 		{
 			CheckRepositoryStatus(PathToGitBinary);
@@ -70,6 +110,8 @@ void FGitSourceControlProvider::CheckGitAvailability()
 			// Register Console Commands (even without a workspace)
 			GitSourceControlConsole.Register();
 		}
+
+		UE_LOG(LogSourceControl, Log, TEXT("Git provider available in %.3lfs (probe cache %s)"), FPlatformTime::Seconds() - StartTime, bProbeCacheHit ? TEXT("hit") : TEXT("miss"));
 	}
 	else
 	{
@@ -81,16 +123,32 @@ void FGitSourceControlProvider::CheckRepositoryStatus(const FString& InPathToGit
 {
 	// Find the path to the root Git directory (if any, else uses the ProjectDir)
 	const FString PathToProjectDir = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir());
-	bGitRepositoryFound = GitSourceControlUtils::FindRootDirectory(PathToProjectDir, PathToRepositoryRoot);
+	bGitRepositoryFound = GitSourceControlCore::FindRootDirectory(PathToProjectDir, PathToRepositoryRoot);
+
+	// Read the whole config (user, remote...) in a single command, in parallel with the branch name
+	TFuture<TSharedPtr<const FGitConfig, ESPMode::ThreadSafe>> ConfigProbe = Async(EAsyncExecution::ThreadPool, [InPathToGitBinary, RepositoryRoot = PathToRepositoryRoot]()
+	{
+		return TSharedPtr<const FGitConfig, ESPMode::ThreadSafe>(FGitConfig::Load(InPathToGitBinary, RepositoryRoot));
+	});
+
 	if(bGitRepositoryFound)
 	{
 		GitSourceControlMenu.Register();
 
+		// Discover the submodules and other nested repositories, in parallel too
+		TFuture<TArray<FString>> NestedRepositoriesProbe = Async(EAsyncExecution::ThreadPool, [InPathToGitBinary, RepositoryRoot = PathToRepositoryRoot]()
+		{
+			return GitSourceControlUtils::FindNestedRepositories(InPathToGitBinary, RepositoryRoot);
+		});
+
 		// Get branch name
 		bGitRepositoryFound = GitSourceControlUtils::GetBranchName(InPathToGitBinary, PathToRepositoryRoot, BranchName);
+		TArray<FString> NewNestedRepositories = NestedRepositoriesProbe.Get();
 		if(bGitRepositoryFound)
 		{
-			GitSourceControlUtils::GetRemoteUrl(InPathToGitBinary, PathToRepositoryRoot, RemoteUrl);
+			CheckIgnore.Init(InPathToGitBinary, PathToRepositoryRoot);
+			FScopeLock ScopeLock(&NestedRepositoriesCriticalSection);
+			NestedRepositories = MoveTemp(NewNestedRepositories);
 		}
 		else
 		{
@@ -102,14 +160,119 @@ void FGitSourceControlProvider::CheckRepositoryStatus(const FString& InPathToGit
 		UE_LOG(LogSourceControl, Warning, TEXT("'%s' is not part of a Git repository"), *FPaths::ProjectDir());
 	}
 
-	// Get user name & email (of the repository, else from the global Git config)
-	GitSourceControlUtils::GetUserConfig(InPathToGitBinary, PathToRepositoryRoot, UserName, UserEmail);
+	// User name & email (of the repository, else from the global Git config) and remote URL are then read from this snapshot
+	const TSharedPtr<const FGitConfig, ESPMode::ThreadSafe> NewConfig = ConfigProbe.Get();
+	{
+		FScopeLock ScopeLock(&ConfigCriticalSection);
+		Config = NewConfig.ToSharedRef();
+	}
+	ConfigReload.Reset();
+	LastConfigCheckTime = FPlatformTime::Seconds();
+
+	UpdateEngineSettings();
+}
+
+void FGitSourceControlProvider::UpdateEngineSettings()
+{
+	const FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	FGitEngineSettings Settings;
+	Settings.LfsUserName = GitSourceControl.AccessSettings().GetLfsUserName();
+	Settings.MainRepositoryRoot = PathToRepositoryRoot;
+	Settings.NestedRepositories = GetNestedRepositories();
+	Settings.bHasCatFileWithFilters = GitVersion.bHasCatFileWithFilters;
+	if(bGitRepositoryFound)
+	{
+		// NOTE the provider outlives the commands, and Close() resets the settings before closing the check-ignore process
+		Settings.GetIgnoredFiles = [this](const TArray<FString>& InFiles) { return CheckIgnore.GetIgnoredFiles(InFiles); };
+	}
+	GitSourceControlCore::SetEngineSettings(MoveTemp(Settings));
+}
+
+TArray<FString> FGitSourceControlProvider::GetNestedRepositories() const
+{
+	FScopeLock ScopeLock(&NestedRepositoriesCriticalSection);
+	return NestedRepositories;
+}
+
+TSharedRef<const FGitConfig, ESPMode::ThreadSafe> FGitSourceControlProvider::GetConfig() const
+{
+	FScopeLock ScopeLock(&ConfigCriticalSection);
+	return Config;
+}
+
+void FGitSourceControlProvider::UpdateConfig()
+{
+	// Swap in the snapshot reloaded in the background, if any
+	if(ConfigReload.IsValid())
+	{
+		if(!ConfigReload.IsReady())
+		{
+			return;
+		}
+		const TSharedPtr<const FGitConfig, ESPMode::ThreadSafe> NewConfig = ConfigReload.Get();
+		ConfigReload.Reset();
+		if(NewConfig.IsValid())
+		{
+			FScopeLock ScopeLock(&ConfigCriticalSection);
+			Config = NewConfig.ToSharedRef();
+		}
+	}
+
+	// Then check the config files for changes, and reload them if needed, in the thread pool
+	const double Now = FPlatformTime::Seconds();
+	if(bGitAvailable && (Now - LastConfigCheckTime >= GitSourceControlConstants::MinConfigCheckInterval))
+	{
+		LastConfigCheckTime = Now;
+		const FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+		ConfigReload = Async(EAsyncExecution::ThreadPool, [CurrentConfig = GetConfig(), PathToGitBinary = GitSourceControl.AccessSettings().GetBinaryPath(), RepositoryRoot = PathToRepositoryRoot]()
+		{
+			return CurrentConfig->IsOutdated() ? TSharedPtr<const FGitConfig, ESPMode::ThreadSafe>(FGitConfig::Load(PathToGitBinary, RepositoryRoot)) : TSharedPtr<const FGitConfig, ESPMode::ThreadSafe>();
+		});
+	}
+}
+
+FString FGitSourceControlProvider::GetUserName() const
+{
+	return bGitAvailable ? GetConfig()->UserName : FString();
+}
+
+FString FGitSourceControlProvider::GetUserEmail() const
+{
+	return bGitAvailable ? GetConfig()->UserEmail : FString();
+}
+
+FString FGitSourceControlProvider::GetRemoteUrl() const
+{
+	return bGitRepositoryFound ? GetConfig()->RemoteUrl : FString();
 }
 
 void FGitSourceControlProvider::Close()
 {
 	// clear the cache
-	StateCache.Empty();
+	{
+		FRWScopeLock ScopeLock(StateCacheLock, SLT_Write);
+		StateCache.Empty();
+		ScannedDirectories.Empty();
+		DirtyFiles.Empty();
+	}
+	ChangedFiles.Empty();
+	GitSourceControlCore::SetEngineSettings(FGitEngineSettings());
+	CheckIgnore.Close();
+	{
+		FScopeLock ScopeLock(&ConfigCriticalSection);
+		Config = MakeShared<FGitConfig, ESPMode::ThreadSafe>();
+	}
+	ConfigReload.Reset();
+	LockServerProbe.Reset();
+	LockServerStatus = ELockServerStatus::Unknown;
+	{
+		FScopeLock ScopeLock(&NestedRepositoriesCriticalSection);
+		NestedRepositories.Empty();
+	}
+	// fail any status request still waiting to be issued
+	CancelStatusCommands();
+	InFlightStatusFiles.Empty();
+	NumRunningStatusCommands = 0;
 	// Remove all extensions to the "Source Control" menu in the Editor Toolbar
 	GitSourceControlMenu.Unregister();
 	// Unregister Console Commands
@@ -117,8 +280,6 @@ void FGitSourceControlProvider::Close()
 
 	bGitAvailable = false;
 	bGitRepositoryFound = false;
-	UserName.Empty();
-	UserEmail.Empty();
 }
 
 TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> FGitSourceControlProvider::GetStateInternal(const FString& Filename)
@@ -131,25 +292,193 @@ TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> FGitSourceControlProvide
 	}
 	else
 	{
-		// cache an unknown state for this item
-		TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> NewState = MakeShareable( new FGitSourceControlState(Filename, bUsingGitLfsLocking) );
+		// cache an unknown state for this item (or the implicit "Unchanged" state if its directory has already been scanned)
+		TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> NewState = MakeShared<FGitSourceControlState, ESPMode::ThreadSafe>(Filename, bUsingGitLfsLocking);
+		const bool bImplicitState = IsInScannedDirectory(Filename);
+		if(bImplicitState)
+		{
+			SetImplicitState(*NewState);
+		}
+		FRWScopeLock ScopeLock(StateCacheLock, SLT_Write);
 		StateCache.Add(Filename, NewState);
+		if(!bImplicitState)
+		{
+			DirtyFiles.Add(Filename);
+		}
 		return NewState;
 	}
 }
 
+void FGitSourceControlProvider::AddStateInternal(FGitSourceControlState&& InState)
+{
+	check(!StateCache.Contains(InState.LocalFilename));
+	FString Filename = InState.LocalFilename;
+	StateCache.Add(MoveTemp(Filename), MakeShared<FGitSourceControlState, ESPMode::ThreadSafe>(MoveTemp(InState)));
+}
+
+TArray<FGitSourceControlState> FGitSourceControlProvider::GetCachedStates(const TArray<FString>& InFiles) const
+{
+	TArray<FGitSourceControlState> States;
+
+	FRWScopeLock ScopeLock(StateCacheLock, SLT_ReadOnly);
+
+	// Copy the fields of the state, except for its history which is never needed by the workers
+	auto AddCopy = [&States](const FGitSourceControlState& InState)
+	{
+		FGitSourceControlState& State = States.Emplace_GetRef(InState.LocalFilename, InState.bUsingGitLfsLocking);
+		State.PendingMergeBaseFileHash = InState.PendingMergeBaseFileHash;
+		State.WorkingCopyState = InState.WorkingCopyState;
+		State.LockState = InState.LockState;
+		State.LockUser = InState.LockUser;
+		State.bNewerVersionOnServer = InState.bNewerVersionOnServer;
+		State.bStale = InState.bStale;
+		State.Fingerprint = InState.Fingerprint;
+		State.TimeStamp = InState.TimeStamp;
+	};
+
+	if(InFiles.Num() == 0)
+	{
+		States.Reserve(StateCache.Num());
+		for(const auto& CacheItem : StateCache)
+		{
+			AddCopy(*CacheItem.Value);
+		}
+	}
+	else
+	{
+		States.Reserve(InFiles.Num());
+		for(const FString& File : InFiles)
+		{
+			if(const TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe>* CachedState = StateCache.Find(File))
+			{
+				AddCopy(**CachedState);
+			}
+			else
+			{
+				FGitSourceControlState& State = States.Emplace_GetRef(File, bUsingGitLfsLocking);
+				if(IsInScannedDirectory(File))
+				{
+					SetImplicitState(State);
+				}
+			}
+		}
+	}
+
+	return States;
+}
+
+bool FGitSourceControlProvider::IsInScannedDirectory(const FString& InFilename) const
+{
+	for(const FString& Directory : ScannedDirectories)
+	{
+		if(InFilename.StartsWith(Directory))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FGitSourceControlProvider::SetImplicitState(FGitSourceControlState& InOutState) const
+{
+	// Same as an existing file not found in the results of a status (see ParseFileStatusResult()),
+	// but only use the ignored files already known, since no git command should be run from here.
+	// NOTE the file is not stat'ed either, as this is called from the game thread for each new file in GetState():
+	// a file that does not exist (yet) is corrected to "NotControlled" by the next status of the file.
+	bool bIgnored = false;
+	if(CheckIgnore.FindCached(InOutState.LocalFilename, bIgnored) && bIgnored)
+	{
+		InOutState.WorkingCopyState = EWorkingCopyState::Ignored;
+	}
+	else
+	{
+		InOutState.WorkingCopyState = EWorkingCopyState::Unchanged;
+	}
+	InOutState.LockState = ELockState::NotLocked;
+	InOutState.LockUser.Empty();
+	InOutState.PendingMergeBaseFileHash.Empty();
+	InOutState.bNewerVersionOnServer = false;
+}
+
+bool FGitSourceControlProvider::UpdateScannedDirectory(const FString& InDirectory, const TSet<FString>& InFilesWithStatus)
+{
+	FRWScopeLock ScopeLock(StateCacheLock, SLT_Write);
+
+	if(!IsInScannedDirectory(InDirectory))
+	{
+		// A parent directory supersedes any of its subdirectories
+		ScannedDirectories.RemoveAll([&InDirectory](const FString& Directory) { return Directory.StartsWith(InDirectory); });
+		ScannedDirectories.Add(InDirectory);
+	}
+
+	// Files that were not "Unchanged" before this status but that are not reported anymore are now back to the implicit state
+	// (only the dirty files can be in another state: the other ones of the directory are already in the implicit state)
+	bool bUpdated = false;
+	const FDateTime Now = FDateTime::Now();
+	for(auto It = DirtyFiles.CreateIterator(); It; ++It)
+	{
+		const FString& File = *It;
+		if(!File.StartsWith(InDirectory) || InFilesWithStatus.Contains(File))
+		{
+			continue;
+		}
+
+		if(TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe>* CachedState = StateCache.Find(File))
+		{
+			FGitSourceControlState& State = **CachedState;
+			const EWorkingCopyState::Type OldWorkingCopyState = State.WorkingCopyState;
+			const ELockState::Type OldLockState = State.LockState;
+			const bool bOldNewerVersionOnServer = State.bNewerVersionOnServer;
+			SetImplicitState(State);
+			State.bStale = false;
+			State.Fingerprint = FGitFileFingerprint();
+			if((State.WorkingCopyState != OldWorkingCopyState) || (State.LockState != OldLockState) || (State.bNewerVersionOnServer != bOldNewerVersionOnServer))
+			{
+				State.TimeStamp = Now;
+				ChangedFiles.Add(File);
+				bUpdated = true;
+			}
+		}
+		It.RemoveCurrent();
+	}
+
+	return bUpdated;
+}
+
+TArray<FString> FGitSourceControlProvider::GetDirtyFilesInDirectories(const TArray<FString>& InDirectories) const
+{
+	FRWScopeLock ScopeLock(StateCacheLock, SLT_ReadOnly);
+	TArray<FString> Files;
+	for(const FString& File : DirtyFiles)
+	{
+		if(InDirectories.ContainsByPredicate([&File](const FString& Directory) { return File.StartsWith(Directory); }))
+		{
+			Files.Add(File);
+		}
+	}
+	return Files;
+}
+
 FText FGitSourceControlProvider::GetStatusText() const
 {
 	FFormatNamedArguments Args;
 	Args.Add( TEXT("RepositoryName"), FText::FromString(PathToRepositoryRoot) );
-	Args.Add( TEXT("RemoteUrl"), FText::FromString(RemoteUrl) );
-	Args.Add( TEXT("UserName"), FText::FromString(UserName) );
-	Args.Add( TEXT("UserEmail"), FText::FromString(UserEmail) );
+	Args.Add( TEXT("RemoteUrl"), FText::FromString(GetRemoteUrl()) );
+	Args.Add( TEXT("UserName"), FText::FromString(GetUserName()) );
+	Args.Add( TEXT("UserEmail"), FText::FromString(GetUserEmail()) );
 	Args.Add( TEXT("BranchName"), FText::FromString(BranchName) );
 	Args.Add( TEXT("CommitId"), FText::FromString(CommitId.Left(8)) );
 	Args.Add( TEXT("CommitSummary"), FText::FromString(CommitSummary) );
 
-	return FText::Format( NSLOCTEXT("Status", "Provider: Git\nEnabledLabel", "Local repository: {RepositoryName}\nRemote origin: {RemoteUrl}\nUser: {UserName}\nE-mail: {UserEmail}\n[{BranchName} {CommitId}] {CommitSummary}"), Args );
+	const FText StatusText = FText::Format( NSLOCTEXT("Status", "Provider: Git\nEnabledLabel", "Local repository: {RepositoryName}\nRemote origin: {RemoteUrl}\nUser: {UserName}\nE-mail: {UserEmail}\n[{BranchName} {CommitId}] {CommitSummary}"), Args );
+	if(!bUsingGitLfsLocking || (LockServerStatus == ELockServerStatus::Unknown))
+	{
+		return StatusText;
+	}
+
+	const FText LockServerStatusText = (LockServerStatus == ELockServerStatus::Checking) ? LOCTEXT("LockServerChecking", "checking...")
+		: (LockServerStatus == ELockServerStatus::Reachable) ? LOCTEXT("LockServerReachable", "reachable") : LOCTEXT("LockServerNotReachable", "unreachable");
+	return FText::Format(LOCTEXT("StatusWithLockServer", "{0}\nLock server: {1}"), StatusText, LockServerStatusText);
 }
 
 /** Quick check if source control is enabled */
@@ -214,13 +543,23 @@ TArray<FSourceControlStateRef> FGitSourceControlProvider::GetCachedStateByPredic
 
 bool FGitSourceControlProvider::RemoveFileFromCache(const FString& Filename)
 {
-	return StateCache.Remove(Filename) > 0;
+	FRWScopeLock ScopeLock(StateCacheLock, SLT_Write);
+	if(StateCache.Remove(Filename) > 0)
+	{
+		// A file leaving the cache (deleted by a commit or by a pull) is notified like any other change of state
+		ChangedFiles.Add(Filename);
+		DirtyFiles.Remove(Filename);
+		return true;
+	}
+	return false;
 }
 
 /** Get files in cache */
-TArray<FString> FGitSourceControlProvider::GetFilesInCache()
+TArray<FString> FGitSourceControlProvider::GetFilesInCache() const
 {
+	FRWScopeLock ScopeLock(StateCacheLock, SLT_ReadOnly);
 	TArray<FString> Files;
+	Files.Reserve(StateCache.Num());
 	for (const auto& State : StateCache)
 	{
 		Files.Add(State.Key);
@@ -252,6 +591,25 @@ ECommandResult::Type FGitSourceControlProvider::Execute(const TSharedRef<ISource
 
 	TArray<FString> AbsoluteFiles = SourceControlHelpers::AbsoluteFilenames(InFiles);
 
+	// Merge overlapping asynchronous status requests (the history needs to be gathered file by file, so they are not merged)
+	// Small requests come from the Content Browser (ISourceControlModule::QueueStatusUpdate()) for the assets visible to the user
+	if((InConcurrency == EConcurrency::Asynchronous) && (InOperation->GetName() == "UpdateStatus") && (AbsoluteFiles.Num() > 0)
+		&& !StaticCastSharedRef<FUpdateStatus>(InOperation)->ShouldUpdateHistory() && WorkersMap.Contains(InOperation->GetName()))
+	{
+		const EGitStatusPriority Priority = (AbsoluteFiles.Num() <= GitSourceControlConstants::MaxFilesInteractiveStatus) ? EGitStatusPriority::Interactive : EGitStatusPriority::Background;
+		return QueueStatusRequest(InOperation, AbsoluteFiles, Priority, InOperationCompleteDelegate);
+	}
+
+	// Check out at once, confirming the locks in the background, if enabled and if no file is known to be locked by someone else
+	if((InOperation->GetName() == "CheckOut") && bUsingGitLfsLocking && (AbsoluteFiles.Num() > 0) && WorkersMap.Contains(InOperation->GetName()))
+	{
+		const FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+		if(GitSourceControl.AccessSettings().IsOptimisticCheckOutEnabled() && CanCheckOutOptimistically(AbsoluteFiles))
+		{
+			return ExecuteOptimisticCheckOut(InOperation, AbsoluteFiles, InOperationCompleteDelegate);
+		}
+	}
+
 	// Query to see if we allow this operation
 	TSharedPtr<IGitSourceControlWorker, ESPMode::ThreadSafe> Worker = CreateWorker(InOperation->GetName());
 	if(!Worker.IsValid())
@@ -289,6 +647,110 @@ ECommandResult::Type FGitSourceControlProvider::Execute(const TSharedRef<ISource
 	}
 }
 
+bool FGitSourceControlProvider::CanCheckOutOptimistically(const TArray<FString>& InFiles) const
+{
+	FRWScopeLock ScopeLock(StateCacheLock, SLT_ReadOnly);
+	for(const FString& File : InFiles)
+	{
+		const TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe>* State = StateCache.Find(File);
+		if((State == nullptr) || (*State)->IsUnknown() || !((*State)->CanCheckout() || (*State)->IsCheckedOut()))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+ECommandResult::Type FGitSourceControlProvider::ExecuteOptimisticCheckOut(const FSourceControlOperationRef& InOperation, const TArray<FString>& InFiles, const FSourceControlOperationComplete& InOperationCompleteDelegate)
+{
+	const FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	const FString LfsUserName = GitSourceControl.AccessSettings().GetLfsUserName();
+
+	// Mark the files as locked by us (stale until the lock is confirmed) and make them writable
+	TMap<FString, FDateTime> ModificationTimes;
+	{
+		FRWScopeLock ScopeLock(StateCacheLock, SLT_Write);
+		for(const FString& File : InFiles)
+		{
+			FGitSourceControlState& State = **StateCache.Find(File);
+			if(!State.IsCheckedOut())
+			{
+				State.LockState = ELockState::Locked;
+				State.LockUser = LfsUserName;
+				State.bStale = true;
+				State.Fingerprint = FGitFileFingerprint();
+				MarkStateChanged(File);
+			}
+		}
+	}
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	for(const FString& File : InFiles)
+	{
+		PlatformFile.SetReadOnly(*File, false);
+		ModificationTimes.Add(File, PlatformFile.GetTimeStamp(*File));
+	}
+
+	// Confirm the locks in the background
+	const FSourceControlOperationRef CheckOutOperation = ISourceControlOperation::Create<FCheckOut>();
+	const TSharedRef<FGitCheckOutWorker, ESPMode::ThreadSafe> Worker = MakeShared<FGitCheckOutWorker, ESPMode::ThreadSafe>();
+	FGitSourceControlCommand* Command = new FGitSourceControlCommand(CheckOutOperation, Worker,
+		FSourceControlOperationComplete::CreateRaw(this, &FGitSourceControlProvider::OnOptimisticCheckOutComplete, Worker, MoveTemp(ModificationTimes)));
+	Command->Files = InFiles;
+	Command->bAutoDelete = true;
+	UE_LOG(LogSourceControl, Log, TEXT("IssueAsynchronousCommand(CheckOut) to confirm the locks of %d files"), InFiles.Num());
+	IssueCommand(*Command);
+
+	InOperationCompleteDelegate.ExecuteIfBound(InOperation, ECommandResult::Succeeded);
+	return ECommandResult::Succeeded;
+}
+
+void FGitSourceControlProvider::OnOptimisticCheckOutComplete(const FSourceControlOperationRef& InOperation, ECommandResult::Type InResult, TSharedRef<FGitCheckOutWorker, ESPMode::ThreadSafe> InWorker, TMap<FString, FDateTime> InModificationTimes)
+{
+	// Roll back all the files that the CheckOut did not confirm to be locked by us, whatever their cached state:
+	// if both the lock and the status of a file failed, the cache still holds the lock marked by the optimistic CheckOut
+	FMessageLog SourceControlLog("SourceControl");
+	bool bRolledBack = false;
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	for(const auto& ModificationTime : InModificationTimes)
+	{
+		const FString& File = ModificationTime.Key;
+		if(InWorker->LockedFiles.Contains(File))
+		{
+			continue;
+		}
+
+		const TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> State = GetStateInternal(File);
+		{
+			FRWScopeLock ScopeLock(StateCacheLock, SLT_Write);
+			if((State->LockState == ELockState::Locked) && State->bStale)
+			{
+				// Still the lock marked by the optimistic CheckOut: the actual lock state is unknown
+				State->LockState = ELockState::Unknown;
+				State->LockUser.Empty();
+				MarkStateChanged(File);
+			}
+		}
+
+		FString LockUser;
+		const FText Who = State->IsCheckedOutOther(&LockUser) ? FText::FromString(LockUser) : LOCTEXT("OptimisticCheckOutUnknownUser", "the lock server");
+		if(PlatformFile.GetTimeStamp(*File) != ModificationTime.Value)
+		{
+			// Already saved since the optimistic CheckOut: keep the changes, the user has to resolve the conflict
+			SourceControlLog.Error(FText::Format(LOCTEXT("OptimisticCheckOutConflict", "Conflict: '{0}' has been modified, but its lock has been refused by {1}"), FText::FromString(File), Who));
+		}
+		else
+		{
+			PlatformFile.SetReadOnly(*File, true);
+			SourceControlLog.Warning(FText::Format(LOCTEXT("OptimisticCheckOutRolledBack", "Check out of '{0}' rolled back: its lock has been refused by {1}"), FText::FromString(File), Who));
+		}
+		bRolledBack = true;
+	}
+	if(bRolledBack)
+	{
+		SourceControlLog.Notify();
+	}
+}
+
 bool FGitSourceControlProvider::CanCancelOperation( const FSourceControlOperationRef& InOperation ) const
 {
 	return false;
@@ -352,48 +814,238 @@ void FGitSourceControlProvider::UpdateRepositoryStatus(const class FGitSourceCon
 		CommitId = InCommand.CommitId;
 		CommitSummary = InCommand.CommitSummary;
 	}
+
+	// Connect only validates the repository: scan the content and check the lock server in the background
+	if((InCommand.Operation->GetName() == "Connect") && InCommand.bCommandSuccessful)
+	{
+		QueueContentScan();
+		if(InCommand.bUsingGitLfsLocking)
+		{
+			StartLockServerProbe(InCommand.PathToGitBinary, InCommand.PathToRepositoryRoot);
+		}
+	}
+}
+
+void FGitSourceControlProvider::QueueContentScan()
+{
+	// One status command for each subdirectory of Content/, so that the states are streamed to the Editor
+	// directory after directory, and so that the status requests of the Editor can run in between
+	const FString ContentDir = FPaths::ConvertRelativePathToFull(FPaths::ProjectContentDir());
+	TArray<FString> ContentFiles;
+	TArray<TArray<FString>> ScanBatches;
+	FPlatformFileManager::Get().GetPlatformFile().IterateDirectory(*ContentDir, [&ContentFiles, &ScanBatches](const TCHAR* InFilenameOrDirectory, bool bInIsDirectory)
+	{
+		if(bInIsDirectory)
+		{
+			ScanBatches.AddDefaulted_GetRef().Add(FString(InFilenameOrDirectory) + TEXT("/"));
+		}
+		else
+		{
+			ContentFiles.Add(InFilenameOrDirectory);
+		}
+		return true;
+	});
+	// then the files at the root of Content/ with the Config/ directory
+	ContentFiles.Add(FPaths::ConvertRelativePathToFull(FPaths::ProjectConfigDir()));
+	ScanBatches.Add(MoveTemp(ContentFiles));
+
+	const FSourceControlOperationRef UpdateStatusOperation = ISourceControlOperation::Create<FUpdateStatus>();
+	for(TArray<FString>& Files : ScanBatches)
+	{
+		FGitSourceControlCommand* Command = new FGitSourceControlCommand(UpdateStatusOperation, CreateWorker(UpdateStatusOperation->GetName()).ToSharedRef());
+		Command->bAutoDelete = true;
+		Command->Files = MoveTemp(Files);
+		InFlightStatusFiles.Add(Command, TSet<FString>(Command->Files));
+		QueuedStatusCommands[static_cast<int32>(EGitStatusPriority::Prefetch)].Add(Command);
+	}
+	UE_LOG(LogSourceControl, Log, TEXT("Content scan queued in %d status commands"), ScanBatches.Num());
+}
+
+void FGitSourceControlProvider::StartLockServerProbe(const FString& InPathToGitBinary, const FString& InRepositoryRoot)
+{
+	LockServerStatus = ELockServerStatus::Checking;
+	LockServerProbe = Async(EAsyncExecution::ThreadPool, [InPathToGitBinary, InRepositoryRoot]()
+	{
+		// Check server connection by listing (at most one of) the locks
+		TArray<FString> ErrorMessages;
+		const bool bReachable = GitSourceControlCore::CheckLockServer(InPathToGitBinary, InRepositoryRoot, ErrorMessages);
+		for(const FString& ErrorMessage : ErrorMessages)
+		{
+			UE_LOG(LogSourceControl, Warning, TEXT("Git LFS lock server: %s"), *ErrorMessage);
+		}
+		return bReachable;
+	});
+}
+
+void FGitSourceControlProvider::UpdateLockServerProbe()
+{
+	if(LockServerProbe.IsValid() && LockServerProbe.IsReady())
+	{
+		const bool bReachable = LockServerProbe.Get();
+		LockServerProbe.Reset();
+		LockServerStatus = bReachable ? ELockServerStatus::Reachable : ELockServerStatus::Unreachable;
+		if(!bReachable)
+		{
+			FMessageLog SourceControlLog("SourceControl");
+			SourceControlLog.Warning(LOCTEXT("LockServerUnreachable", "Git LFS lock server unreachable: files cannot be checked out"));
+		}
+	}
+}
+
+ECommandResult::Type FGitSourceControlProvider::QueueStatusRequest(const FSourceControlOperationRef& InOperation, const TArray<FString>& InFiles, EGitStatusPriority InPriority, const FSourceControlOperationComplete& InOperationCompleteDelegate)
+{
+	const int32 Priority = static_cast<int32>(InPriority);
+
+	// Join a status command already queued for all these files, as long as it has not started running git
+	for(const auto& InFlightStatus : InFlightStatusFiles)
+	{
+		FGitSourceControlCommand* Command = InFlightStatus.Key;
+		if(!Command->bExecuteStarted && !InFiles.ContainsByPredicate([&InFlightStatus](const FString& File) { return !InFlightStatus.Value.Contains(File); }))
+		{
+			UE_LOG(LogSourceControl, Log, TEXT("UpdateStatus(%d files) joined to a queued status"), InFiles.Num());
+			Command->JoinOperation(InOperation, InOperationCompleteDelegate);
+			// Move the command up to the queue of the new request if it has a higher priority
+			for(int32 QueuePriority = Priority + 1; QueuePriority < static_cast<int32>(EGitStatusPriority::Num); QueuePriority++)
+			{
+				if(QueuedStatusCommands[QueuePriority].Remove(Command) > 0)
+				{
+					QueuedStatusCommands[Priority].Add(Command);
+					break;
+				}
+			}
+			return ECommandResult::Succeeded;
+		}
+	}
+
+	// else merge the files into the pending status command of the same priority
+	FPendingStatus& Pending = PendingStatus[Priority];
+	if(Pending.Command == nullptr)
+	{
+		Pending.Command = new FGitSourceControlCommand(InOperation, CreateWorker(InOperation->GetName()).ToSharedRef(), InOperationCompleteDelegate);
+		Pending.Command->bAutoDelete = true;
+		Pending.Deadline = FPlatformTime::Seconds() + GitSourceControlConstants::StatusAggregationWindow[Priority];
+	}
+	else
+	{
+		Pending.Command->JoinOperation(InOperation, InOperationCompleteDelegate);
+	}
+	Pending.Files.Append(InFiles);
+
+	return ECommandResult::Succeeded;
+}
+
+void FGitSourceControlProvider::ScheduleStatusCommands()
+{
+	const double Now = FPlatformTime::Seconds();
+	for(int32 Priority = 0; Priority < static_cast<int32>(EGitStatusPriority::Num); Priority++)
+	{
+		FPendingStatus& Pending = PendingStatus[Priority];
+		if((Pending.Command != nullptr) && (Now >= Pending.Deadline))
+		{
+			Pending.Command->Files = Pending.Files.Array();
+			UE_LOG(LogSourceControl, Log, TEXT("UpdateStatus(%d files) for %d requests queued with priority %d"), Pending.Command->Files.Num(), Pending.Command->JoinedOperations.Num() + 1, Priority);
+			InFlightStatusFiles.Add(Pending.Command, MoveTemp(Pending.Files));
+			QueuedStatusCommands[Priority].Add(Pending.Command);
+			Pending.Command = nullptr;
+			Pending.Files.Reset();
+		}
+	}
+
+	// Only give a few status commands at a time to the thread pool, so that the queued ones can still be reordered
+	for(int32 Priority = 0; (Priority < static_cast<int32>(EGitStatusPriority::Num)) && (NumRunningStatusCommands < GitSourceControlConstants::MaxRunningStatusCommands); )
+	{
+		if(QueuedStatusCommands[Priority].Num() == 0)
+		{
+			Priority++;
+			continue;
+		}
+
+		FGitSourceControlCommand* Command = QueuedStatusCommands[Priority][0];
+		QueuedStatusCommands[Priority].RemoveAt(0);
+		UE_LOG(LogSourceControl, Log, TEXT("IssueAsynchronousCommand(UpdateStatus) on %d files"), Command->Files.Num());
+		if(GThreadPool != nullptr)
+		{
+			NumRunningStatusCommands++;
+			IssueCommand(*Command);
+		}
+		else
+		{
+			InFlightStatusFiles.Remove(Command);
+			IssueCommand(*Command);
+			delete Command;
+		}
+	}
+}
+
+void FGitSourceControlProvider::CancelStatusCommands()
+{
+	TArray<FGitSourceControlCommand*> Commands;
+	for(int32 Priority = 0; Priority < static_cast<int32>(EGitStatusPriority::Num); Priority++)
+	{
+		if(PendingStatus[Priority].Command != nullptr)
+		{
+			Commands.Add(PendingStatus[Priority].Command);
+			PendingStatus[Priority].Command = nullptr;
+			PendingStatus[Priority].Files.Empty();
+		}
+		Commands.Append(MoveTemp(QueuedStatusCommands[Priority]));
+		QueuedStatusCommands[Priority].Empty();
+	}
+	for(FGitSourceControlCommand* Command : Commands)
+	{
+		InFlightStatusFiles.Remove(Command);
+		Command->bCommandSuccessful = false;
+		Command->ReturnResults();
+		delete Command;
+	}
 }
 
 void FGitSourceControlProvider::Tick()
 {	
-	bool bStatesUpdated = false;
+	ScheduleStatusCommands();
+	UpdateLockServerProbe();
+	UpdateConfig();
 
-	for(int32 CommandIndex = 0; CommandIndex < CommandQueue.Num(); ++CommandIndex)
+	// Drain the commands completed by the worker threads (a completion delegate can issue new commands, or even Tick() again)
+	FGitSourceControlCommand* CompletedCommand = nullptr;
+	while(CompletedCommands.Dequeue(CompletedCommand))
 	{
-		FGitSourceControlCommand& Command = *CommandQueue[CommandIndex];
-		if(Command.bExecuteProcessed)
+		FGitSourceControlCommand& Command = *CompletedCommand;
+
+		// The command is not in flight anymore
+		verify(InFlightCommands.Remove(&Command) > 0);
+		if(InFlightStatusFiles.Remove(&Command) > 0)
 		{
-			// Remove command from the queue
-			CommandQueue.RemoveAt(CommandIndex);
+			NumRunningStatusCommands--;
+		}
 
-			// Update respository status on UpdateStatus operations
-			UpdateRepositoryStatus(Command);
+		// Update respository status on UpdateStatus operations
+		UpdateRepositoryStatus(Command);
 
-			// let command update the states of any files
-			bStatesUpdated |= Command.Worker->UpdateStates();
+		// let command update the states of any files (only the ones that actually changed are recorded in ChangedFiles)
+		Command.Worker->UpdateStates();
 
-			// dump any messages to output log
-			OutputCommandMessages(Command);
+		// dump any messages to output log
+		OutputCommandMessages(Command);
 
-			// run the completion delegate callback if we have one bound
-			Command.ReturnResults();
+		// run the completion delegate callback if we have one bound
+		Command.ReturnResults();
 
-			// commands that are left in the array during a tick need to be deleted
-			if(Command.bAutoDelete)
-			{
-				// Only delete commands that are not running 'synchronously'
-				delete &Command;
-			}
-
-			// only do one command per tick loop, as we dont want concurrent modification
-			// of the command queue (which can happen in the completion delegate)
-			break;
+		// commands that are not running 'synchronously' need to be deleted here
+		if(Command.bAutoDelete)
+		{
+			delete &Command;
 		}
 	}
 
-	if(bStatesUpdated)
+	// Notify the changes at a limited rate, and not at all if a refresh did not change anything
+	const double Now = FPlatformTime::Seconds();
+	if((ChangedFiles.Num() > 0) && (Now - LastStateChangedBroadcastTime >= GitSourceControlConstants::MinStateChangedBroadcastInterval))
 	{
+		UE_LOG(LogSourceControl, Verbose, TEXT("OnSourceControlStateChanged(%d files)"), ChangedFiles.Num());
+		LastStateChangedBroadcastTime = Now;
 		OnSourceControlStateChanged.Broadcast();
+		ChangedFiles.Reset();
 	}
 }
 
@@ -432,8 +1084,8 @@ ECommandResult::Type FGitSourceControlProvider::ExecuteSynchronousCommand(FGitSo
 		// Issue the command asynchronously...
 		IssueCommand( InCommand );
 
-		// ... then wait for its completion (thus making it synchronous)
-		while(!InCommand.bExecuteProcessed)
+		// ... then wait for its completion (thus making it synchronous) until Tick() handed its results back
+		while(InFlightCommands.Contains(&InCommand))
 		{
 			// Tick the command queue and update progress.
 			Tick();
@@ -441,12 +1093,12 @@ ECommandResult::Type FGitSourceControlProvider::ExecuteSynchronousCommand(FGitSo
 			Progress.Tick();
 
 			// Sleep for a bit so we don't busy-wait so much.
-			FPlatformProcess::Sleep(0.01f);
+			if(InFlightCommands.Contains(&InCommand))
+			{
+				FPlatformProcess::Sleep(0.01f);
+			}
 		}
 
-		// always do one more Tick() to make sure the command queue is cleaned up.
-		Tick();
-
 		if(InCommand.bCommandSuccessful)
 		{
 			Result = ECommandResult::Succeeded;
@@ -455,12 +1107,6 @@ ECommandResult::Type FGitSourceControlProvider::ExecuteSynchronousCommand(FGitSo
 
 	// Delete the command now (asynchronous commands are deleted in the Tick() method)
 	check(!InCommand.bAutoDelete);
-
-	// ensure commands that are not auto deleted do not end up in the command queue
-	if ( CommandQueue.Contains( &InCommand ) )
-	{
-		CommandQueue.Remove( &InCommand );
-	}
 	delete &InCommand;
 
 	return Result;
@@ -470,9 +1116,10 @@ ECommandResult::Type FGitSourceControlProvider::IssueCommand(FGitSourceControlCo
 {
 	if(GThreadPool != nullptr)
 	{
-		// Queue this to our worker thread(s) for resolving
+		// Queue this to our worker thread(s) for resolving: the command pushes itself to the completion queue when done
+		InCommand.CompletionQueue = &CompletedCommands;
+		InFlightCommands.Add(&InCommand);
 		GThreadPool->AddQueuedWork(&InCommand);
-		CommandQueue.Add(&InCommand);
 		return ECommandResult::Succeeded;
 	}
 	else
@@ -6,11 +6,17 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/ScopeRWLock.h"
 #include "ISourceControlOperation.h"
 #include "ISourceControlState.h"
 #include "ISourceControlProvider.h"
 #include "IGitSourceControlWorker.h"
+#include "GitSourceControlCommand.h"
 #include "GitSourceControlState.h"
+#include "GitSourceControlCheckIgnore.h"
+#include "GitSourceControlConfig.h"
 #include "GitSourceControlMenu.h"
 #include "GitSourceControlConsole.h"
 
@@ -32,6 +38,7 @@ struct FGitVersion
 	uint32 bHasCatFileWithFilters : 1;
 	uint32 bHasGitLfs : 1;
 	uint32 bHasGitLfsLocking : 1;
+	uint32 bHasRestore : 1;
 
 	FGitVersion() 
 		: Major(0)
@@ -41,6 +48,7 @@ struct FGitVersion
 		, bHasCatFileWithFilters(false)
 		, bHasGitLfs(false)
 		, bHasGitLfsLocking(false)
+		, bHasRestore(false)
 	{
 	}
 
@@ -50,7 +58,20 @@ struct FGitVersion
 	}
 };
 
-class FGitSourceControlProvider : public ISourceControlProvider
+/** Priority of an asynchronous status request: the status of the files the user is looking at is resolved first */
+enum class EGitStatusPriority : uint8
+{
+	/** Files visible in the Editor, like the current view of the Content Browser */
+	Interactive,
+	/** Any other request from the Editor, like large folders or asset registry scans */
+	Background,
+	/** Speculative refresh, only run when nothing else is waiting */
+	Prefetch,
+
+	Num
+};
+
+class GITSOURCECONTROL_API FGitSourceControlProvider : public ISourceControlProvider
 {
 public:
 	/** Constructor */
@@ -106,6 +127,12 @@ public:
 	 */
 	void CheckRepositoryStatus(const FString& InPathToGitBinary);
 
+	/**
+	 * Inject the settings of the provider (LFS user name, repositories, Git capabilities, ignored files) into the git engine of GitSourceControlUtils,
+	 * to be called when any of them changes.
+	 */
+	void UpdateEngineSettings();
+
 	/** Is git binary found and working. */
 	inline bool IsGitAvailable() const
 	{
@@ -124,26 +151,54 @@ public:
 		return PathToRepositoryRoot;
 	}
 
-	/** Git config user.name */
-	inline const FString& GetUserName() const
+	/** Lazy "ignored" state of files, queried instead of "git status --ignored" */
+	inline FGitCheckIgnore& GetCheckIgnore()
 	{
-		return UserName;
+		return CheckIgnore;
 	}
 
-	/** Git config user.email */
-	inline const FString& GetUserEmail() const
+	/** Git config user.name (from local repository, else globally), read from the config snapshot */
+	FString GetUserName() const;
+
+	/** Git config user.email (from local repository, else globally), read from the config snapshot */
+	FString GetUserEmail() const;
+
+	/** Git remote origin url, read from the config snapshot */
+	FString GetRemoteUrl() const;
+
+	/** Current snapshot of the Git config, reloaded in the background by Tick() when any of its files changed (safe to call from worker threads) */
+	TSharedRef<const FGitConfig, ESPMode::ThreadSafe> GetConfig() const;
+
+	/** Roots of the submodules and other repositories nested in the main one, with their own status (safe to call from worker threads) */
+	TArray<FString> GetNestedRepositories() const;
+
+	/** Helper function used to update state cache (game thread only) */
+	TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> GetStateInternal(const FString& Filename);
+
+	/** Find a state in the cache, without adding an unknown state if not found (game thread only) */
+	TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe>* FindStateInternal(const FString& Filename)
 	{
-		return UserEmail;
+		return StateCache.Find(Filename);
 	}
 
-	/** Git remote origin url */
-	inline const FString& GetRemoteUrl() const
+	/** Add a new state to the cache, moving its content (the file must not already be in the cache). The caller must hold the write lock of GetStateCacheLock() */
+	void AddStateInternal(FGitSourceControlState&& InState);
+
+	/**
+	 * Lock protecting the state cache from the reads of worker threads: the game thread is the only writer,
+	 * so it must hold the write lock while it modifies the cache, but it does not need to lock for reading.
+	 */
+	inline FRWLock& GetStateCacheLock() const
 	{
-		return RemoteUrl;
+		return StateCacheLock;
 	}
 
-	/** Helper function used to update state cache */
-	TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> GetStateInternal(const FString& Filename);
+	/**
+	 * Get a snapshot of the cached states of some files (without their history), safe to call from worker threads.
+	 * @param	InFiles		Absolute filenames, or an empty array for all files in the cache
+	 * @returns a copy of the state of each file: the implicit state for a file not in the cache but in a scanned directory, else an unknown state
+	 */
+	TArray<FGitSourceControlState> GetCachedStates(const TArray<FString>& InFiles) const;
 
 	/**
 	 * Register a worker with the provider.
@@ -151,11 +206,41 @@ public:
 	 */
 	void RegisterWorker( const FName& InName, const FGetGitSourceControlWorker& InDelegate );
 
-	/** Remove a named file from the state cache */
+	/**
+	 * Record that the status of a whole directory has been gathered: any file in it with no explicit status is implicitly "Unchanged".
+	 * @param	InDirectory			Absolute path to the directory, with a trailing slash
+	 * @param	InFilesWithStatus	Files of the directory that got an explicit (not "Unchanged") state from this status
+	 * @returns true if any cached state was reset to the implicit state
+	 */
+	bool UpdateScannedDirectory(const FString& InDirectory, const TSet<FString>& InFilesWithStatus);
+
+	/**
+	 * Get the files of the directories that may not be in the implicit state (see DirtyFiles), the only ones a directory status has to check
+	 * (safe to call from worker threads)
+	 */
+	TArray<FString> GetDirtyFilesInDirectories(const TArray<FString>& InDirectories) const;
+
+	/**
+	 * Record that the cached state of a file has actually changed, to be notified by the next broadcast of OnSourceControlStateChanged.
+	 * The caller must hold the write lock of GetStateCacheLock()
+	 */
+	void MarkStateChanged(const FString& InFilename)
+	{
+		ChangedFiles.Add(InFilename);
+		DirtyFiles.Add(InFilename);
+	}
+
+	/** Files whose cached state changed since the previous broadcast (meant to be read by the delegates of OnSourceControlStateChanged) */
+	inline const TSet<FString>& GetChangedFiles() const
+	{
+		return ChangedFiles;
+	}
+
+	/** Remove a named file from the state cache, recording it as changed for the next broadcast */
 	bool RemoveFileFromCache(const FString& Filename);
 
-	/** Get files in cache */
-	TArray<FString> GetFilesInCache();
+	/** Get files in cache (safe to call from worker threads) */
+	TArray<FString> GetFilesInCache() const;
 
 private:
 
@@ -176,26 +261,75 @@ private:
 	/** Issue a command asynchronously if possible. */
 	ECommandResult::Type IssueCommand(class FGitSourceControlCommand& InCommand);
 
+	/** Tell if all the files are known to be lockable (or locked) by us, as required to check them out optimistically */
+	bool CanCheckOutOptimistically(const TArray<FString>& InFiles) const;
+
+	/** Mark the files as checked out and writable at once, and issue the actual CheckOut in the background to confirm the locks */
+	ECommandResult::Type ExecuteOptimisticCheckOut(const FSourceControlOperationRef& InOperation, const TArray<FString>& InFiles, const FSourceControlOperationComplete& InOperationCompleteDelegate);
+
+	/** Roll back the optimistic CheckOut of the files whose lock has been refused, or report a conflict if they have been modified meanwhile */
+	void OnOptimisticCheckOutComplete(const FSourceControlOperationRef& InOperation, ECommandResult::Type InResult, TSharedRef<class FGitCheckOutWorker, ESPMode::ThreadSafe> InWorker, TMap<FString, FDateTime> InModificationTimes);
+
+	/**
+	 * Coalesce an asynchronous "UpdateStatus" request: join a queued status command already covering all the files
+	 * (raising its priority if needed), else merge the files into the pending status command of this priority,
+	 * queued by Tick() at the end of the aggregation window.
+	 */
+	ECommandResult::Type QueueStatusRequest(const FSourceControlOperationRef& InOperation, const TArray<FString>& InFiles, EGitStatusPriority InPriority, const FSourceControlOperationComplete& InOperationCompleteDelegate);
+
+	/** Move the pending status commands at the end of their aggregation window to the queues, then issue queued status commands by priority */
+	void ScheduleStatusCommands();
+
+	/** Fail and delete all status commands not yet issued */
+	void CancelStatusCommands();
+
+	/** Tell if the file is in a directory for which the status has been gathered as a whole */
+	bool IsInScannedDirectory(const FString& InFilename) const;
+
+	/** Set the implicit state of a file in a scanned directory: "Unchanged" (or "Ignored" if already known) and not locked */
+	void SetImplicitState(FGitSourceControlState& InOutState) const;
+
 	/** Output any messages this command holds */
 	void OutputCommandMessages(const class FGitSourceControlCommand& InCommand) const;
 
 	/** Update repository status on Connect and UpdateStatus operations */
 	void UpdateRepositoryStatus(const class FGitSourceControlCommand& InCommand);
 
-	/** Path to the root of the Git repository: can be the ProjectDir itself, or any parent directory (found by the "Connect" operation) */
-	FString PathToRepositoryRoot;
+	/** Queue the background status of Content/ and Config/ after a Connect, as a stream of low priority status commands */
+	void QueueContentScan();
 
-	/** Git config user.name (from local repository, else globally) */
-	FString UserName;
+	/** Start checking asynchronously that the Git LFS lock server answers */
+	void StartLockServerProbe(const FString& InPathToGitBinary, const FString& InRepositoryRoot);
 
-	/** Git config user.email (from local repository, else globally) */
-	FString UserEmail;
+	/** Get the result of the lock server probe once it is done */
+	void UpdateLockServerProbe();
+
+	/** Swap in the config reloaded in the background once it is done, and check the config files for changes at most once per interval */
+	void UpdateConfig();
+
+	/** Path to the root of the Git repository: can be the ProjectDir itself, or any parent directory (found by the "Connect" operation) */
+	FString PathToRepositoryRoot;
 
 	/** Name of the current branch */
 	FString BranchName;
 
-	/** URL of the "origin" defaut remote server */
-	FString RemoteUrl;
+	/** Last snapshot of the Git config, see GetConfig() (empty until the first Connect) */
+	TSharedRef<const FGitConfig, ESPMode::ThreadSafe> Config = MakeShared<FGitConfig, ESPMode::ThreadSafe>();
+
+	/** Check of the config files for changes running in the thread pool, if any, with the reloaded config if they changed */
+	TFuture<TSharedPtr<const FGitConfig, ESPMode::ThreadSafe>> ConfigReload;
+
+	/** Last time the config files were checked for changes, to stat them at most once per interval (game thread only) */
+	double LastConfigCheckTime = 0.0;
+
+	/** A critical section for the config snapshot access */
+	mutable FCriticalSection ConfigCriticalSection;
+
+	/** Roots of the nested repositories, found at startup, see GetNestedRepositories() */
+	TArray<FString> NestedRepositories;
+
+	/** A critical section for the nested repositories access */
+	mutable FCriticalSection NestedRepositoriesCriticalSection;
 
 	/** Current Commit full SHA1 */
 	FString CommitId;
@@ -206,15 +340,71 @@ private:
 	/** State cache */
 	TMap<FString, TSharedRef<class FGitSourceControlState, ESPMode::ThreadSafe> > StateCache;
 
+	/** Reader/writer lock of the state cache and of the scanned directories, see GetStateCacheLock() */
+	mutable FRWLock StateCacheLock;
+
+	/** Directories for which any file missing from the state cache is implicitly "Unchanged" (with a trailing slash) */
+	TArray<FString> ScannedDirectories;
+
+	/**
+	 * Cached files whose state may not be the implicit one: every file whose state changed (see MarkStateChanged()) or got cached as unknown,
+	 * until the status of a directory containing it does not report it anymore. A directory status only needs to check these files,
+	 * instead of the whole cache. Guarded by StateCacheLock too.
+	 */
+	TSet<FString> DirtyFiles;
+
+	/** Long-running "git check-ignore" process with its cache */
+	FGitCheckIgnore CheckIgnore;
+
 	/** The currently registered source control operations */
 	TMap<FName, FGetGitSourceControlWorker> WorkersMap;
 
-	/** Queue for commands given by the main thread */
-	TArray < FGitSourceControlCommand* > CommandQueue;
+	/** Commands given to the thread pool by the main thread and not yet handed back by Tick() */
+	TSet<FGitSourceControlCommand*> InFlightCommands;
+
+	/** Commands completed by the worker threads, waiting for Tick() */
+	FGitSourceControlCompletionQueue CompletedCommands;
+
+	/** Status command aggregating asynchronous "UpdateStatus" requests of a same priority until its deadline */
+	struct FPendingStatus
+	{
+		FGitSourceControlCommand* Command = nullptr;
+		TSet<FString> Files;
+		double Deadline = 0.0;
+	};
+	FPendingStatus PendingStatus[static_cast<int32>(EGitStatusPriority::Num)];
+
+	/** Aggregated status commands waiting for a thread, by priority */
+	TArray<FGitSourceControlCommand*> QueuedStatusCommands[static_cast<int32>(EGitStatusPriority::Num)];
+
+	/** Files of the aggregated status commands queued or running, to join new requests to them */
+	TMap<FGitSourceControlCommand*, TSet<FString>> InFlightStatusFiles;
+
+	/** Number of aggregated status commands given to the thread pool and not yet processed */
+	int32 NumRunningStatusCommands = 0;
+
+	/** Result of the Git LFS lock server probe started after a Connect */
+	enum class ELockServerStatus : uint8
+	{
+		Unknown,
+		Checking,
+		Reachable,
+		Unreachable,
+	};
+	ELockServerStatus LockServerStatus = ELockServerStatus::Unknown;
+
+	/** Lock server probe running in the thread pool, if any */
+	TFuture<bool> LockServerProbe;
 
 	/** For notifying when the source control states in the cache have changed */
 	FSourceControlStateChanged OnSourceControlStateChanged;
 
+	/** Files whose cached state changed since the previous broadcast */
+	TSet<FString> ChangedFiles;
+
+	/** Time of the previous broadcast, to limit the rate of Content Browser refreshes */
+	double LastStateChangedBroadcastTime = 0.0;
+
 	/** Git version for feature checking */
 	FGitVersion GitVersion;
 
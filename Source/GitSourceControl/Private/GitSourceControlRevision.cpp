@@ -29,7 +29,7 @@ bool FGitSourceControlRevision::Get(FString& InOutFilename) const
 
 	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
 	const FString PathToGitBinary = GitSourceControl.AccessSettings().GetBinaryPath();
-	const FString PathToRepositoryRoot = GitSourceControl.GetProvider().GetPathToRepositoryRoot();
+	const FString RepositoryRoot = PathToRepositoryRoot.IsEmpty() ? GitSourceControl.GetProvider().GetPathToRepositoryRoot() : PathToRepositoryRoot;
 
 	// if a filename for the temp file wasn't supplied generate a unique-ish one
 	if(InOutFilename.Len() == 0)
@@ -51,7 +51,7 @@ bool FGitSourceControlRevision::Get(FString& InOutFilename) const
 	}
 	else
 	{
-		bCommandSuccessful = GitSourceControlUtils::RunDumpToFile(PathToGitBinary, PathToRepositoryRoot, Parameter, InOutFilename);
+		bCommandSuccessful = GitSourceControlCore::RunDumpToFile(PathToGitBinary, RepositoryRoot, Parameter, InOutFilename);
 	}
 	return bCommandSuccessful;
 }
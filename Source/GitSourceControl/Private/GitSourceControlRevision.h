@@ -11,7 +11,7 @@
 #include "Runtime/Launch/Resources/Version.h"
 
 /** Revision of a file, linked to a specific commit */
-class FGitSourceControlRevision : public ISourceControlRevision
+class GITSOURCECONTROL_API FGitSourceControlRevision : public ISourceControlRevision
 {
 public:
 
@@ -37,9 +37,12 @@ public:
 
 public:
 
-	/** The filename this revision refers to */
+	/** The filename this revision refers to, relative to its repository */
 	FString Filename;
 
+	/** The Git repository of the file (the default one, or a nested one), where to get the revision from */
+	FString PathToRepositoryRoot;
+
 	/** The full hexadecimal SHA1 id of the commit this revision refers to */
 	FString CommitId;
 
@@ -87,6 +87,40 @@ bool FGitSourceControlSettings::IsPushAfterCommitEnabled() const
 	return bIsPushAfterCommitEnabled;
 }
 
+bool FGitSourceControlSettings::SetIsOptimisticCheckOutEnabled(bool bInEnabled)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	const bool bChanged = (bIsOptimisticCheckOutEnabled != bInEnabled);
+	if (bChanged)
+	{
+		bIsOptimisticCheckOutEnabled = bInEnabled;
+	}
+	return bChanged;
+}
+
+bool FGitSourceControlSettings::IsOptimisticCheckOutEnabled() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	return bIsOptimisticCheckOutEnabled;
+}
+
+bool FGitSourceControlSettings::SetIsRefuseOutdatedCheckOutEnabled(bool bInEnabled)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	const bool bChanged = (bIsRefuseOutdatedCheckOutEnabled != bInEnabled);
+	if (bChanged)
+	{
+		bIsRefuseOutdatedCheckOutEnabled = bInEnabled;
+	}
+	return bChanged;
+}
+
+bool FGitSourceControlSettings::IsRefuseOutdatedCheckOutEnabled() const
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	return bIsRefuseOutdatedCheckOutEnabled;
+}
+
 // This is called at startup nearly before anything else in our module: BinaryPath will then be used by the provider
 void FGitSourceControlSettings::LoadSettings()
 {
@@ -96,6 +130,8 @@ void FGitSourceControlSettings::LoadSettings()
 	GConfig->GetBool(*GitSettingsConstants::SettingsSection, TEXT("UsingGitLfsLocking"), bUsingGitLfsLocking, IniFile);
 	GConfig->GetString(*GitSettingsConstants::SettingsSection, TEXT("LfsUserName"), LfsUserName, IniFile);
 	GConfig->GetBool(*GitSettingsConstants::SettingsSection, TEXT("IsPushAfterCommitEnabled"), bIsPushAfterCommitEnabled, IniFile);
+	GConfig->GetBool(*GitSettingsConstants::SettingsSection, TEXT("IsOptimisticCheckOutEnabled"), bIsOptimisticCheckOutEnabled, IniFile);
+	GConfig->GetBool(*GitSettingsConstants::SettingsSection, TEXT("IsRefuseOutdatedCheckOutEnabled"), bIsRefuseOutdatedCheckOutEnabled, IniFile);
 }
 
 void FGitSourceControlSettings::SaveSettings() const
@@ -106,4 +142,6 @@ void FGitSourceControlSettings::SaveSettings() const
 	GConfig->SetBool(*GitSettingsConstants::SettingsSection, TEXT("UsingGitLfsLocking"), bUsingGitLfsLocking, IniFile);
 	GConfig->SetString(*GitSettingsConstants::SettingsSection, TEXT("LfsUserName"), *LfsUserName, IniFile);
 	GConfig->SetBool(*GitSettingsConstants::SettingsSection, TEXT("IsPushAfterCommitEnabled"), bIsPushAfterCommitEnabled, IniFile);
+	GConfig->SetBool(*GitSettingsConstants::SettingsSection, TEXT("IsOptimisticCheckOutEnabled"), bIsOptimisticCheckOutEnabled, IniFile);
+	GConfig->SetBool(*GitSettingsConstants::SettingsSection, TEXT("IsRefuseOutdatedCheckOutEnabled"), bIsRefuseOutdatedCheckOutEnabled, IniFile);
 }
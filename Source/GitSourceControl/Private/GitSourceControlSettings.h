@@ -7,7 +7,7 @@
 
 #include "CoreMinimal.h"
 
-class FGitSourceControlSettings
+class GITSOURCECONTROL_API FGitSourceControlSettings
 {
 public:
 	/** Get the Git Binary Path */
@@ -34,6 +34,18 @@ public:
 	/** Get whether Submit means Commit AND push (default true) */
 	bool IsPushAfterCommitEnabled() const;
 
+	/** Set whether CheckOut marks files as locked at once and confirms the locks in the background (default false) */
+	bool SetIsOptimisticCheckOutEnabled(bool bInEnabled);
+
+	/** Get whether CheckOut marks files as locked at once and confirms the locks in the background (default false) */
+	bool IsOptimisticCheckOutEnabled() const;
+
+	/** Set whether CheckOut refuses to lock files with a newer version on the server, instead of only warning (default false) */
+	bool SetIsRefuseOutdatedCheckOutEnabled(bool bInEnabled);
+
+	/** Get whether CheckOut refuses to lock files with a newer version on the server, instead of only warning (default false) */
+	bool IsRefuseOutdatedCheckOutEnabled() const;
+
 	/** Load settings from ini file */
 	void LoadSettings();
 
@@ -55,4 +67,10 @@ private:
 
 	/** Does Submit mean Commit AND push */
 	bool bIsPushAfterCommitEnabled = true;
+
+	/** Does CheckOut confirm the locks in the background */
+	bool bIsOptimisticCheckOutEnabled = false;
+
+	/** Does CheckOut refuse to lock outdated files */
+	bool bIsRefuseOutdatedCheckOutEnabled = false;
 };
@@ -9,39 +9,63 @@
 #include "ISourceControlState.h"
 #include "ISourceControlRevision.h"
 #include "GitSourceControlRevision.h"
+#include "GitSourceControlTypes.h"
 
 #include "Runtime/Launch/Resources/Version.h"
 
-namespace EWorkingCopyState
+/** Stat data of a file when its state was computed, to tell if the file may have changed since */
+struct FGitFileFingerprint
 {
-	enum Type
+	/** Size of the file, or -1 if the file does not exist */
+	int64 Size = -1;
+
+	/** Modification time of the file */
+	FDateTime ModificationTime;
+
+	/** Creation time of the file: it changes when the file is replaced (the only hint of it where the inode is not available) */
+	FDateTime CreationTime;
+
+	/** Inode number of the file, where the platform exposes it (else 0): it changes when the file is replaced */
+	uint64 Inode = 0;
+
+	/** Modification time of the .git/index, which changes with any "add", "commit", "checkout", "reset"... */
+	FDateTime IndexModificationTime;
+
+	/** When the file was stat'ed to compute the state, in UTC (not compared: confirming a state from its fingerprint does not refresh it) */
+	FDateTime StatusTime;
+
+	/** Tell if this fingerprint has been computed */
+	bool IsValid() const
 	{
-		Unknown,
-		Unchanged, // called "clean" in SVN, "Pristine" in Perforce
-		Added,
-		Deleted,
-		Modified,
-		Renamed,
-		Copied,
-		Missing,
-		Conflicted,
-		NotControlled,
-		Ignored,
-	};
-}
-
-namespace ELockState
-{
-	enum Type
+		return IndexModificationTime != FDateTime::MinValue();
+	}
+
+	/**
+	 * Tell if the file could have been modified without changing its fingerprint ("racy clean", as git calls it):
+	 * modification times can have a 1s resolution, so a file modified in the same second as the status or as the index
+	 * cannot be told apart from its state at that time. Only a modification time strictly older than both can be trusted.
+	 */
+	bool IsRacy() const
+	{
+		const int64 ModificationSecond = ModificationTime.GetTicks() / ETimespan::TicksPerSecond;
+		return (ModificationSecond >= StatusTime.GetTicks() / ETimespan::TicksPerSecond) || (ModificationSecond >= IndexModificationTime.GetTicks() / ETimespan::TicksPerSecond);
+	}
+
+	bool operator==(const FGitFileFingerprint& InOther) const
+	{
+		return (Size == InOther.Size) && (ModificationTime == InOther.ModificationTime) && (CreationTime == InOther.CreationTime) && (Inode == InOther.Inode) && (IndexModificationTime == InOther.IndexModificationTime);
+	}
+
+	FGitFileFingerprint()
+		: ModificationTime(FDateTime::MinValue())
+		, CreationTime(FDateTime::MinValue())
+		, IndexModificationTime(FDateTime::MinValue())
+		, StatusTime(FDateTime::MinValue())
 	{
-		Unknown,
-		NotLocked,
-		Locked,
-		LockedOther,
-	};
-}
-
-class FGitSourceControlState : public ISourceControlState
+	}
+};
+
+class GITSOURCECONTROL_API FGitSourceControlState : public ISourceControlState
 {
 public:
 	FGitSourceControlState( const FString& InLocalFilename, const bool InUsingLfsLocking)
@@ -50,6 +74,7 @@ public:
 		, LockState(ELockState::Unknown)
 		, bUsingGitLfsLocking(InUsingLfsLocking)
 		, bNewerVersionOnServer(false)
+		, bStale(false)
 		, TimeStamp(0)
 	{
 	}
@@ -118,6 +143,12 @@ public:
 	/** Whether a newer version exists on the server */
 	bool bNewerVersionOnServer;
 
+	/** Whether this state is not confirmed yet (a lock marked by an optimistic CheckOut), until the next status or CheckOut of the file */
+	bool bStale;
+
+	/** Stat data of the file when this state was computed by a status (invalid if computed otherwise) */
+	FGitFileFingerprint Fingerprint;
+
 	/** The timestamp of the last update */
 	FDateTime TimeStamp;
 };
@@ -5,14 +5,24 @@
 
 #include "GitSourceControlUtils.h"
 
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
 #include "GitSourceControlCommand.h"
+#include "GitSourceControlLockClient.h"
+#include "GitSourceControlParsers.h"
+#include "GitSourceControlProcess.h"
 #include "HAL/PlatformProcess.h"
 #include "HAL/PlatformFilemanager.h"
 #include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ConfigCacheIni.h"
 #include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
 #include "Modules/ModuleManager.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
 #include "ISourceControlModule.h"
+#include "SourceControlHelpers.h"
 #include "GitSourceControlModule.h"
 #include "GitSourceControlProvider.h"
 
@@ -23,143 +33,115 @@
 
 namespace GitSourceControlConstants
 {
-	/** The maximum number of files we submit in a single Git command */
-	const int32 MaxFilesPerBatch = 50;
+	/** The section of the ini file where the results of the probes of the Git binaries are cached */
+	static const FString ProbeCacheSection = TEXT("GitSourceControl.ProbeCache");
 }
 
-FGitScopedTempFile::FGitScopedTempFile(const FText& InText)
-{
-	Filename = FPaths::CreateTempFilename(*FPaths::ProjectLogDir(), TEXT("Git-Temp"), TEXT(".txt"));
-	if(!FFileHelper::SaveStringToFile(InText.ToString(), *Filename, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
-	{
-		UE_LOG(LogSourceControl, Error, TEXT("Failed to write to temp file: %s"), *Filename);
-	}
-}
+DEFINE_STAT(STAT_GitExecuteWorker);
+DEFINE_STAT(STAT_GitParseStatus);
+DEFINE_STAT(STAT_GitUpdateCachedStates);
 
-FGitScopedTempFile::~FGitScopedTempFile()
+/**
+ * Files changed on the upstream branch since HEAD ("git log HEAD..HEAD@{upstream}"), as of the last fetch, by repository.
+ * Recomputed only when HEAD moves (its reflog is appended to) or when the remote refs are fetched,
+ * so that a warm lookup only costs a few file stats, without any git process nor network access.
+ * Thread-safe: used by the status and CheckOut commands on worker threads.
+ */
+class FGitNewerFilesCache
 {
-	if(FPaths::FileExists(Filename))
+public:
+	TSharedRef<const TSet<FString>, ESPMode::ThreadSafe> Get(const FString& InPathToGitBinary, const FString& InRepositoryRoot, FDateTime& OutLastFetchTime, bool& bOutCacheHit)
 	{
-		if(!FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*Filename))
+		// NOTE in a linked worktree or a submodule ".git" is a file, so the time stamps are all MinValue() and the cache never invalidates: recompute each time
+		const FString GitDir = InRepositoryRoot / TEXT(".git");
+		const bool bCacheable = IFileManager::Get().DirectoryExists(*GitDir);
+		FEntry NewEntry;
+		NewEntry.HeadLogTimeStamp = IFileManager::Get().GetTimeStamp(*(GitDir / TEXT("logs/HEAD")));
+		NewEntry.FetchHeadTimeStamp = IFileManager::Get().GetTimeStamp(*(GitDir / TEXT("FETCH_HEAD")));
+		NewEntry.PackedRefsTimeStamp = IFileManager::Get().GetTimeStamp(*(GitDir / TEXT("packed-refs")));
+		OutLastFetchTime = NewEntry.FetchHeadTimeStamp;
+
 		{
-			UE_LOG(LogSourceControl, Error, TEXT("Failed to delete temp file: %s"), *Filename);
+			FScopeLock ScopeLock(&CriticalSection);
+			const FEntry* Entry = Entries.Find(InRepositoryRoot);
+			if(bCacheable && Entry && (Entry->HeadLogTimeStamp == NewEntry.HeadLogTimeStamp) && (Entry->FetchHeadTimeStamp == NewEntry.FetchHeadTimeStamp) && (Entry->PackedRefsTimeStamp == NewEntry.PackedRefsTimeStamp))
+			{
+				bOutCacheHit = true;
+				return Entry->Files;
+			}
 		}
-	}
-}
-
-const FString& FGitScopedTempFile::GetFilename() const
-{
-	return Filename;
-}
-
-
-namespace GitSourceControlUtils
-{
-
-// Launch the Git command line process and extract its results & errors
-bool RunCommandInternalRaw(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, FString& OutResults, FString& OutErrors, const int32 ExpectedReturnCode /* = 0 */)
-{
-	int32 ReturnCode = 0;
-	FString FullCommand;
-	FString LogableCommand; // short version of the command for logging purpose
-
-	if(!InRepositoryRoot.IsEmpty())
-	{
-		FString RepositoryRoot = InRepositoryRoot;
+		bOutCacheHit = false;
 
-		// Detect a "migrate asset" scenario (a "git add" command is applied to files outside the current project)
-		if ( (InFiles.Num() > 0) && !FPaths::IsRelative(InFiles[0]) && !InFiles[0].StartsWith(InRepositoryRoot) )
+		// Fails without error message handling when there is no upstream branch (or in detached HEAD): then no file is newer on the server
+		TArray<FString> Results;
+		TArray<FString> ErrorMessages;
+		TArray<FString> Parameters;
+		Parameters.Add(TEXT("--pretty=")); // this omits the commit lines, just gets us files
+		Parameters.Add(TEXT("--name-only"));
+		Parameters.Add(TEXT("HEAD..HEAD@{upstream}"));
+		TSet<FString> Files;
+		if(GitSourceControlCore::RunCommand(TEXT("log"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), Results, ErrorMessages))
 		{
-			// in this case, find the git repository (if any) of the destination Project
-			FString DestinationRepositoryRoot;
-			if(FindRootDirectory(FPaths::GetPath(InFiles[0]), DestinationRepositoryRoot))
+			for(const FString& Result : Results)
 			{
-				RepositoryRoot = DestinationRepositoryRoot; // if found use it for the "add" command (else not, to avoid producing one more error in logs)
+				if(!Result.IsEmpty())
+				{
+					Files.Add(FPaths::ConvertRelativePathToFull(InRepositoryRoot, Result));
+				}
 			}
 		}
+		NewEntry.Files = MakeShared<TSet<FString>, ESPMode::ThreadSafe>(MoveTemp(Files));
 
-		// Specify the working copy (the root) of the git repository (before the command itself)
-		FullCommand  = TEXT("-C \"");
-		FullCommand += RepositoryRoot;
-		FullCommand += TEXT("\" ");
+		FScopeLock ScopeLock(&CriticalSection);
+		return Entries.Add(InRepositoryRoot, MoveTemp(NewEntry)).Files;
 	}
-	// then the git command itself ("status", "log", "commit"...)
-	LogableCommand += InCommand;
 
-	// Append to the command all parameters, and then finally the files
-	for(const auto& Parameter : InParameters)
-	{
-		LogableCommand += TEXT(" ");
-		LogableCommand += Parameter;
-	}
-	for(const auto& File : InFiles)
+private:
+	struct FEntry
 	{
-		LogableCommand += TEXT(" \"");
-		LogableCommand += File;
-		LogableCommand += TEXT("\"");
-	}
-	// Also, Git does not have a "--non-interactive" option, as it auto-detects when there are no connected standard input/output streams
+		FDateTime HeadLogTimeStamp;
+		FDateTime FetchHeadTimeStamp;
+		FDateTime PackedRefsTimeStamp;
+		TSharedRef<const TSet<FString>, ESPMode::ThreadSafe> Files = MakeShared<TSet<FString>, ESPMode::ThreadSafe>();
+	};
 
-	FullCommand += LogableCommand;
+	FCriticalSection CriticalSection;
+	TMap<FString, FEntry> Entries;
+};
 
-	UE_LOG(LogSourceControl, Log, TEXT("RunCommand: 'git %s'"), *LogableCommand);
+static FGitNewerFilesCache NewerFilesCache;
 
-	FString PathToGitOrEnvBinary = InPathToGitBinary;
-#if PLATFORM_MAC
-	// The Cocoa application does not inherit shell environment variables, so add the path expected to have git-lfs to PATH
-	FString PathEnv = FPlatformMisc::GetEnvironmentVariable(TEXT("PATH"));
-	FString GitInstallPath = FPaths::GetPath(InPathToGitBinary);
 
-	TArray<FString> PathArray;
-	PathEnv.ParseIntoArray(PathArray, FPlatformMisc::GetPathVarDelimiter());
-	bool bHasGitInstallPath = false;
-	for (auto Path : PathArray)
+FGitScopedTempFile::FGitScopedTempFile(const FText& InText)
+{
+	Filename = FPaths::CreateTempFilename(*FPaths::ProjectLogDir(), TEXT("Git-Temp"), TEXT(".txt"));
+	if(!FFileHelper::SaveStringToFile(InText.ToString(), *Filename, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
 	{
-		if (GitInstallPath.Equals(Path, ESearchCase::CaseSensitive))
-		{
-			bHasGitInstallPath = true;
-			break;
-		}
+		UE_LOG(LogSourceControl, Error, TEXT("Failed to write to temp file: %s"), *Filename);
 	}
+}
 
-	if (!bHasGitInstallPath)
+FGitScopedTempFile::~FGitScopedTempFile()
+{
+	if(FPaths::FileExists(Filename))
 	{
-		PathToGitOrEnvBinary = FString("/usr/bin/env");
-		FullCommand = FString::Printf(TEXT("PATH=\"%s%s%s\" \"%s\" %s"), *GitInstallPath, FPlatformMisc::GetPathVarDelimiter(), *PathEnv, *InPathToGitBinary, *FullCommand);
+		if(!FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*Filename))
+		{
+			UE_LOG(LogSourceControl, Error, TEXT("Failed to delete temp file: %s"), *Filename);
+		}
 	}
-#endif
-	FPlatformProcess::ExecProcess(*PathToGitOrEnvBinary, *FullCommand, &ReturnCode, &OutResults, &OutErrors);
+}
 
-	// TODO: add a setting to easily enable Verbose logging
-	UE_LOG(LogSourceControl, Verbose, TEXT("RunCommand(%s):\n%s"), *InCommand, *OutResults);
-	if(ReturnCode != ExpectedReturnCode || OutErrors.Len() > 0)
-	{
-		UE_LOG(LogSourceControl, Warning, TEXT("RunCommand(%s) ReturnCode=%d:\n%s"), *InCommand, ReturnCode, *OutErrors);
-	}
+const FString& FGitScopedTempFile::GetFilename() const
+{
+	return Filename;
+}
 
-	// Move push/pull progress information from the error stream to the info stream
-	if(ReturnCode == ExpectedReturnCode && OutErrors.Len() > 0)
-	{
-		OutResults.Append(OutErrors);
-		OutErrors.Empty();
-	}
 
-	return ReturnCode == ExpectedReturnCode;
-}
 
-// Basic parsing or results & errors from the Git command line process
-static bool RunCommandInternal(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages)
+namespace GitSourceControlUtils
 {
-	bool bResult;
-	FString Results;
-	FString Errors;
-
-	bResult = RunCommandInternalRaw(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, Results, Errors);
-	Results.ParseIntoArray(OutResults, TEXT("\n"), true);
-	Errors.ParseIntoArray(OutErrorMessages, TEXT("\n"), true);
 
-	return bResult;
-}
 
 FString FindGitBinaryPath()
 {
@@ -338,7 +320,7 @@ bool CheckGitAvailability(const FString& InPathToGitBinary, FGitVersion *OutVers
 {
 	FString InfoMessages;
 	FString ErrorMessages;
-	bool bGitAvailable = RunCommandInternalRaw(TEXT("version"), InPathToGitBinary, FString(), TArray<FString>(), TArray<FString>(), InfoMessages, ErrorMessages);
+	bool bGitAvailable = GitSourceControlCore::RunCommandInternalRaw(TEXT("version"), InPathToGitBinary, FString(), TArray<FString>(), TArray<FString>(), InfoMessages, ErrorMessages);
 	if(bGitAvailable)
 	{
 		if(!InfoMessages.Contains("git"))
@@ -348,11 +330,24 @@ bool CheckGitAvailability(const FString& InPathToGitBinary, FGitVersion *OutVers
 		else if(OutVersion)
 		{
 			ParseGitVersion(InfoMessages, OutVersion);
-			FindGitCapabilities(InPathToGitBinary, OutVersion);
-			FindGitLfsCapabilities(InPathToGitBinary, OutVersion);
 		}
 	}
 
+	// Probe the capabilities only once the binary is known to be git, the two probes in parallel
+	if(bGitAvailable && OutVersion)
+	{
+		TFuture<FGitVersion> LfsCapabilitiesProbe = Async(EAsyncExecution::ThreadPool, [InPathToGitBinary]()
+		{
+			FGitVersion Version;
+			FindGitLfsCapabilities(InPathToGitBinary, &Version);
+			return Version;
+		});
+		FindGitCapabilities(InPathToGitBinary, OutVersion);
+		const FGitVersion LfsCapabilities = LfsCapabilitiesProbe.Get();
+		OutVersion->bHasGitLfs = LfsCapabilities.bHasGitLfs;
+		OutVersion->bHasGitLfsLocking = LfsCapabilities.bHasGitLfsLocking;
+	}
+
 	return bGitAvailable;
 }
 
@@ -383,6 +378,8 @@ void ParseGitVersion(const FString& InVersionString, FGitVersion *OutVersion)
 						OutVersion->Windows = FCString::Atoi(*ParsedVersionString[4]);
 					}
 				}
+				// "git restore" was introduced in Git 2.23
+				OutVersion->bHasRestore = OutVersion->IsGreaterOrEqualThan(2, 23);
 				UE_LOG(LogSourceControl, Log, TEXT("Git version %d.%d.%d(%d)"), OutVersion->Major, OutVersion->Minor, OutVersion->Patch, OutVersion->Windows);
 			}
 		}
@@ -393,7 +390,7 @@ void FindGitCapabilities(const FString& InPathToGitBinary, FGitVersion *OutVersi
 {
 	FString InfoMessages;
 	FString ErrorMessages;
-	RunCommandInternalRaw(TEXT("cat-file -h"), InPathToGitBinary, FString(), TArray<FString>(), TArray<FString>(), InfoMessages, ErrorMessages, 129);
+	GitSourceControlCore::RunCommandInternalRaw(TEXT("cat-file -h"), InPathToGitBinary, FString(), TArray<FString>(), TArray<FString>(), InfoMessages, ErrorMessages, 129);
 	if (InfoMessages.Contains("--filters"))
 	{
 		OutVersion->bHasCatFileWithFilters = true;
@@ -404,7 +401,7 @@ void FindGitLfsCapabilities(const FString& InPathToGitBinary, FGitVersion *OutVe
 {
 	FString InfoMessages;
 	FString ErrorMessages;
-	bool bGitLfsAvailable = RunCommandInternalRaw(TEXT("lfs version"), InPathToGitBinary, FString(), TArray<FString>(), TArray<FString>(), InfoMessages, ErrorMessages);
+	bool bGitLfsAvailable = GitSourceControlCore::RunCommandInternalRaw(TEXT("lfs version"), InPathToGitBinary, FString(), TArray<FString>(), TArray<FString>(), InfoMessages, ErrorMessages);
 	if(bGitLfsAvailable)
 	{
 		OutVersion->bHasGitLfs = true;
@@ -417,74 +414,86 @@ void FindGitLfsCapabilities(const FString& InPathToGitBinary, FGitVersion *OutVe
 	}
 }
 
-// Find the root of the Git repository, looking from the provided path and upward in its parent directories.
-bool FindRootDirectory(const FString& InPath, FString& OutRepositoryRoot)
+FString FindGitLfsBinaryPath(const FString& InPathToGitBinary)
 {
-	bool bFound = false;
-	FString PathToGitSubdirectory;
-	OutRepositoryRoot = InPath;
+#if PLATFORM_WINDOWS
+	const FString GitLfsBinary = TEXT("git-lfs.exe");
+#else
+	const FString GitLfsBinary = TEXT("git-lfs");
+#endif
 
-	auto TrimTrailing = [](FString& Str, const TCHAR Char)
+	// Look next to git (and in "mingw64/bin/" for the "cmd/git.exe" of Git for Windows), then in the PATH
+	TArray<FString> Directories;
+	const FString GitInstallPath = FPaths::GetPath(InPathToGitBinary);
+	Directories.Add(GitInstallPath);
+	Directories.Add(GitInstallPath / TEXT("../mingw64/bin"));
+	TArray<FString> PathArray;
+	FPlatformMisc::GetEnvironmentVariable(TEXT("PATH")).ParseIntoArray(PathArray, FPlatformMisc::GetPathVarDelimiter());
+	Directories.Append(PathArray);
+	for(const FString& Directory : Directories)
 	{
-		int32 Len = Str.Len();
-		while(Len && Str[Len - 1] == Char)
+		const FString PathToGitLfsBinary = Directory / GitLfsBinary;
+		if(IFileManager::Get().FileExists(*PathToGitLfsBinary))
 		{
-			Str = Str.LeftChop(1);
-			Len = Str.Len();
+			return FPaths::ConvertRelativePathToFull(PathToGitLfsBinary);
 		}
-	};
+	}
 
-	TrimTrailing(OutRepositoryRoot, '\\');
-	TrimTrailing(OutRepositoryRoot, '/');
+	return FString();
+}
 
-	while(!bFound && !OutRepositoryRoot.IsEmpty())
-	{
-		// Look for the ".git" subdirectory (or file) present at the root of every Git repository
-		PathToGitSubdirectory = OutRepositoryRoot / TEXT(".git");
-		bFound = IFileManager::Get().DirectoryExists(*PathToGitSubdirectory) || IFileManager::Get().FileExists(*PathToGitSubdirectory);
-		if(!bFound)
-		{
-			int32 LastSlashIndex;
-			if(OutRepositoryRoot.FindLastChar('/', LastSlashIndex))
-			{
-				OutRepositoryRoot = OutRepositoryRoot.Left(LastSlashIndex);
-			}
-			else
-			{
-				OutRepositoryRoot.Empty();
-			}
-		}
-	}
-	if(!bFound)
-	{
-		OutRepositoryRoot = InPath; // If not found, return the provided dir as best possible root.
-	}
-	return bFound;
+/** Key of the probe cache: the results are only valid for the same Git and Git LFS binaries, so a new install invalidates them */
+static FString GetProbeCacheKey(const FString& InPathToGitBinary)
+{
+	const FString PathToGitLfsBinary = FindGitLfsBinaryPath(InPathToGitBinary);
+	const FDateTime GitTimeStamp = IFileManager::Get().GetTimeStamp(*InPathToGitBinary);
+	const FDateTime GitLfsTimeStamp = PathToGitLfsBinary.IsEmpty() ? FDateTime::MinValue() : IFileManager::Get().GetTimeStamp(*PathToGitLfsBinary);
+	return FString::Printf(TEXT("%s|%lld|%s|%lld"), *InPathToGitBinary, GitTimeStamp.GetTicks(), *PathToGitLfsBinary, GitLfsTimeStamp.GetTicks());
 }
 
-void GetUserConfig(const FString& InPathToGitBinary, const FString& InRepositoryRoot, FString& OutUserName, FString& OutUserEmail)
+bool LoadCachedGitVersion(const FString& InPathToGitBinary, FGitVersion& OutVersion)
 {
-	bool bResults;
-	TArray<FString> InfoMessages;
-	TArray<FString> ErrorMessages;
-	TArray<FString> Parameters;
-	Parameters.Add(TEXT("user.name"));
-	bResults = RunCommandInternal(TEXT("config"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), InfoMessages, ErrorMessages);
-	if(bResults && InfoMessages.Num() > 0)
+	const FString& IniFile = SourceControlHelpers::GetSettingsIni();
+	FString CachedKey;
+	if(!GConfig->GetString(*GitSourceControlConstants::ProbeCacheSection, TEXT("Key"), CachedKey, IniFile) || (CachedKey != GetProbeCacheKey(InPathToGitBinary)))
 	{
-		OutUserName = InfoMessages[0];
+		return false;
 	}
 
-	Parameters.Reset();
-	Parameters.Add(TEXT("user.email"));
-	InfoMessages.Reset();
-	bResults &= RunCommandInternal(TEXT("config"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), InfoMessages, ErrorMessages);
-	if(bResults && InfoMessages.Num() > 0)
-	{
-		OutUserEmail = InfoMessages[0];
-	}
+	bool bHasCatFileWithFilters = false;
+	bool bHasGitLfs = false;
+	bool bHasGitLfsLocking = false;
+	GConfig->GetInt(*GitSourceControlConstants::ProbeCacheSection, TEXT("Major"), OutVersion.Major, IniFile);
+	GConfig->GetInt(*GitSourceControlConstants::ProbeCacheSection, TEXT("Minor"), OutVersion.Minor, IniFile);
+	GConfig->GetInt(*GitSourceControlConstants::ProbeCacheSection, TEXT("Patch"), OutVersion.Patch, IniFile);
+	GConfig->GetInt(*GitSourceControlConstants::ProbeCacheSection, TEXT("Windows"), OutVersion.Windows, IniFile);
+	GConfig->GetBool(*GitSourceControlConstants::ProbeCacheSection, TEXT("HasCatFileWithFilters"), bHasCatFileWithFilters, IniFile);
+	GConfig->GetBool(*GitSourceControlConstants::ProbeCacheSection, TEXT("HasGitLfs"), bHasGitLfs, IniFile);
+	GConfig->GetBool(*GitSourceControlConstants::ProbeCacheSection, TEXT("HasGitLfsLocking"), bHasGitLfsLocking, IniFile);
+	OutVersion.bHasCatFileWithFilters = bHasCatFileWithFilters;
+	OutVersion.bHasGitLfs = bHasGitLfs;
+	OutVersion.bHasGitLfsLocking = bHasGitLfsLocking;
+	OutVersion.bHasRestore = OutVersion.IsGreaterOrEqualThan(2, 23);
+
+	UE_LOG(LogSourceControl, Log, TEXT("Git version %d.%d.%d(%d) (cached)"), OutVersion.Major, OutVersion.Minor, OutVersion.Patch, OutVersion.Windows);
+	return true;
+}
+
+void SaveCachedGitVersion(const FString& InPathToGitBinary, const FGitVersion& InVersion)
+{
+	const FString& IniFile = SourceControlHelpers::GetSettingsIni();
+	GConfig->SetString(*GitSourceControlConstants::ProbeCacheSection, TEXT("Key"), *GetProbeCacheKey(InPathToGitBinary), IniFile);
+	GConfig->SetInt(*GitSourceControlConstants::ProbeCacheSection, TEXT("Major"), InVersion.Major, IniFile);
+	GConfig->SetInt(*GitSourceControlConstants::ProbeCacheSection, TEXT("Minor"), InVersion.Minor, IniFile);
+	GConfig->SetInt(*GitSourceControlConstants::ProbeCacheSection, TEXT("Patch"), InVersion.Patch, IniFile);
+	GConfig->SetInt(*GitSourceControlConstants::ProbeCacheSection, TEXT("Windows"), InVersion.Windows, IniFile);
+	GConfig->SetBool(*GitSourceControlConstants::ProbeCacheSection, TEXT("HasCatFileWithFilters"), InVersion.bHasCatFileWithFilters, IniFile);
+	GConfig->SetBool(*GitSourceControlConstants::ProbeCacheSection, TEXT("HasGitLfs"), InVersion.bHasGitLfs, IniFile);
+	GConfig->SetBool(*GitSourceControlConstants::ProbeCacheSection, TEXT("HasGitLfsLocking"), InVersion.bHasGitLfsLocking, IniFile);
 }
 
+// Find the root of the Git repository, looking from the provided path and upward in its parent directories.
+
 bool GetBranchName(const FString& InPathToGitBinary, const FString& InRepositoryRoot, FString& OutBranchName)
 {
 	bool bResults;
@@ -494,7 +503,7 @@ bool GetBranchName(const FString& InPathToGitBinary, const FString& InRepository
 	Parameters.Add(TEXT("--short"));
 	Parameters.Add(TEXT("--quiet"));		// no error message while in detached HEAD
 	Parameters.Add(TEXT("HEAD"));
-	bResults = RunCommandInternal(TEXT("symbolic-ref"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), InfoMessages, ErrorMessages);
+	bResults = GitSourceControlCore::RunCommand(TEXT("symbolic-ref"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), InfoMessages, ErrorMessages);
 	if(bResults && InfoMessages.Num() > 0)
 	{
 		OutBranchName = InfoMessages[0];
@@ -504,7 +513,7 @@ bool GetBranchName(const FString& InPathToGitBinary, const FString& InRepository
 		Parameters.Reset();
 		Parameters.Add(TEXT("-1"));
 		Parameters.Add(TEXT("--format=\"%h\""));		// no error message while in detached HEAD
-		bResults = RunCommandInternal(TEXT("log"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), InfoMessages, ErrorMessages);
+		bResults = GitSourceControlCore::RunCommand(TEXT("log"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), InfoMessages, ErrorMessages);
 		if(bResults && InfoMessages.Num() > 0)
 		{
 			OutBranchName = "HEAD detached at ";
@@ -527,7 +536,7 @@ bool GetCommitInfo(const FString& InPathToGitBinary, const FString& InRepository
 	TArray<FString> Parameters;
 	Parameters.Add(TEXT("-1"));
 	Parameters.Add(TEXT("--format=\"%H %s\""));
-	bResults = RunCommandInternal(TEXT("log"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), InfoMessages, ErrorMessages);
+	bResults = GitSourceControlCore::RunCommand(TEXT("log"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), InfoMessages, ErrorMessages);
 	if(bResults && InfoMessages.Num() > 0)
 	{
 		OutCommitId = InfoMessages[0].Left(40);
@@ -537,162 +546,7 @@ bool GetCommitInfo(const FString& InPathToGitBinary, const FString& InRepository
 	return bResults;
 }
 
-bool GetRemoteUrl(const FString& InPathToGitBinary, const FString& InRepositoryRoot, FString& OutRemoteUrl)
-{
-	TArray<FString> InfoMessages;
-	TArray<FString> ErrorMessages;
-	TArray<FString> Parameters;
-	Parameters.Add(TEXT("get-url"));
-	Parameters.Add(TEXT("origin"));
-	const bool bResults = RunCommandInternal(TEXT("remote"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), InfoMessages, ErrorMessages);
-	if (bResults && InfoMessages.Num() > 0)
-	{
-		OutRemoteUrl = InfoMessages[0];
-	}
-
-	return bResults;
-}
-
-bool RunCommand(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages)
-{
-	bool bResult = true;
-
-	if(InFiles.Num() > GitSourceControlConstants::MaxFilesPerBatch)
-	{
-		// Batch files up so we dont exceed command-line limits
-		int32 FileCount = 0;
-		while(FileCount < InFiles.Num())
-		{
-			TArray<FString> FilesInBatch;
-			for(int32 FileIndex = 0; FileCount < InFiles.Num() && FileIndex < GitSourceControlConstants::MaxFilesPerBatch; FileIndex++, FileCount++)
-			{
-				FilesInBatch.Add(InFiles[FileCount]);
-			}
-
-			TArray<FString> BatchResults;
-			TArray<FString> BatchErrors;
-			bResult &= RunCommandInternal(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, FilesInBatch, BatchResults, BatchErrors);
-			OutResults += BatchResults;
-			OutErrorMessages += BatchErrors;
-		}
-	}
-	else
-	{
-		bResult &= RunCommandInternal(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, OutResults, OutErrorMessages);
-	}
-
-	return bResult;
-}
-
-// Run a Git "commit" command by batches
-bool RunCommit(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages)
-{
-	bool bResult = true;
-
-	if(InFiles.Num() > GitSourceControlConstants::MaxFilesPerBatch)
-	{
-		// Batch files up so we dont exceed command-line limits
-		int32 FileCount = 0;
-		{
-			TArray<FString> FilesInBatch;
-			for(int32 FileIndex = 0; FileIndex < GitSourceControlConstants::MaxFilesPerBatch; FileIndex++, FileCount++)
-			{
-				FilesInBatch.Add(InFiles[FileCount]);
-			}
-			// First batch is a simple "git commit" command with only the first files
-			bResult &= RunCommandInternal(TEXT("commit"), InPathToGitBinary, InRepositoryRoot, InParameters, FilesInBatch, OutResults, OutErrorMessages);
-		}
-
-		TArray<FString> Parameters;
-		for(const auto& Parameter : InParameters)
-		{
-			Parameters.Add(Parameter);
-		}
-		Parameters.Add(TEXT("--amend"));
-
-		while(FileCount < InFiles.Num())
-		{
-			TArray<FString> FilesInBatch;
-			for(int32 FileIndex = 0; FileCount < InFiles.Num() && FileIndex < GitSourceControlConstants::MaxFilesPerBatch; FileIndex++, FileCount++)
-			{
-				FilesInBatch.Add(InFiles[FileCount]);
-			}
-			// Next batches "amend" the commit with some more files
-			TArray<FString> BatchResults;
-			TArray<FString> BatchErrors;
-			bResult &= RunCommandInternal(TEXT("commit"), InPathToGitBinary, InRepositoryRoot, Parameters, FilesInBatch, BatchResults, BatchErrors);
-			OutResults += BatchResults;
-			OutErrorMessages += BatchErrors;
-		}
-	}
-	else
-	{
-		bResult = RunCommandInternal(TEXT("commit"), InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, OutResults, OutErrorMessages);
-	}
-
-	return bResult;
-}
-
-/**
- * Parse informations on a file locked with Git LFS
- *
- * Example output of "git lfs locks"
-Content\ThirdPersonBP\Blueprints\ThirdPersonCharacter.uasset    SRombauts       ID:891
-Content\ThirdPersonBP\Blueprints\ThirdPersonGameMode.uasset     SRombauts       ID:896
- */
-class FGitLfsLocksParser
-{
-public:
-	FGitLfsLocksParser(const FString& InRepositoryRoot, const FString& InStatus, const bool bAbsolutePaths = true)
-	{
-		TArray<FString> Informations;
-		InStatus.ParseIntoArray(Informations, TEXT("\t"), true);
-		if(Informations.Num() >= 3)
-		{
-			Informations[0].TrimEndInline(); // Trim whitespace from the end of the filename
-			Informations[1].TrimEndInline(); // Trim whitespace from the end of the username
-			if (bAbsolutePaths)
-				LocalFilename = FPaths::ConvertRelativePathToFull(InRepositoryRoot, Informations[0]);
-			else
-				LocalFilename = Informations[0];
-			LockUser = MoveTemp(Informations[1]);
-		}
-	}
-
-	FString LocalFilename;	///< Filename on disk
-	FString LockUser;		///< Name of user who has file locked
-};
-
-/**
- * @brief Extract the relative filename from a Git status result.
- *
- * Examples of status results:
-M  Content/Textures/T_Perlin_Noise_M.uasset
-R  Content/Textures/T_Perlin_Noise_M.uasset -> Content/Textures/T_Perlin_Noise_M2.uasset
-?? Content/Materials/M_Basic_Wall.uasset
-!! BasicCode.sln
- *
- * @param[in] InResult One line of status
- * @return Relative filename extracted from the line of status
- *
- * @see FGitStatusFileMatcher and StateFromGitStatus()
- */
-static FString FilenameFromGitStatus(const FString& InResult)
-{
-	int32 RenameIndex;
-	if(InResult.FindLastChar('>', RenameIndex))
-	{
-		// Extract only the second part of a rename "from -> to"
-		return InResult.RightChop(RenameIndex + 2);
-	}
-	else
-	{
-		// Extract the relative filename from the Git status result (after the 2 letters status and 1 space)
-		return InResult.RightChop(3);
-	}
-}
-
-/** Match the relative filename of a Git status result with a provided absolute filename */
+/** Match the relative filename of a Git status entry with a provided absolute filename */
 class FGitStatusFileMatcher
 {
 public:
@@ -701,110 +555,15 @@ public:
 	{
 	}
 
-	bool operator()(const FString& InResult) const
+	bool operator()(const FGitStatusEntry& InEntry) const
 	{
-		return AbsoluteFilename.Contains(FilenameFromGitStatus(InResult));
+		return AbsoluteFilename.Contains(InEntry.Filename);
 	}
 
 private:
 	const FString& AbsoluteFilename;
 };
 
-/**
- * Extract and interpret the file state from the given Git status result.
- * @see http://git-scm.com/docs/git-status
- * ' ' = unmodified
- * 'M' = modified
- * 'A' = added
- * 'D' = deleted
- * 'R' = renamed
- * 'C' = copied
- * 'U' = updated but unmerged
- * '?' = unknown/untracked
- * '!' = ignored
-*/
-class FGitStatusParser
-{
-public:
-	FGitStatusParser(const FString& InResult)
-	{
-		TCHAR IndexState = InResult[0];
-		TCHAR WCopyState = InResult[1];
-		if(   (IndexState == 'U' || WCopyState == 'U')
-		   || (IndexState == 'A' && WCopyState == 'A')
-		   || (IndexState == 'D' && WCopyState == 'D'))
-		{
-			// "Unmerged" conflict cases are generally marked with a "U",
-			// but there are also the special cases of both "A"dded, or both "D"eleted
-			State = EWorkingCopyState::Conflicted;
-		}
-		else if(IndexState == 'A')
-		{
-			State = EWorkingCopyState::Added;
-		}
-		else if(IndexState == 'D')
-		{
-			State = EWorkingCopyState::Deleted;
-		}
-		else if(WCopyState == 'D')
-		{
-			State = EWorkingCopyState::Missing;
-		}
-		else if(IndexState == 'M' || WCopyState == 'M')
-		{
-			State = EWorkingCopyState::Modified;
-		}
-		else if(IndexState == 'R')
-		{
-			State = EWorkingCopyState::Renamed;
-		}
-		else if(IndexState == 'C')
-		{
-			State = EWorkingCopyState::Copied;
-		}
-		else if(IndexState == '?' || WCopyState == '?')
-		{
-			State = EWorkingCopyState::NotControlled;
-		}
-		else if(IndexState == '!' || WCopyState == '!')
-		{
-			State = EWorkingCopyState::Ignored;
-		}
-		else
-		{
-			// Unmodified never yield a status
-			State = EWorkingCopyState::Unknown;
-		}
-	}
-
-	EWorkingCopyState::Type State;
-};
-
-/**
- * Extract the status of a unmerged (conflict) file
- *
- * Example output of git ls-files --unmerged Content/Blueprints/BP_Test.uasset
-100644 d9b33098273547b57c0af314136f35b494e16dcb 1	Content/Blueprints/BP_Test.uasset
-100644 a14347dc3b589b78fb19ba62a7e3982f343718bc 2	Content/Blueprints/BP_Test.uasset
-100644 f3137a7167c840847cd7bd2bf07eefbfb2d9bcd2 3	Content/Blueprints/BP_Test.uasset
- *
- * 1: The "common ancestor" of the file (the version of the file that both the current and other branch originated from).
- * 2: The version from the current branch (the master branch in this case).
- * 3: The version from the other branch (the test branch)
-*/
-class FGitConflictStatusParser
-{
-public:
-	/** Parse the unmerge status: extract the base SHA1 identifier of the file */
-	FGitConflictStatusParser(const TArray<FString>& InResults)
-	{
-		const FString& FirstResult = InResults[0]; // 1: The common ancestor of merged branches
-		CommonAncestorFileId = FirstResult.Mid(7, 40);
-	}
-
-	FString CommonAncestorFileId;	///< SHA1 Id of the file (warning: not the commit Id)
-};
-
 /** Execute a command to get the details of a conflict */
 static void RunGetConflictStatus(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InFile, FGitSourceControlState& InOutFileState)
 {
@@ -814,12 +573,11 @@ static void RunGetConflictStatus(const FString& InPathToGitBinary, const FString
 	Files.Add(InFile);
 	TArray<FString> Parameters;
 	Parameters.Add(TEXT("--unmerged"));
-	bool bResult = RunCommandInternal(TEXT("ls-files"), InPathToGitBinary, InRepositoryRoot, Parameters, Files, Results, ErrorMessages);
-	if(bResult && Results.Num() == 3)
+	bool bResult = GitSourceControlCore::RunCommand(TEXT("ls-files"), InPathToGitBinary, InRepositoryRoot, Parameters, Files, Results, ErrorMessages);
+	if(bResult)
 	{
 		// Parse the unmerge status: extract the base revision (or the other branch?)
-		FGitConflictStatusParser ConflictStatus(Results);
-		InOutFileState.PendingMergeBaseFileHash = ConflictStatus.CommonAncestorFileId;
+		GitSourceControlCore::ParseConflictStatus(Results, InOutFileState.PendingMergeBaseFileHash);
 	}
 }
 
@@ -832,18 +590,32 @@ void AbsoluteFilenames(const FString& InRepositoryRoot, TArray<FString>& InFileN
 	}
 }
 
-/** Run a 'git ls-files' command to get all files tracked by Git recursively in a directory.
- *
- * Called in case of a "directory status" (no file listed in the command) when using the "Submit to Source Control" menu.
-*/
-static bool ListFilesInDirectoryRecurse(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InDirectory, TArray<FString>& OutFiles)
+/** Fill the lock state of a file from the result of a "git lfs locks" command */
+static void ParseLockState(const FString& InLfsUserName, const bool InUsingLfsLocking, const TMap<FString, FString>& InLockedFiles, FGitSourceControlState& InOutFileState)
 {
-	TArray<FString> ErrorMessages;
-	TArray<FString> Directory;
-	Directory.Add(InDirectory);
-	const bool bResult = RunCommandInternal(TEXT("ls-files"), InPathToGitBinary, InRepositoryRoot, TArray<FString>(), Directory, OutFiles, ErrorMessages);
-	AbsoluteFilenames(InRepositoryRoot, OutFiles);
-	return bResult;
+	if(const FString* LockUser = InLockedFiles.Find(InOutFileState.LocalFilename))
+	{
+		InOutFileState.LockUser = *LockUser;
+		if(InLfsUserName == InOutFileState.LockUser)
+		{
+			InOutFileState.LockState = ELockState::Locked;
+		}
+		else
+		{
+			InOutFileState.LockState = ELockState::LockedOther;
+		}
+		// TODO LFS Debug log
+		UE_LOG(LogSourceControl, Log, TEXT("Status(%s) Locked by '%s'"), *InOutFileState.LocalFilename, *InOutFileState.LockUser);
+	}
+	else
+	{
+		InOutFileState.LockState = ELockState::NotLocked;
+		// TODO LFS Debug log
+		if (InUsingLfsLocking)
+		{
+			UE_LOG(LogSourceControl, Log, TEXT("Status(%s) Not Locked"), *InOutFileState.LocalFilename);
+		}
+	}
 }
 
 /** Parse the array of strings results of a 'git status' command for a provided list of files all in a common directory
@@ -854,28 +626,46 @@ static bool ListFilesInDirectoryRecurse(const FString& InPathToGitBinary, const
 M  Content/Textures/T_Perlin_Noise_M.uasset
 R  Content/Textures/T_Perlin_Noise_M.uasset -> Content/Textures/T_Perlin_Noise_M2.uasset
 ?? Content/Materials/M_Basic_Wall.uasset
-!! BasicCode.sln
 */
-static void ParseFileStatusResult(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const TArray<FString>& InFiles, const TMap<FString, FString>& InLockedFiles, const TArray<FString>& InResults, TArray<FGitSourceControlState>& OutStates)
+static void ParseFileStatusResult(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const TArray<FString>& InFiles, const TMap<FString, FString>& InLockedFiles, const TArray<FGitStatusEntry>& InEntries, TArray<FGitSourceControlState>& OutStates)
 {
-	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
-	const FString LfsUserName = GitSourceControl.AccessSettings().GetLfsUserName();
+	const TSharedRef<const FGitEngineSettings, ESPMode::ThreadSafe> Settings = GitSourceControlCore::GetEngineSettings();
+	const FString& LfsUserName = Settings->LfsUserName;
 	const FDateTime Now = FDateTime::Now();
 
-	// Iterate on all files explicitly listed in the command
+	// Since 'git status' is not run with '--ignored' (too costly on ignored trees like Intermediate/ or DerivedDataCache/)
+	// ask 'git check-ignore' in one go about all the existing files not found in the status results
+	TArray<int32> IdxResults;
+	IdxResults.Reserve(InFiles.Num());
+	TArray<FString> FilesNotInResults;
 	for(const auto& File : InFiles)
 	{
+		const int32 IdxResult = InEntries.IndexOfByPredicate(FGitStatusFileMatcher(File));
+		IdxResults.Add(IdxResult);
+		if((IdxResult == INDEX_NONE) && FPaths::FileExists(File))
+		{
+			FilesNotInResults.Add(File);
+		}
+	}
+	// (only in the main repository: "check-ignore" refuses paths in submodules, which are then reported as unchanged)
+	const bool bMainRepository = (InRepositoryRoot == Settings->MainRepositoryRoot);
+	const TSet<FString> IgnoredFiles = (bMainRepository && Settings->GetIgnoredFiles) ? Settings->GetIgnoredFiles(FilesNotInResults) : TSet<FString>();
+
+	// Iterate on all files explicitly listed in the command
+	for(int32 IdxFile = 0; IdxFile < InFiles.Num(); IdxFile++)
+	{
+		const FString& File = InFiles[IdxFile];
 		FGitSourceControlState FileState(File, InUsingLfsLocking);
 		// Search the file in the list of status
-		int32 IdxResult = InResults.IndexOfByPredicate(FGitStatusFileMatcher(File));
+		const int32 IdxResult = IdxResults[IdxFile];
 		if(IdxResult != INDEX_NONE)
 		{
 			// File found in status results; only the case for "changed" files
-			FGitStatusParser StatusParser(InResults[IdxResult]);
+			const FGitStatusEntry& Entry = InEntries[IdxResult];
 			// TODO LFS Debug log
-			UE_LOG(LogSourceControl, Log, TEXT("Status(%s) = '%s' => %d"), *File, *InResults[IdxResult], static_cast<int>(StatusParser.State));
+			UE_LOG(LogSourceControl, Log, TEXT("Status(%s) = '%s' => %d"), *File, *Entry.Filename, static_cast<int>(Entry.State));
 
-			FileState.WorkingCopyState = StatusParser.State;
+			FileState.WorkingCopyState = Entry.State;
 			if(FileState.IsConflicted())
 			{
 				// In case of a conflict (unmerged file) get the base revision to merge
@@ -885,7 +675,13 @@ static void ParseFileStatusResult(const FString& InPathToGitBinary, const FStrin
 		else
 		{
 			// File not found in status
-			if(FPaths::FileExists(File))
+			if(IgnoredFiles.Contains(File))
+			{
+				FileState.WorkingCopyState = EWorkingCopyState::Ignored;
+				// TODO LFS Debug log
+				UE_LOG(LogSourceControl, Log, TEXT("Status(%s) not found but ignored"), *File);
+			}
+			else if(FPaths::FileExists(File))
 			{
 				// usually means the file is unchanged,
 				FileState.WorkingCopyState = EWorkingCopyState::Unchanged;
@@ -900,29 +696,7 @@ static void ParseFileStatusResult(const FString& InPathToGitBinary, const FStrin
 				UE_LOG(LogSourceControl, Log, TEXT("Status(%s) not found and does not exists => new/not controled"), *File);
 			}
 		}
-		if(InLockedFiles.Contains(File))
-		{
-			FileState.LockUser = InLockedFiles[File];
-			if(LfsUserName == FileState.LockUser)
-			{
-				FileState.LockState = ELockState::Locked;
-			}
-			else
-			{
-				FileState.LockState = ELockState::LockedOther;
-			}
-			// TODO LFS Debug log
-			UE_LOG(LogSourceControl, Log, TEXT("Status(%s) Locked by '%s'"), *File, *FileState.LockUser);
-		}
-		else
-		{
-			FileState.LockState = ELockState::NotLocked;
-			// TODO LFS Debug log
-			if (InUsingLfsLocking)
-			{
-				UE_LOG(LogSourceControl, Log, TEXT("Status(%s) Not Locked"), *File);
-			}
-		}
+		ParseLockState(LfsUserName, InUsingLfsLocking, InLockedFiles, FileState);
 		FileState.TimeStamp = Now;
 		OutStates.Add(FileState);
 	}
@@ -930,25 +704,51 @@ static void ParseFileStatusResult(const FString& InPathToGitBinary, const FStrin
 
 /** Parse the array of strings results of a 'git status' command for a directory
  *
- *  Called in case of a "directory status" (no file listed in the command) ONLY to detect Deleted/Missing/Untracked files
- * since those files are not listed by the 'git ls-files' command.
+ *  Called in case of a "directory status" (no file listed in the command): only files with a state that differ from "Unchanged"
+ * are reported, that is files listed by the status command (ignored ones included) and files locked with Git LFS. Every other file in the directory
+ * is implicitly "Unchanged", which is handled by the state cache of the provider (see FGitSourceControlProvider::UpdateScannedDirectory())
  *
  * @see #ParseFileStatusResult() above for an example of a 'git status' results
 */
-static void ParseDirectoryStatusResult(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const TArray<FString>& InResults, TArray<FGitSourceControlState>& OutStates)
+static void ParseDirectoryStatusResult(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const FString& InDirectory, const TMap<FString, FString>& InLockedFiles, const TArray<FGitStatusEntry>& InEntries, TArray<FGitSourceControlState>& OutStates)
 {
+	const FString LfsUserName = GitSourceControlCore::GetEngineSettings()->LfsUserName;
+	const FDateTime Now = FDateTime::Now();
+
+	TSet<FString> FilesWithStatus;
+
 	// Iterate on each line of result of the status command
-	for(const FString& Result : InResults)
+	for(const FGitStatusEntry& Entry : InEntries)
 	{
-		const FString RelativeFilename = FilenameFromGitStatus(Result);
-		const FString File = FPaths::ConvertRelativePathToFull(InRepositoryRoot, RelativeFilename);
+		if(EWorkingCopyState::Unknown == Entry.State)
+		{
+			continue;
+		}
+
+		const FString File = FPaths::ConvertRelativePathToFull(InRepositoryRoot, Entry.Filename);
 
 		FGitSourceControlState FileState(File, InUsingLfsLocking);
-		FGitStatusParser StatusParser(Result);
-		if((EWorkingCopyState::Deleted == StatusParser.State) || (EWorkingCopyState::Missing == StatusParser.State) || (EWorkingCopyState::NotControlled == StatusParser.State))
+		FileState.WorkingCopyState = Entry.State;
+		if(FileState.IsConflicted())
+		{
+			// In case of a conflict (unmerged file) get the base revision to merge
+			RunGetConflictStatus(InPathToGitBinary, InRepositoryRoot, File, FileState);
+		}
+		ParseLockState(LfsUserName, InUsingLfsLocking, InLockedFiles, FileState);
+		FileState.TimeStamp = Now;
+		FilesWithStatus.Add(File);
+		OutStates.Add(MoveTemp(FileState));
+	}
+
+	// Files locked with Git LFS but otherwise unchanged also differ from the implicit state
+	for(const auto& LockedFile : InLockedFiles)
+	{
+		if(LockedFile.Key.StartsWith(InDirectory) && !FilesWithStatus.Contains(LockedFile.Key))
 		{
-			FileState.WorkingCopyState = StatusParser.State;
-			FileState.TimeStamp.Now();
+			FGitSourceControlState FileState(LockedFile.Key, InUsingLfsLocking);
+			FileState.WorkingCopyState = FPaths::FileExists(LockedFile.Key) ? EWorkingCopyState::Unchanged : EWorkingCopyState::NotControlled;
+			ParseLockState(LfsUserName, InUsingLfsLocking, InLockedFiles, FileState);
+			FileState.TimeStamp = Now;
 			OutStates.Add(MoveTemp(FileState));
 		}
 	}
@@ -964,55 +764,42 @@ static void ParseDirectoryStatusResult(const FString& InPathToGitBinary, const F
  * @param[in]	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory (can be empty)
  * @param[in]	InUsingLfsLocking	Tells if using the Git LFS file Locking workflow
  * @param[in]	InFiles				List of files in a directory, or the path to the directory itself (never empty).
+ * @param[in]	bInDirectoryStatus	Tells if InFiles is the path to a directory
  * @param[out]	InResults			Results from the "status" command
  * @param[out]	OutStates			States of files for witch the status has been gathered (distinct than InFiles in case of a "directory status")
  */
-static void ParseStatusResults(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const TArray<FString>& InFiles, const TMap<FString, FString>& InLockedFiles, const TArray<FString>& InResults, TArray<FGitSourceControlState>& OutStates)
+static void ParseStatusResults(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const TArray<FString>& InFiles, const bool bInDirectoryStatus, const TMap<FString, FString>& InLockedFiles, const TArray<FString>& InResults, TArray<FGitSourceControlState>& OutStates)
 {
-	if((InFiles.Num() == 1) && FPaths::DirectoryExists(InFiles[0]))
+	TRACE_CPUPROFILER_EVENT_SCOPE(GitSourceControlUtils::ParseStatusResults);
+	SCOPE_CYCLE_COUNTER(STAT_GitParseStatus);
+	TArray<FGitStatusEntry> Entries;
+	Entries.Reserve(InResults.Num());
+	for(const FString& Result : InResults)
+	{
+		Entries.Add(GitSourceControlCore::ParseStatusLine(Result));
+	}
+
+	if(bInDirectoryStatus)
 	{
-		// 1) Special case for "status" of a directory: requires to get the list of files by ourselves.
-		//   (this is triggered by the "Submit to Source Control" menu)
+		// 1) Special case for "status" of a directory: only report files that are not "Unchanged", without enumerating all the files.
+		//   (this is triggered by the Connect operation and by the "Submit to Source Control" menu)
 		// TODO LFS Debug Log
 		UE_LOG(LogSourceControl, Log, TEXT("ParseStatusResults: 1) Special case for status of a directory (%s)"), *InFiles[0]);
-		TArray<FString> Files;
-		const FString& Directory = InFiles[0];
-		const bool bResult = ListFilesInDirectoryRecurse(InPathToGitBinary, InRepositoryRoot, Directory, Files);
-		if(bResult)
-		{
-			ParseFileStatusResult(InPathToGitBinary, InRepositoryRoot, InUsingLfsLocking, Files, InLockedFiles, InResults, OutStates);
-		}
-		// The above cannot detect deleted assets since there is no file left to enumerate (either by the Content Browser or by git ls-files)
-		// => so we also parse the status results to explicitly look for Deleted/Missing assets
-		ParseDirectoryStatusResult(InPathToGitBinary, InRepositoryRoot, InUsingLfsLocking, InResults, OutStates);
+		ParseDirectoryStatusResult(InPathToGitBinary, InRepositoryRoot, InUsingLfsLocking, InFiles[0], InLockedFiles, Entries, OutStates);
 	}
 	else
 	{
 		// 2) General case for one or more files in the same directory.
 		// TODO LFS Debug Log
 		UE_LOG(LogSourceControl, Log, TEXT("ParseStatusResults: 2) General case for one or more files (%s, ...)"), *InFiles[0]);
-		ParseFileStatusResult(InPathToGitBinary, InRepositoryRoot, InUsingLfsLocking, InFiles, InLockedFiles, InResults, OutStates);
+		ParseFileStatusResult(InPathToGitBinary, InRepositoryRoot, InUsingLfsLocking, InFiles, InLockedFiles, Entries, OutStates);
 	}
 }
 
-bool GetAllLocks(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool bAbsolutePaths, TArray<FString>& OutErrorMessages, TMap<FString, FString>& OutLocks)
-{
-	TArray<FString> Results;
-	TArray<FString> ErrorMessages;
-	const bool bResult = RunCommand(TEXT("lfs locks"), InPathToGitBinary, InRepositoryRoot, TArray<FString>(), TArray<FString>(), Results, ErrorMessages);
-	for(const FString& Result : Results)
-	{
-		FGitLfsLocksParser LockFile(InRepositoryRoot, Result, bAbsolutePaths);
-		// TODO LFS Debug log
-		UE_LOG(LogSourceControl, Log, TEXT("LockedFile(%s, %s)"), *LockFile.LocalFilename, *LockFile.LockUser);
-		OutLocks.Add(MoveTemp(LockFile.LocalFilename), MoveTemp(LockFile.LockUser));
-	}
-
-	return bResult;
-}
 
 // Run a batch of Git "status" command to update status of given files and/or directories.
-bool RunUpdateStatus(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const TArray<FString>& InFiles, TArray<FString>& OutErrorMessages, TArray<FGitSourceControlState>& OutStates)
+// Run a Git "status" command and parse it, for files all in the same repository
+static bool RunUpdateStatusInRepository(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const TArray<FString>& InFiles, TArray<FString>& OutErrorMessages, TArray<FGitSourceControlState>& OutStates, TArray<FString>* OutScannedDirectories)
 {
 	bool bResults = true;
 	TMap<FString, FString> LockedFiles;
@@ -1021,15 +808,16 @@ bool RunUpdateStatus(const FString& InPathToGitBinary, const FString& InReposito
 	if(InUsingLfsLocking)
 	{
 		TArray<FString> ErrorMessages;
-		GetAllLocks(InPathToGitBinary, InRepositoryRoot, true, ErrorMessages, LockedFiles);
+		GitSourceControlCore::GetAllLocks(InPathToGitBinary, InRepositoryRoot, true, ErrorMessages, LockedFiles);
 	}
 
 	// Git status does not show any "untracked files" when called with files from different subdirectories! (issue #3)
 	// 1) So here we group files by path (ie. by subdirectory)
+	// and each directory in its own group, since coalesced status requests can mix directories and files
 	TMap<FString, TArray<FString>> GroupOfFiles;
 	for(const auto& File : InFiles)
 	{
-		const FString Path = FPaths::GetPath(*File);
+		const FString Path = FPaths::DirectoryExists(File) ? (File.EndsWith(TEXT("/")) ? File : File + TEXT("/")) : FPaths::GetPath(*File);
 		TArray<FString>* Group = GroupOfFiles.Find(Path);
 		if(Group != nullptr)
 		{
@@ -1043,23 +831,29 @@ bool RunUpdateStatus(const FString& InPathToGitBinary, const FString& InReposito
 		}
 	}
 
-	// Get the current branch name, since we need origin of current branch
-	FString BranchName;
-	GitSourceControlUtils::GetBranchName(InPathToGitBinary, InRepositoryRoot, BranchName);
+	// Files with a newer version on the upstream branch, as of the last fetch (no "ls-remote": this would be a network round trip for each group of files)
+	FDateTime LastFetchTime;
+	bool bNewerFilesCacheHit;
+	const TSharedRef<const TSet<FString>, ESPMode::ThreadSafe> NewerFiles = NewerFilesCache.Get(InPathToGitBinary, InRepositoryRoot, LastFetchTime, bNewerFilesCacheHit);
 
 	TArray<FString> Parameters;
 	Parameters.Add(TEXT("--porcelain"));
-	Parameters.Add(TEXT("--ignored"));
+	// NOTE no "--ignored": ignored files are answered lazily by FGitCheckIgnore
+
+	// A directory status also lists each file of untracked subdirectories, since any file not listed is then implicitly "Unchanged"
+	TArray<FString> DirectoryParameters = Parameters;
+	DirectoryParameters.Add(TEXT("--untracked-files=all"));
 
 	// 2) then we can batch git status operation by subdirectory
 	for(const auto& Files : GroupOfFiles)
 	{
 		// "git status" can only detect renamed and deleted files when it operate on a folder, so use one folder path for all files in a directory
 		const FString Path = FPaths::GetPath(*Files.Value[0]);
+		const bool bDirectoryStatus = (Files.Value.Num() == 1) && FPaths::DirectoryExists(Files.Value[0]);
 		TArray<FString> OnePath;
 		// Only one file: optim very useful for the .uproject file at the root to avoid parsing the whole repository
-		// (works only if the file exists)
-		if((Files.Value.Num() == 1) && (FPaths::FileExists(Files.Value[0])))
+		// (works only if the file exists), and same for the status of only one directory
+		if(((Files.Value.Num() == 1) && (FPaths::FileExists(Files.Value[0]))) || bDirectoryStatus)
 		{
 			OnePath.Add(Files.Value[0]);
 		}
@@ -1070,46 +864,56 @@ bool RunUpdateStatus(const FString& InPathToGitBinary, const FString& InReposito
 		{
 			TArray<FString> Results;
 			TArray<FString> ErrorMessages;
-			const bool bResult = RunCommand(TEXT("status"), InPathToGitBinary, InRepositoryRoot, Parameters, OnePath, Results, ErrorMessages);
+			const bool bResult = GitSourceControlCore::RunCommand(TEXT("status"), InPathToGitBinary, InRepositoryRoot, bDirectoryStatus ? DirectoryParameters : Parameters, OnePath, Results, ErrorMessages);
 			OutErrorMessages.Append(ErrorMessages);
 			if(bResult)
 			{
-				ParseStatusResults(InPathToGitBinary, InRepositoryRoot, InUsingLfsLocking, Files.Value, LockedFiles, Results, OutStates);
+				if(bDirectoryStatus)
+				{
+					// Normalize the directory with a trailing slash, to only match files inside of it
+					FString Directory = Files.Value[0];
+					if(!Directory.EndsWith(TEXT("/")))
+					{
+						Directory += TEXT("/");
+					}
+					ParseStatusResults(InPathToGitBinary, InRepositoryRoot, InUsingLfsLocking, { Directory }, true, LockedFiles, Results, OutStates);
+					if(OutScannedDirectories)
+					{
+						OutScannedDirectories->Add(MoveTemp(Directory));
+					}
+				}
+				else
+				{
+					ParseStatusResults(InPathToGitBinary, InRepositoryRoot, InUsingLfsLocking, Files.Value, false, LockedFiles, Results, OutStates);
+				}
 			}
 		}
 
-		if (!BranchName.IsEmpty())
+		if (NewerFiles->Num() > 0)
 		{
-			// Using git diff, we can obtain a list of files that were modified between our current origin and HEAD. Assumes that fetch has been run to get accurate info.
-			// TODO: should do a fetch (at least periodically).
-			TArray<FString> Results;
-			TArray<FString> ErrorMessages;
-			TArray<FString> ParametersLsRemote;
-			ParametersLsRemote.Add(TEXT("origin"));
-			ParametersLsRemote.Add(BranchName);
-			const bool bResultLsRemote = RunCommand(TEXT("ls-remote"), InPathToGitBinary, InRepositoryRoot, ParametersLsRemote, OnePath, Results, ErrorMessages);
-			// If the command is successful and there is only 1 line on the output the branch exists on remote
-			const bool bDiffAgainstRemote = bResultLsRemote && Results.Num();
-
-			Results.Reset();
-			ErrorMessages.Reset();
-			TArray<FString> ParametersLog;
-			ParametersLog.Add(TEXT("--pretty=")); // this omits the commit lines, just gets us files
-			ParametersLog.Add(TEXT("--name-only"));
-			ParametersLog.Add(bDiffAgainstRemote ? TEXT("HEAD..HEAD@{upstream}") : BranchName);
-			const bool bResultDiff = RunCommand(TEXT("log"), InPathToGitBinary, InRepositoryRoot, ParametersLog, OnePath, Results, ErrorMessages);
-			OutErrorMessages.Append(ErrorMessages);
-			if (bResultDiff)
+			// Only the newer files in the path of this status (the directory, or the single file)
+			const FString PathPrefix = (FPaths::DirectoryExists(OnePath[0]) && !OnePath[0].EndsWith(TEXT("/"))) ? OnePath[0] + TEXT("/") : OnePath[0];
+			for (const FString& NewerFilePath : *NewerFiles)
 			{
-				for (const FString& NewerFileName : Results)
+				if (!NewerFilePath.StartsWith(PathPrefix))
 				{
-					const FString NewerFilePath = FPaths::ConvertRelativePathToFull(InRepositoryRoot, NewerFileName);
+					continue;
+				}
 
-					// Find existing corresponding file state to update it (not found would mean new file or not in the current path)
-					if (FGitSourceControlState* FileStatePtr = OutStates.FindByPredicate([NewerFilePath](FGitSourceControlState& FileState) { return FileState.LocalFilename == NewerFilePath; }))
-					{
-						FileStatePtr->bNewerVersionOnServer = true;
-					}
+				// Find existing corresponding file state to update it (not found would mean new file or not in the current path)
+				if (FGitSourceControlState* FileStatePtr = OutStates.FindByPredicate([&NewerFilePath](FGitSourceControlState& FileState) { return FileState.LocalFilename == NewerFilePath; }))
+				{
+					FileStatePtr->bNewerVersionOnServer = true;
+				}
+				else if (bDirectoryStatus && FPaths::FileExists(NewerFilePath))
+				{
+					// In a directory status, an unchanged file is not reported unless it is not current
+					FGitSourceControlState FileState(NewerFilePath, InUsingLfsLocking);
+					FileState.WorkingCopyState = EWorkingCopyState::Unchanged;
+					FileState.LockState = ELockState::NotLocked;
+					FileState.bNewerVersionOnServer = true;
+					FileState.TimeStamp = FDateTime::Now();
+					OutStates.Add(MoveTemp(FileState));
 				}
 			}
 		}
@@ -1118,254 +922,197 @@ bool RunUpdateStatus(const FString& InPathToGitBinary, const FString& InReposito
 	return bResults;
 }
 
-// Run a Git `cat-file --filters` command to dump the binary content of a revision into a file.
-bool RunDumpToFile(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InParameter, const FString& InDumpFileName)
+/** Status metrics by repository, see GetRepositoryStatusMetrics() */
+static FCriticalSection RepositoryStatusMetricsCriticalSection;
+static TMap<FString, FGitRepositoryStatusMetrics> RepositoryStatusMetrics;
+
+static void AddRepositoryStatusMetrics(const FString& InRepositoryRoot, const int32 InNumFiles, const double InDuration)
 {
-	int32 ReturnCode = -1;
-	FString FullCommand;
+	FScopeLock ScopeLock(&RepositoryStatusMetricsCriticalSection);
+	FGitRepositoryStatusMetrics& Metrics = RepositoryStatusMetrics.FindOrAdd(InRepositoryRoot);
+	Metrics.NumStatus++;
+	Metrics.NumFiles += InNumFiles;
+	Metrics.LastDuration = InDuration;
+	Metrics.MaxDuration = FMath::Max(Metrics.MaxDuration, InDuration);
+	Metrics.TotalDuration += InDuration;
+}
 
-	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
-	const FGitVersion& GitVersion = GitSourceControl.GetProvider().GetGitVersion();
 
-	if(!InRepositoryRoot.IsEmpty())
-	{
-		// Specify the working copy (the root) of the git repository (before the command itself)
-		FullCommand  = TEXT("-C \"");
-		FullCommand += InRepositoryRoot;
-		FullCommand += TEXT("\" ");
-	}
+TMap<FString, FGitRepositoryStatusMetrics> GetRepositoryStatusMetrics()
+{
+	FScopeLock ScopeLock(&RepositoryStatusMetricsCriticalSection);
+	return RepositoryStatusMetrics;
+}
 
-	// then the git command itself
-	if(GitVersion.bHasCatFileWithFilters)
-	{
-		// Newer versions (2.9.3.windows.2) support smudge/clean filters used by Git LFS, git-fat, git-annex, etc
-		FullCommand += TEXT("cat-file --filters ");
-	}
-	else
+
+bool GetNewerFilesOnServer(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InFiles, TArray<FString>& OutNewerFiles, FDateTime& OutLastFetchTime)
+{
+	bool bCacheHit;
+	const TSharedRef<const TSet<FString>, ESPMode::ThreadSafe> NewerFiles = NewerFilesCache.Get(InPathToGitBinary, InRepositoryRoot, OutLastFetchTime, bCacheHit);
+	for(const FString& File : InFiles)
 	{
-		// Previous versions fall-back on "git show" like before
-		FullCommand += TEXT("show ");
+		if(NewerFiles->Contains(File))
+		{
+			OutNewerFiles.Add(File);
+		}
 	}
+	return bCacheHit;
+}
 
-	// Append to the command the parameter
-	FullCommand += InParameter;
-
-	const bool bLaunchDetached = false;
-	const bool bLaunchHidden = true;
-	const bool bLaunchReallyHidden = bLaunchHidden;
-
-	void* PipeRead = nullptr;
-	void* PipeWrite = nullptr;
-
-	verify(FPlatformProcess::CreatePipe(PipeRead, PipeWrite));
-
-	UE_LOG(LogSourceControl, Log, TEXT("RunDumpToFile: 'git %s'"), *FullCommand);
-
-    FString PathToGitOrEnvBinary = InPathToGitBinary;
-    #if PLATFORM_MAC
-        // The Cocoa application does not inherit shell environment variables, so add the path expected to have git-lfs to PATH
-        FString PathEnv = FPlatformMisc::GetEnvironmentVariable(TEXT("PATH"));
-        FString GitInstallPath = FPaths::GetPath(InPathToGitBinary);
-
-        TArray<FString> PathArray;
-        PathEnv.ParseIntoArray(PathArray, FPlatformMisc::GetPathVarDelimiter());
-        bool bHasGitInstallPath = false;
-        for (auto Path : PathArray)
-        {
-            if (GitInstallPath.Equals(Path, ESearchCase::CaseSensitive))
-            {
-                bHasGitInstallPath = true;
-                break;
-            }
-        }
+bool RunUpdateStatus(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const TArray<FString>& InFiles, TArray<FString>& OutErrorMessages, TArray<FGitSourceControlState>& OutStates, TArray<FString>* OutScannedDirectories /* = nullptr */)
+{
+	const TSharedRef<const FGitEngineSettings, ESPMode::ThreadSafe> Settings = GitSourceControlCore::GetEngineSettings();
+	const TArray<FString>& NestedRepositories = Settings->NestedRepositories;
 
-        if (!bHasGitInstallPath)
-        {
-            PathToGitOrEnvBinary = FString("/usr/bin/env");
-            FullCommand = FString::Printf(TEXT("PATH=\"%s%s%s\" \"%s\" %s"), *GitInstallPath, FPlatformMisc::GetPathVarDelimiter(), *PathEnv, *InPathToGitBinary, *FullCommand);
-        }
-    #endif
-    
-	FProcHandle ProcessHandle = FPlatformProcess::CreateProc(*PathToGitOrEnvBinary, *FullCommand, bLaunchDetached, bLaunchHidden, bLaunchReallyHidden, nullptr, 0, *InRepositoryRoot, PipeWrite);
-	if(ProcessHandle.IsValid())
+	// Partition the files by the repository they belong to (submodules, or independent repositories of plugins)
+	// and add the nested repositories under a requested directory, since the status of the outer repository does not cover them
+	TMap<FString, TArray<FString>> FilesByRepository;
+	for(const FString& File : InFiles)
 	{
-		FPlatformProcess::Sleep(0.01);
-
-		TArray<uint8> BinaryFileContent;
-		while(FPlatformProcess::IsProcRunning(ProcessHandle))
-		{
-			TArray<uint8> BinaryData;
-			FPlatformProcess::ReadPipeToArray(PipeRead, BinaryData);
-			if(BinaryData.Num() > 0)
-			{
-				BinaryFileContent.Append(MoveTemp(BinaryData));
-			}
-		}
-		TArray<uint8> BinaryData;
-		FPlatformProcess::ReadPipeToArray(PipeRead, BinaryData);
-		if(BinaryData.Num() > 0)
+		const bool bIsDirectory = FPaths::DirectoryExists(File);
+		FString RepositoryRoot;
+		if(NestedRepositories.Num() == 0 || !GitSourceControlCore::FindRootDirectory(bIsDirectory ? File : FPaths::GetPath(File), RepositoryRoot))
 		{
-			BinaryFileContent.Append(MoveTemp(BinaryData));
+			RepositoryRoot = InRepositoryRoot;
 		}
+		FilesByRepository.FindOrAdd(RepositoryRoot).Add(File);
 
-		FPlatformProcess::GetProcReturnCode(ProcessHandle, &ReturnCode);
-		if(ReturnCode == 0)
+		if(bIsDirectory)
 		{
-			// Save buffer into temp file
-			if(FFileHelper::SaveArrayToFile(BinaryFileContent, *InDumpFileName))
-			{
-				UE_LOG(LogSourceControl, Log, TEXT("Writed '%s' (%do)"), *InDumpFileName, BinaryFileContent.Num());
-			}
-			else
+			const FString Directory = File.EndsWith(TEXT("/")) ? File : File + TEXT("/");
+			for(const FString& NestedRepository : NestedRepositories)
 			{
-				UE_LOG(LogSourceControl, Error, TEXT("Could not write %s"), *InDumpFileName);
-				ReturnCode = -1;
+				if(NestedRepository.StartsWith(Directory) && (NestedRepository != RepositoryRoot))
+				{
+					FilesByRepository.FindOrAdd(NestedRepository).AddUnique(NestedRepository + TEXT("/"));
+				}
 			}
 		}
-		else
-		{
-			UE_LOG(LogSourceControl, Error, TEXT("DumpToFile: ReturnCode=%d"), ReturnCode);
-		}
+	}
 
-		FPlatformProcess::CloseProc(ProcessHandle);
+	// Run the status of each repository in parallel (the calling thread taking its share of the repositories, with a fan-out
+	// bounded by the number of task graph workers), so that the latency is the one of the slowest repository, not the sum of them
+	struct FRepositoryStatus
+	{
+		bool bResult = true;
+		TArray<FString> ErrorMessages;
+		TArray<FGitSourceControlState> States;
+		TArray<FString> ScannedDirectories;
+	};
+	auto RunRepositoryStatus = [InPathToGitBinary, InUsingLfsLocking, Worker = GitSourceControlCore::GetWorkerOnThread()](const FString& InRoot, const TArray<FString>& InRepositoryFiles)
+	{
+		FGitScopedWorkerName ScopedWorkerName(Worker);
+		const double StartTime = FPlatformTime::Seconds();
+		FRepositoryStatus Status;
+		Status.bResult = RunUpdateStatusInRepository(InPathToGitBinary, InRoot, InUsingLfsLocking, InRepositoryFiles, Status.ErrorMessages, Status.States, &Status.ScannedDirectories);
+		AddRepositoryStatusMetrics(InRoot, InRepositoryFiles.Num(), FPlatformTime::Seconds() - StartTime);
+		return Status;
+	};
+
+	TArray<const TPair<FString, TArray<FString>>*> Repositories;
+	for(const auto& RepositoryFiles : FilesByRepository)
+	{
+		Repositories.Add(&RepositoryFiles);
+	}
+
+	TArray<FRepositoryStatus> Results;
+	Results.SetNum(Repositories.Num());
+	if(Repositories.Num() == 1)
+	{
+		Results[0] = RunRepositoryStatus(Repositories[0]->Key, Repositories[0]->Value);
 	}
 	else
 	{
-		UE_LOG(LogSourceControl, Error, TEXT("Failed to launch 'git cat-file'"));
+		ParallelFor(Repositories.Num(), [&Repositories, &Results, &RunRepositoryStatus](const int32 InIndex)
+		{
+			Results[InIndex] = RunRepositoryStatus(Repositories[InIndex]->Key, Repositories[InIndex]->Value);
+		});
 	}
 
-	FPlatformProcess::ClosePipe(PipeRead, PipeWrite);
-
-	return (ReturnCode == 0);
-}
+	bool bResults = true;
 
-/**
- * Translate file actions from the given Git log --name-status command to keywords used by the Editor UI.
- *
- * @see https://www.kernel.org/pub/software/scm/git/docs/git-log.html
- * ' ' = unmodified
- * 'M' = modified
- * 'A' = added
- * 'D' = deleted
- * 'R' = renamed
- * 'C' = copied
- * 'T' = type changed
- * 'U' = updated but unmerged
- * 'X' = unknown
- * 'B' = broken pairing
- *
- * @see SHistoryRevisionListRowContent::GenerateWidgetForColumn(): "add", "edit", "delete", "branch" and "integrate" (everything else is taken like "edit")
-*/
-static FString LogStatusToString(TCHAR InStatus)
-{
-	switch(InStatus)
-	{
-	case TEXT(' '):
-		return FString("unmodified");
-	case TEXT('M'):
-		return FString("modified");
-	case TEXT('A'): // added: keyword "add" to display a specific icon instead of the default "edit" action one
-		return FString("add");
-	case TEXT('D'): // deleted: keyword "delete" to display a specific icon instead of the default "edit" action one
-		return FString("delete");
-	case TEXT('R'): // renamed keyword "branch" to display a specific icon instead of the default "edit" action one
-		return FString("branch");
-	case TEXT('C'): // copied keyword "branch" to display a specific icon instead of the default "edit" action one
-		return FString("branch");
-	case TEXT('T'):
-		return FString("type changed");
-	case TEXT('U'):
-		return FString("unmerged");
-	case TEXT('X'):
-		return FString("unknown");
-	case TEXT('B'):
-		return FString("broked pairing");
+	// Merge the results of all repositories
+	for(FRepositoryStatus& Result : Results)
+	{
+		bResults &= Result.bResult;
+		OutErrorMessages.Append(MoveTemp(Result.ErrorMessages));
+		OutStates.Append(MoveTemp(Result.States));
+		if(OutScannedDirectories)
+		{
+			OutScannedDirectories->Append(MoveTemp(Result.ScannedDirectories));
+		}
 	}
 
-	return FString();
+	return bResults;
 }
 
-/**
- * Parse the array of strings results of a 'git log' command
- *
- * Example git log results:
-commit 97a4e7626681895e073aaefd68b8ac087db81b0b
-Author: Sébastien Rombauts <sebastien.rombauts@gmail.com>
-Date:   2014-2015-05-15 21:32:27 +0200
-
-    Another commit used to test History
-
-     - with many lines
-     - some <xml>
-     - and strange characteres $*+
-
-M	Content/Blueprints/Blueprint_CeilingLight.uasset
-R100	Content/Textures/T_Concrete_Poured_D.uasset Content/Textures/T_Concrete_Poured_D2.uasset
-
-commit 355f0df26ebd3888adbb558fd42bb8bd3e565000
-Author: Sébastien Rombauts <sebastien.rombauts@gmail.com>
-Date:   2014-2015-05-12 11:28:14 +0200
-
-    Testing git status, edit, and revert
-
-A	Content/Blueprints/Blueprint_CeilingLight.uasset
-C099	Content/Textures/T_Concrete_Poured_N.uasset Content/Textures/T_Concrete_Poured_N2.uasset
-*/
-static void ParseLogResults(const TArray<FString>& InResults, TGitSourceControlHistory& OutHistory)
+TArray<FString> FindNestedRepositories(const FString& InPathToGitBinary, const FString& InRepositoryRoot)
 {
-	TSharedRef<FGitSourceControlRevision, ESPMode::ThreadSafe> SourceControlRevision = MakeShareable(new FGitSourceControlRevision);
-	for(const auto& Result : InResults)
-	{
-		if(Result.StartsWith(TEXT("commit "))) // Start of a new commit
-		{
-			// End of the previous commit
-			if(SourceControlRevision->RevisionNumber != 0)
-			{
-				OutHistory.Add(MoveTemp(SourceControlRevision));
+	TArray<FString> Repositories;
 
-				SourceControlRevision = MakeShareable(new FGitSourceControlRevision);
-			}
-			SourceControlRevision->CommitId = Result.RightChop(7); // Full commit SHA1 hexadecimal string
-			SourceControlRevision->ShortCommitId = SourceControlRevision->CommitId.Left(8); // Short revision ; first 8 hex characters (max that can hold a 32 bit integer)
-			SourceControlRevision->CommitIdNumber = FParse::HexNumber(*SourceControlRevision->ShortCommitId);
-			SourceControlRevision->RevisionNumber = -1; // RevisionNumber will be set at the end, based off the index in the History
-		}
-		else if(Result.StartsWith(TEXT("Author: "))) // Author name & email
-		{
-			// Remove the 'email' part of the UserName
-			FString UserNameEmail = Result.RightChop(8);
-			int32 EmailIndex = 0;
-			if(UserNameEmail.FindLastChar('<', EmailIndex))
-			{
-				SourceControlRevision->UserName = UserNameEmail.Left(EmailIndex - 1);
-			}
-		}
-		else if(Result.StartsWith(TEXT("Date:   "))) // Commit date
-		{
-			FString Date = Result.RightChop(8);
-			SourceControlRevision->Date = FDateTime::FromUnixTimestamp(FCString::Atoi(*Date));
-		}
-	//	else if(Result.IsEmpty()) // empty line before/after commit message has already been taken care by FString::ParseIntoArray()
-		else if(Result.StartsWith(TEXT("    ")))  // Multi-lines commit message
+	// Submodules, recursively: " <sha1> <path> (<describe>)", or "-<sha1> <path>" if not initialized
+	TArray<FString> Results;
+	TArray<FString> ErrorMessages;
+	TArray<FString> Parameters;
+	Parameters.Add(TEXT("status"));
+	Parameters.Add(TEXT("--recursive"));
+	GitSourceControlCore::RunCommand(TEXT("submodule"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), Results, ErrorMessages);
+	for(const FString& Result : Results)
+	{
+		TArray<FString> Tokens;
+		Result.Mid(1).ParseIntoArrayWS(Tokens);
+		if(!Result.StartsWith(TEXT("-")) && (Tokens.Num() >= 2))
 		{
-			SourceControlRevision->Description += Result.RightChop(4);
-			SourceControlRevision->Description += TEXT("\n");
+			Repositories.AddUnique(FPaths::ConvertRelativePathToFull(InRepositoryRoot, Tokens[1]));
 		}
-		else // Name of the file, starting with an uppercase status letter ("A"/"M"...)
+	}
+
+	// Independent repositories of plugins, not declared as submodules: "Plugins/<Plugin>/.git" or "Plugins/<Category>/<Plugin>/.git"
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TFunction<void(const FString&, int32)> FindRepositories = [&](const FString& InDirectory, int32 InDepth)
+	{
+		PlatformFile.IterateDirectory(*InDirectory, [&](const TCHAR* InFilenameOrDirectory, bool bInIsDirectory)
 		{
-			const TCHAR Status = Result[0];
-			SourceControlRevision->Action = LogStatusToString(Status); // Readable action string ("Added", Modified"...) instead of "A"/"M"...
-			// Take care of special case for Renamed/Copied file: extract the second filename after second tabulation
-			int32 IdxTab;
-			if(Result.FindLastChar('\t', IdxTab))
+			if(bInIsDirectory)
 			{
-				SourceControlRevision->Filename = Result.RightChop(IdxTab + 1); // relative filename
+				const FString Directory = InFilenameOrDirectory;
+				if(PlatformFile.DirectoryExists(*(Directory / TEXT(".git"))) || PlatformFile.FileExists(*(Directory / TEXT(".git"))))
+				{
+					Repositories.AddUnique(FPaths::ConvertRelativePathToFull(Directory));
+				}
+				else if(InDepth > 1)
+				{
+					FindRepositories(Directory, InDepth - 1);
+				}
 			}
-		}
-	}
-	// End of the last commit
-	if(SourceControlRevision->RevisionNumber != 0)
+			return true;
+		});
+	};
+	FindRepositories(FPaths::ConvertRelativePathToFull(FPaths::ProjectPluginsDir()), 2);
+
+	Repositories.Remove(InRepositoryRoot);
+	for(const FString& Repository : Repositories)
 	{
+		UE_LOG(LogSourceControl, Log, TEXT("Nested repository '%s'"), *Repository);
+	}
+	return Repositories;
+}
+
+
+/** Convert the commits of the log of a file to its history, setting the revision number of each revision based on its index */
+static void HistoryFromLogEntries(TArray<FGitLogEntry>&& InEntries, TGitSourceControlHistory& OutHistory)
+{
+	for(FGitLogEntry& Entry : InEntries)
+	{
+		TSharedRef<FGitSourceControlRevision, ESPMode::ThreadSafe> SourceControlRevision = MakeShareable(new FGitSourceControlRevision);
+		SourceControlRevision->CommitId = MoveTemp(Entry.CommitId);
+		SourceControlRevision->ShortCommitId = MoveTemp(Entry.ShortCommitId);
+		SourceControlRevision->CommitIdNumber = Entry.CommitIdNumber;
+		SourceControlRevision->UserName = MoveTemp(Entry.UserName);
+		SourceControlRevision->Date = Entry.Date;
+		SourceControlRevision->Description = MoveTemp(Entry.Description);
+		SourceControlRevision->Action = MoveTemp(Entry.Action);
+		SourceControlRevision->Filename = MoveTemp(Entry.Filename);
 		OutHistory.Add(MoveTemp(SourceControlRevision));
 	}
 
@@ -1383,35 +1130,12 @@ static void ParseLogResults(const TArray<FString>& InResults, TGitSourceControlH
 	}
 }
 
-/**
- * Extract the SHA1 identifier and size of a blob (file) from a Git "ls-tree" command.
- *
- * Example output for the command git ls-tree --long 7fdaeb2 Content/Blueprints/BP_Test.uasset
-100644 blob a14347dc3b589b78fb19ba62a7e3982f343718bc   70731	Content/Blueprints/BP_Test.uasset
-*/
-class FGitLsTreeParser
-{
-public:
-	/** Parse the unmerge status: extract the base SHA1 identifier of the file */
-	FGitLsTreeParser(const TArray<FString>& InResults)
-	{
-		const FString& FirstResult = InResults[0];
-		FileHash = FirstResult.Mid(12, 40);
-		int32 IdxTab;
-		if(FirstResult.FindChar('\t', IdxTab))
-		{
-			const FString SizeString = FirstResult.Mid(53, IdxTab - 53);
-			FileSize = FCString::Atoi(*SizeString);
-		}
-	}
-
-	FString FileHash;	///< SHA1 Id of the file (warning: not the commit Id)
-	int32	FileSize;	///< Size of the file (in bytes)
-};
-
 // Run a Git "log" command and parse it.
 bool RunGetHistory(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InFile, bool bMergeConflict, TArray<FString>& OutErrorMessages, TGitSourceControlHistory& OutHistory)
 {
+	// The filenames of the revisions are relative to the repository of the file, where all the commands below have to run
+	const FString RepositoryRoot = GitSourceControlCore::FindRepositoryOfFile(InRepositoryRoot, InFile);
+
 	bool bResults;
 	{
 		TArray<FString> Results;
@@ -1429,14 +1153,18 @@ bool RunGetHistory(const FString& InPathToGitBinary, const FString& InRepository
 		}
 		TArray<FString> Files;
 		Files.Add(*InFile);
-		bResults = RunCommand(TEXT("log"), InPathToGitBinary, InRepositoryRoot, Parameters, Files, Results, OutErrorMessages);
+		bResults = GitSourceControlCore::RunCommand(TEXT("log"), InPathToGitBinary, RepositoryRoot, Parameters, Files, Results, OutErrorMessages);
 		if(bResults)
 		{
-			ParseLogResults(Results, OutHistory);
+			TArray<FGitLogEntry> Entries;
+			GitSourceControlCore::ParseLogResults(Results, Entries);
+			HistoryFromLogEntries(MoveTemp(Entries), OutHistory);
 		}
 	}
 	for(auto& Revision : OutHistory)
 	{
+		Revision->PathToRepositoryRoot = RepositoryRoot;
+
 		// Get file (blob) sha1 id and size
 		TArray<FString> Results;
 		TArray<FString> Parameters;
@@ -1444,11 +1172,11 @@ bool RunGetHistory(const FString& InPathToGitBinary, const FString& InRepository
 		Parameters.Add(Revision->GetRevision());
 		TArray<FString> Files;
 		Files.Add(*Revision->GetFilename());
-		bResults &= RunCommand(TEXT("ls-tree"), InPathToGitBinary, InRepositoryRoot, Parameters, Files, Results, OutErrorMessages);
-		if(bResults && Results.Num())
+		bResults &= GitSourceControlCore::RunCommand(TEXT("ls-tree"), InPathToGitBinary, RepositoryRoot, Parameters, Files, Results, OutErrorMessages);
+		FGitLsTreeEntry LsTree;
+		if(bResults && GitSourceControlCore::ParseLsTree(Results, LsTree))
 		{
-			FGitLsTreeParser LsTree(Results);
-			Revision->FileHash = LsTree.FileHash;
+			Revision->FileHash = MoveTemp(LsTree.FileHash);
 			Revision->FileSize = LsTree.FileSize;
 		}
 	}
@@ -1489,8 +1217,36 @@ TArray<FString> AbsoluteFilenames(const TArray<FString>& InFileNames, const FStr
 	return AbsFiles;
 }
 
-bool UpdateCachedStates(const TArray<FGitSourceControlState>& InStates)
+/** Tell if two states of a same file are the same as seen by the Editor (the History and TimeStamp are not compared) */
+static bool IsSameState(const FGitSourceControlState& InState, const FGitSourceControlState& InOtherState)
 {
+	return (InState.WorkingCopyState == InOtherState.WorkingCopyState)
+		&& (InState.LockState == InOtherState.LockState)
+		&& (InState.LockUser == InOtherState.LockUser)
+		&& (InState.PendingMergeBaseFileHash == InOtherState.PendingMergeBaseFileHash)
+		&& (InState.bUsingGitLfsLocking == InOtherState.bUsingGitLfsLocking)
+		&& (InState.bNewerVersionOnServer == InOtherState.bNewerVersionOnServer);
+}
+
+bool IsSameHistory(const TGitSourceControlHistory& InHistory, const TGitSourceControlHistory& InOtherHistory)
+{
+	if(InHistory.Num() != InOtherHistory.Num())
+	{
+		return false;
+	}
+	for(int32 Index = 0; Index < InHistory.Num(); Index++)
+	{
+		if(InHistory[Index]->CommitId != InOtherHistory[Index]->CommitId)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool UpdateCachedStates(TArray<FGitSourceControlState>&& InStates)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GitUpdateCachedStates);
 	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>( "GitSourceControl" );
 	FGitSourceControlProvider& Provider = GitSourceControl.GetProvider();
 	const bool bUsingGitLfsLocking = GitSourceControl.AccessSettings().IsUsingGitLfsLocking();
@@ -1498,14 +1254,88 @@ bool UpdateCachedStates(const TArray<FGitSourceControlState>& InStates)
 	// TODO without LFS : Workaround a bug with the Source Control Module not updating file state after a simple "Save" with no "Checkout" (when not using File Lock)
 	const FDateTime Now = bUsingGitLfsLocking ? FDateTime::Now() : FDateTime();
 
-	for(const auto& InState : InStates)
+	FRWScopeLock ScopeLock(Provider.GetStateCacheLock(), SLT_Write);
+
+	bool bUpdated = false;
+	for(auto& InState : InStates)
 	{
-		TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe> State = Provider.GetStateInternal(InState.LocalFilename);
-		*State = InState;
-		State->TimeStamp = Now;
+		TSharedRef<FGitSourceControlState, ESPMode::ThreadSafe>* CachedState = Provider.FindStateInternal(InState.LocalFilename);
+		if(CachedState == nullptr)
+		{
+			// First state of this file: move the whole state into a new cache entry
+			InState.TimeStamp = Now;
+			Provider.MarkStateChanged(InState.LocalFilename);
+			Provider.AddStateInternal(MoveTemp(InState));
+			bUpdated = true;
+			continue;
+		}
+
+		// The time stamp tells the Editor when the state was last confirmed, even if nothing changed
+		FGitSourceControlState& State = **CachedState;
+		State.TimeStamp = Now;
+		State.bStale = false;
+		State.Fingerprint = InState.Fingerprint;
+		if(IsSameState(State, InState))
+		{
+			// Nothing changed: keep the cached state (and its history), so this refresh does not invalidate anything
+			continue;
+		}
+
+		// Move only the fields that changed, and never reassign an identical history
+		State.WorkingCopyState = InState.WorkingCopyState;
+		State.LockState = InState.LockState;
+		State.bUsingGitLfsLocking = InState.bUsingGitLfsLocking;
+		State.bNewerVersionOnServer = InState.bNewerVersionOnServer;
+		if(State.LockUser != InState.LockUser)
+		{
+			State.LockUser = MoveTemp(InState.LockUser);
+		}
+		if(State.PendingMergeBaseFileHash != InState.PendingMergeBaseFileHash)
+		{
+			State.PendingMergeBaseFileHash = MoveTemp(InState.PendingMergeBaseFileHash);
+		}
+		if(!IsSameHistory(State.History, InState.History))
+		{
+			State.History = MoveTemp(InState.History);
+		}
+		Provider.MarkStateChanged(State.LocalFilename);
+		bUpdated = true;
+	}
+
+	// The content of the states has been moved to the cache
+	InStates.Empty();
+
+	return bUpdated;
+}
+
+bool UpdateCachedStates(TArray<FGitSourceControlState>&& InStates, const TArray<FString>& InScannedDirectories)
+{
+	SCOPE_CYCLE_COUNTER(STAT_GitUpdateCachedStates);
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>( "GitSourceControl" );
+	FGitSourceControlProvider& Provider = GitSourceControl.GetProvider();
+
+	// Gather the files with an explicit state before their states are moved to the cache
+	TSet<FString> FilesWithStatus;
+	if(InScannedDirectories.Num() > 0)
+	{
+		FilesWithStatus.Reserve(InStates.Num());
+		for(const auto& InState : InStates)
+		{
+			FilesWithStatus.Add(InState.LocalFilename);
+		}
+	}
+
+	bool bUpdated = UpdateCachedStates(MoveTemp(InStates));
+
+	if(InScannedDirectories.Num() > 0)
+	{
+		for(const FString& Directory : InScannedDirectories)
+		{
+			bUpdated |= Provider.UpdateScannedDirectory(Directory, FilesWithStatus);
+		}
 	}
 
-	return (InStates.Num() > 0);
+	return bUpdated;
 }
 
 /**
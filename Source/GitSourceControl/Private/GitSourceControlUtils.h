@@ -6,10 +6,17 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "GitSourceControlProcess.h"
 #include "GitSourceControlState.h"
 
 class FGitSourceControlCommand;
 
+// NOTE the stats of the git processes and of their parsers are in GitSourceControlProcess.h, in the same group
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Execute worker"), STAT_GitExecuteWorker, STATGROUP_GitSourceControl, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Parse status"), STAT_GitParseStatus, STATGROUP_GitSourceControl, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update cached states"), STAT_GitUpdateCachedStates, STATGROUP_GitSourceControl, );
+
 /**
  * Helper struct for maintaining temporary files for passing to commands
  */
@@ -33,6 +40,21 @@ private:
 
 struct FGitVersion;
 
+/** Metrics of the status commands run in a repository, see GitSourceControlUtils::GetRepositoryStatusMetrics() */
+struct FGitRepositoryStatusMetrics
+{
+	/** Number of status commands run in the repository */
+	int32 NumStatus = 0;
+
+	/** Total number of files (or directories) requested */
+	int32 NumFiles = 0;
+
+	/** Durations of the status commands, in seconds */
+	double LastDuration = 0.0;
+	double MaxDuration = 0.0;
+	double TotalDuration = 0.0;
+};
+
 namespace GitSourceControlUtils
 {
 
@@ -40,7 +62,7 @@ namespace GitSourceControlUtils
  * Find the path to the Git binary, looking into a few places (standalone Git install, and other common tools embedding Git)
  * @returns the path to the Git binary if found, or an empty string.
  */
-FString FindGitBinaryPath();
+GITSOURCECONTROL_API FString FindGitBinaryPath();
 
 /**
  * Run a Git "version" command to check the availability of the binary.
@@ -48,7 +70,7 @@ FString FindGitBinaryPath();
  * @param OutGitVersion         If provided, populate with the git version parsed from "version" command
  * @returns true if the command succeeded and returned no errors
  */
-bool CheckGitAvailability(const FString& InPathToGitBinary, FGitVersion* OutVersion = nullptr);
+GITSOURCECONTROL_API bool CheckGitAvailability(const FString& InPathToGitBinary, FGitVersion* OutVersion = nullptr);
 
 /**
  * Parse the output from the "version" command into GitMajorVersion and GitMinorVersion.
@@ -72,21 +94,26 @@ void FindGitCapabilities(const FString& InPathToGitBinary, FGitVersion *OutVersi
  void FindGitLfsCapabilities(const FString& InPathToGitBinary, FGitVersion *OutVersion);
 
 /**
- * Find the root of the Git repository, looking from the provided path and upward in its parent directories
- * @param InPath				The path to the Game Directory (or any path or file in any git repository)
- * @param OutRepositoryRoot		The path to the root directory of the Git repository if found, else the path to the ProjectDir
- * @returns true if the command succeeded and returned no errors
+ * Find the path to the Git LFS binary used by the provided Git binary (best effort: next to it, or in the PATH)
+ * @param InPathToGitBinary		The path to the Git binary
+ * @returns the path to the Git LFS binary if found, or an empty string.
  */
-bool FindRootDirectory(const FString& InPath, FString& OutRepositoryRoot);
+FString FindGitLfsBinaryPath(const FString& InPathToGitBinary);
 
 /**
- * Get Git config user.name & user.email
- * @param	InPathToGitBinary	The path to the Git binary
- * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory (can be empty)
- * @param	OutUserName			Name of the Git user configured for this repository (or globaly)
- * @param	OutEmailName		E-mail of the Git user configured for this repository (or globaly)
+ * Load the version and capabilities of Git saved by a previous run, if the Git and Git LFS binaries did not change since (same paths and time stamps).
+ * @param InPathToGitBinary		The path to the Git binary
+ * @param OutVersion			The FGitVersion to populate
+ * @returns true if the cache is valid for these binaries
+ */
+bool LoadCachedGitVersion(const FString& InPathToGitBinary, FGitVersion& OutVersion);
+
+/**
+ * Save the version and capabilities of Git, so that the next startups do not need to run any git command to find them.
+ * @param InPathToGitBinary		The path to the Git binary
+ * @param InVersion				The version and capabilities found by CheckGitAvailability()
  */
-void GetUserConfig(const FString& InPathToGitBinary, const FString& InRepositoryRoot, FString& OutUserName, FString& OutUserEmail);
+void SaveCachedGitVersion(const FString& InPathToGitBinary, const FGitVersion& InVersion);
 
 /**
  * Get Git current checked-out branch
@@ -108,63 +135,46 @@ bool GetBranchName(const FString& InPathToGitBinary, const FString& InRepository
 bool GetCommitInfo(const FString& InPathToGitBinary, const FString& InRepositoryRoot, FString& OutCommitId, FString& OutCommitSummary);
 
 /**
- * Get the URL of the "origin" defaut remote server
- * @param	InPathToGitBinary	The path to the Git binary
- * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory
- * @param	OutRemoteUrl		URL of "origin" defaut remote server
- * @returns true if the command succeeded and returned no errors
- */
-bool GetRemoteUrl(const FString& InPathToGitBinary, const FString& InRepositoryRoot, FString& OutRemoteUrl);
-
-/**
- * Run a Git command - output is a string TArray.
+ * Run a Git "status" command and parse it.
  *
- * @param	InCommand			The Git command - e.g. commit
  * @param	InPathToGitBinary	The path to the Git binary
  * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory (can be empty)
- * @param	InParameters		The parameters to the Git command
+ * @param	InUsingLfsLocking	Tells if using the Git LFS file Locking workflow
  * @param	InFiles				The files to be operated on
- * @param	OutResults			The results (from StdOut) as an array per-line
  * @param	OutErrorMessages	Any errors (from StdErr) as an array per-line
+ * @param	OutStates			States of the files (only files not "Unchanged" in case of a directory)
+ * @param	OutScannedDirectories	If provided, populate with the directories for which any file not in OutStates is implicitly "Unchanged"
  * @returns true if the command succeeded and returned no errors
  */
-bool RunCommand(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages);
-bool RunCommandInternalRaw(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, FString& OutResults, FString& OutErrors, const int32 ExpectedReturnCode = 0);
+GITSOURCECONTROL_API bool RunUpdateStatus(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const TArray<FString>& InFiles, TArray<FString>& OutErrorMessages, TArray<FGitSourceControlState>& OutStates, TArray<FString>* OutScannedDirectories = nullptr);
 
 /**
- * Run a Git "commit" command by batches.
+ * Find the repositories nested in the main one: submodules (recursively) and independent repositories of plugins.
  *
  * @param	InPathToGitBinary	The path to the Git binary
- * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory
- * @param	InParameter			The parameters to the Git commit command
- * @param	InFiles				The files to be operated on
- * @param	OutErrorMessages	Any errors (from StdErr) as an array per-line
- * @returns true if the command succeeded and returned no errors
+ * @param	InRepositoryRoot	The main Git repository
+ * @returns the absolute paths to the roots of the nested repositories (without trailing slash)
  */
-bool RunCommit(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages);
+TArray<FString> FindNestedRepositories(const FString& InPathToGitBinary, const FString& InRepositoryRoot);
 
 /**
- * Run a Git "status" command and parse it.
- *
- * @param	InPathToGitBinary	The path to the Git binary
- * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory (can be empty)
- * @param	InUsingLfsLocking	Tells if using the Git LFS file Locking workflow
- * @param	InFiles				The files to be operated on
- * @param	OutErrorMessages	Any errors (from StdErr) as an array per-line
- * @returns true if the command succeeded and returned no errors
+ * Get the metrics of the status commands run in each repository (main and nested), since the start of the Editor.
+ * @returns the metrics by repository root
  */
-bool RunUpdateStatus(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool InUsingLfsLocking, const TArray<FString>& InFiles, TArray<FString>& OutErrorMessages, TArray<FGitSourceControlState>& OutStates);
+TMap<FString, FGitRepositoryStatusMetrics> GetRepositoryStatusMetrics();
 
 /**
- * Run a Git "cat-file" command to dump the binary content of a revision into a file.
+ * Find which of the files have a newer version on the upstream branch, as of the last fetch (without any network access).
+ * The list of newer files is cached until HEAD moves or the remote refs are fetched, so this usually costs only a few file stats.
  *
  * @param	InPathToGitBinary	The path to the Git binary
- * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory
- * @param	InParameter			The parameters to the Git show command (rev:path)
- * @param	InDumpFileName		The temporary file to dump the revision
- * @returns true if the command succeeded and returned no errors
-*/
-bool RunDumpToFile(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InParameter, const FString& InDumpFileName);
+ * @param	InRepositoryRoot	The Git repository of the files
+ * @param	InFiles				Absolute paths of the files to check
+ * @param	OutNewerFiles		Populated with the files of InFiles that are not current
+ * @param	OutLastFetchTime	Time of the last fetch (FDateTime::MinValue() if never fetched)
+ * @returns true if the answer came from the cache, false if a git command had to run
+ */
+bool GetNewerFilesOnServer(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InFiles, TArray<FString>& OutNewerFiles, FDateTime& OutLastFetchTime);
 
 /**
  * Run a Git "log" command and parse it.
@@ -176,7 +186,7 @@ bool RunDumpToFile(const FString& InPathToGitBinary, const FString& InRepository
  * @param	OutErrorMessages	Any errors (from StdErr) as an array per-line
  * @param	OutHistory			The history of the file
  */
-bool RunGetHistory(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InFile, bool bMergeConflict, TArray<FString>& OutErrorMessages, TGitSourceControlHistory& OutHistory);
+GITSOURCECONTROL_API bool RunGetHistory(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InFile, bool bMergeConflict, TArray<FString>& OutErrorMessages, TGitSourceControlHistory& OutHistory);
 
 /**
  * Helper function to convert a filename array to relative paths.
@@ -184,7 +194,7 @@ bool RunGetHistory(const FString& InPathToGitBinary, const FString& InRepository
  * @param	InRelativeTo	Path to the WorkspaceRoot
  * @return an array of filenames, transformed into relative paths
  */
-TArray<FString> RelativeFilenames(const TArray<FString>& InFileNames, const FString& InRelativeTo);
+GITSOURCECONTROL_API TArray<FString> RelativeFilenames(const TArray<FString>& InFileNames, const FString& InRelativeTo);
 
 /**
  * Helper function to convert a filename array to absolute paths.
@@ -194,28 +204,30 @@ TArray<FString> RelativeFilenames(const TArray<FString>& InFileNames, const FStr
  */
 TArray<FString> AbsoluteFilenames(const TArray<FString>& InFileNames, const FString& InRelativeTo);
 
+/**
+ * Tell if two histories of a same file list the same commits
+ */
+bool IsSameHistory(const TGitSourceControlHistory& InHistory, const TGitSourceControlHistory& InOtherHistory);
+
 /**
  * Helper function for various commands to update cached states.
+ * @param	InStates	States handed over by the worker: their content is moved to the cache
  * @returns true if any states were updated
  */
-bool UpdateCachedStates(const TArray<FGitSourceControlState>& InStates);
+bool UpdateCachedStates(TArray<FGitSourceControlState>&& InStates);
 
 /**
- * Remove redundant errors (that contain a particular string) and also
- * update the commands success status if all errors were removed.
+ * Helper function for directory status commands to update cached states.
+ * @param	InStates				States of the files that are not "Unchanged" in the directories
+ * @param	InScannedDirectories	Directories for which any other file is now implicitly "Unchanged"
+ * @returns true if any states were updated
  */
-void RemoveRedundantErrors(FGitSourceControlCommand& InCommand, const FString& InFilter);
+bool UpdateCachedStates(TArray<FGitSourceControlState>&& InStates, const TArray<FString>& InScannedDirectories);
 
 /**
- * Run 'git lfs locks" to extract all lock information for all files in the repository
- *
- * @param	InPathToGitBinary	The path to the Git binary
- * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory
- * @param   bAbsolutePaths      Whether to report absolute filenames, false for repo-relative
- * @param	OutErrorMessages    Any errors (from StdErr) as an array per-line
- * @param	OutLocks		    The lock results (file, username)
- * @returns true if the command succeeded and returned no errors
+ * Remove redundant errors (that contain a particular string) and also
+ * update the commands success status if all errors were removed.
  */
-bool GetAllLocks(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool bAbsolutePaths, TArray<FString>& OutErrorMessages, TMap<FString, FString>& OutLocks);
+void RemoveRedundantErrors(FGitSourceControlCommand& InCommand, const FString& InFilter);
 
 }
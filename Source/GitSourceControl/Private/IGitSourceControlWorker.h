@@ -22,9 +22,10 @@ public:
 
 	/**
 	 * Updates the state of any items after completion (if necessary). This is always executed on the main thread.
+	 * The worker hands over its results to the state cache, so this can only be called once.
 	 * @returns true if states were updated
 	 */
-	virtual bool UpdateStates() const = 0;
+	virtual bool UpdateStates() = 0;
 };
 
 typedef TSharedRef<IGitSourceControlWorker, ESPMode::ThreadSafe> FGitSourceControlWorkerRef;
@@ -363,6 +363,56 @@ void SGitSourceControlSettings::Construct(const FArguments& InArgs)
                     .Font(Font)
                 ]
             ]
+			// Option to check out files at once, the locks being confirmed in the background (and rolled back if refused)
+			+SVerticalBox::Slot()
+			.AutoHeight()
+			.Padding(2.0f)
+			.VAlign(VAlign_Center)
+			[
+				SNew(SHorizontalBox)
+				.ToolTipText(LOCTEXT("GitOptimisticCheckOut_Tooltip", "Mark files as checked out and writable at once, without waiting for the LFS server; the locks are confirmed in the background, and a refused lock is rolled back with a notification."))
+				+SHorizontalBox::Slot()
+				.FillWidth(0.1f)
+				[
+					SNew(SCheckBox)
+					.IsChecked(SGitSourceControlSettings::IsOptimisticCheckOutEnabled())
+					.OnCheckStateChanged(this, &SGitSourceControlSettings::OnIsOptimisticCheckOutEnabled)
+					.IsEnabled(this, &SGitSourceControlSettings::GetIsUsingGitLfsLocking)
+				]
+				+SHorizontalBox::Slot()
+				.FillWidth(3.f)
+				.VAlign(VAlign_Center)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("GitOptimisticCheckOut", "Check out without waiting for the lock server"))
+					.Font(Font)
+				]
+			]
+			// Option to refuse to check out files with a newer version on the server (else only warn)
+			+SVerticalBox::Slot()
+			.AutoHeight()
+			.Padding(2.0f)
+			.VAlign(VAlign_Center)
+			[
+				SNew(SHorizontalBox)
+				.ToolTipText(LOCTEXT("GitRefuseOutdatedCheckOut_Tooltip", "Refuse to lock files that have a newer version on the upstream branch (as of the last fetch), so that they are synced before being edited. Otherwise a warning is reported."))
+				+SHorizontalBox::Slot()
+				.FillWidth(0.1f)
+				[
+					SNew(SCheckBox)
+					.IsChecked(SGitSourceControlSettings::IsRefuseOutdatedCheckOutEnabled())
+					.OnCheckStateChanged(this, &SGitSourceControlSettings::OnIsRefuseOutdatedCheckOutEnabled)
+					.IsEnabled(this, &SGitSourceControlSettings::GetIsUsingGitLfsLocking)
+				]
+				+SHorizontalBox::Slot()
+				.FillWidth(3.f)
+				.VAlign(VAlign_Center)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("GitRefuseOutdatedCheckOut", "Refuse to check out files with a newer version on the server"))
+					.Font(Font)
+				]
+			]
 			// Option to Make the initial Git commit with custom message
 			+SVerticalBox::Slot()
 			.AutoHeight()
@@ -514,14 +564,14 @@ FReply SGitSourceControlSettings::OnClickedInitializeGitRepository()
 	TArray<FString> ErrorMessages;
 
 	// 1.a. Synchronous (very quick) "git init" operation: initialize a Git local repository with a .git/ subdirectory
-	GitSourceControlUtils::RunCommand(TEXT("init"), PathToGitBinary, PathToProjectDir, TArray<FString>(), TArray<FString>(), InfoMessages, ErrorMessages);
+	GitSourceControlCore::RunCommand(TEXT("init"), PathToGitBinary, PathToProjectDir, TArray<FString>(), TArray<FString>(), InfoMessages, ErrorMessages);
 	// 1.b. Synchronous (very quick) "git remote add" operation: configure the URL of the default remote server 'origin' if specified
 	if(!RemoteUrl.IsEmpty())
 	{
 		TArray<FString> Parameters;
 		Parameters.Add(TEXT("add origin"));
 		Parameters.Add(RemoteUrl.ToString());
-		GitSourceControlUtils::RunCommand(TEXT("remote"), PathToGitBinary, PathToProjectDir, Parameters, TArray<FString>(), InfoMessages, ErrorMessages);
+		GitSourceControlCore::RunCommand(TEXT("remote"), PathToGitBinary, PathToProjectDir, Parameters, TArray<FString>(), InfoMessages, ErrorMessages);
 	}
 
 	// Check the new repository status to enable connection (branch, user e-mail)
@@ -559,7 +609,7 @@ FReply SGitSourceControlSettings::OnClickedInitializeGitRepository()
 		if(bAutoCreateGitAttributes)
 		{
 			// 2.c. Synchronous (very quick) "lfs install" operation: needs only to be run once by user
-			GitSourceControlUtils::RunCommand(TEXT("lfs install"), PathToGitBinary, PathToProjectDir, TArray<FString>(), TArray<FString>(), InfoMessages, ErrorMessages);
+			GitSourceControlCore::RunCommand(TEXT("lfs install"), PathToGitBinary, PathToProjectDir, TArray<FString>(), TArray<FString>(), InfoMessages, ErrorMessages);
 
 			// 2.d. Create a ".gitattributes" file to enable Git LFS (Large File System) for the whole "Content/" subdir
 			const FString GitAttributesFilename = FPaths::Combine(FPaths::ProjectDir(), TEXT(".gitattributes"));
@@ -747,6 +797,32 @@ ECheckBoxState SGitSourceControlSettings::IsPushAfterCommitEnabled() const
 	return (GetIsPushAfterCommitEnabled() ? ECheckBoxState::Checked : ECheckBoxState::Unchecked);
 }
 
+void SGitSourceControlSettings::OnIsOptimisticCheckOutEnabled(ECheckBoxState NewCheckedState)
+{
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	GitSourceControl.AccessSettings().SetIsOptimisticCheckOutEnabled(NewCheckedState == ECheckBoxState::Checked);
+	GitSourceControl.AccessSettings().SaveSettings();
+}
+
+ECheckBoxState SGitSourceControlSettings::IsOptimisticCheckOutEnabled() const
+{
+	const FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	return GitSourceControl.AccessSettings().IsOptimisticCheckOutEnabled() ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+}
+
+void SGitSourceControlSettings::OnIsRefuseOutdatedCheckOutEnabled(ECheckBoxState NewCheckedState)
+{
+	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	GitSourceControl.AccessSettings().SetIsRefuseOutdatedCheckOutEnabled(NewCheckedState == ECheckBoxState::Checked);
+	GitSourceControl.AccessSettings().SaveSettings();
+}
+
+ECheckBoxState SGitSourceControlSettings::IsRefuseOutdatedCheckOutEnabled() const
+{
+	const FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	return GitSourceControl.AccessSettings().IsRefuseOutdatedCheckOutEnabled() ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+}
+
 ECheckBoxState SGitSourceControlSettings::IsUsingGitLfsLocking() const
 {
 	return (GetIsUsingGitLfsLocking() ? ECheckBoxState::Checked : ECheckBoxState::Unchecked);
@@ -757,6 +833,7 @@ void SGitSourceControlSettings::OnLfsUserNameCommited(const FText& InText, EText
 	FGitSourceControlModule& GitSourceControl = FModuleManager::GetModuleChecked<FGitSourceControlModule>("GitSourceControl");
 	GitSourceControl.AccessSettings().SetLfsUserName(InText.ToString());
 	GitSourceControl.AccessSettings().SaveSettings();
+	GitSourceControl.GetProvider().UpdateEngineSettings();
 }
 
 FText SGitSourceControlSettings::GetLfsUserName() const
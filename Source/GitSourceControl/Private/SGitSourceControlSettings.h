@@ -71,6 +71,12 @@ private:
 	bool GetIsPushAfterCommitEnabled() const;
 	ECheckBoxState IsPushAfterCommitEnabled() const;
 
+	void OnIsOptimisticCheckOutEnabled(ECheckBoxState NewCheckedState);
+	ECheckBoxState IsOptimisticCheckOutEnabled() const;
+
+	void OnIsRefuseOutdatedCheckOutEnabled(ECheckBoxState NewCheckedState);
+	ECheckBoxState IsRefuseOutdatedCheckOutEnabled() const;
+
 	void OnLfsUserNameCommited(const FText& InText, ETextCommit::Type InCommitType);
 	FText GetLfsUserName() const;
 
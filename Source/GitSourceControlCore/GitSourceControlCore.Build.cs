@@ -0,0 +1,22 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+using UnrealBuildTool;
+
+/** Git process runner, output parsers and LFS lock client, independent of the Editor (depends only on Core) */
+public class GitSourceControlCore : ModuleRules
+{
+	public GitSourceControlCore(ReadOnlyTargetRules Target) : base(Target)
+	{
+		bEnforceIWYU = true;
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(
+			new string[] {
+				"Core",
+			}
+		);
+	}
+}
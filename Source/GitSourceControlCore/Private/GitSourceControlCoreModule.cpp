@@ -0,0 +1,11 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "Modules/ModuleManager.h"
+#include "GitSourceControlProcess.h"
+
+DEFINE_LOG_CATEGORY(LogGitSourceControl);
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, GitSourceControlCore);
@@ -0,0 +1,53 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlLockClient.h"
+
+#include "GitSourceControlParsers.h"
+#include "GitSourceControlProcess.h"
+
+namespace GitSourceControlCore
+{
+
+bool GetAllLocks(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool bAbsolutePaths, TArray<FString>& OutErrorMessages, TMap<FString, FString>& OutLocks)
+{
+	TArray<FString> Results;
+	TArray<FString> ErrorMessages;
+	const bool bResult = RunCommand(TEXT("lfs locks"), InPathToGitBinary, InRepositoryRoot, TArray<FString>(), TArray<FString>(), Results, ErrorMessages);
+	for(const FString& Result : Results)
+	{
+		FGitLfsLock Lock;
+		if(ParseLfsLock(InRepositoryRoot, Result, bAbsolutePaths, Lock))
+		{
+			// TODO LFS Debug log
+			UE_LOG(LogGitSourceControl, Log, TEXT("LockedFile(%s, %s)"), *Lock.LocalFilename, *Lock.LockUser);
+			OutLocks.Add(MoveTemp(Lock.LocalFilename), MoveTemp(Lock.LockUser));
+		}
+	}
+
+	return bResult;
+}
+
+bool LockFile(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InFile, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages)
+{
+	TArray<FString> OneFile;
+	OneFile.Add(InFile);
+	return RunCommand(TEXT("lfs lock"), InPathToGitBinary, InRepositoryRoot, TArray<FString>(), OneFile, OutResults, OutErrorMessages);
+}
+
+bool UnlockFiles(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages)
+{
+	return RunCommand(TEXT("lfs unlock"), InPathToGitBinary, InRepositoryRoot, TArray<FString>(), InFiles, OutResults, OutErrorMessages);
+}
+
+bool CheckLockServer(const FString& InPathToGitBinary, const FString& InRepositoryRoot, TArray<FString>& OutErrorMessages)
+{
+	TArray<FString> Results;
+	TArray<FString> Parameters;
+	Parameters.Add(TEXT("--limit=1"));
+	return RunCommand(TEXT("lfs locks"), InPathToGitBinary, InRepositoryRoot, Parameters, TArray<FString>(), Results, OutErrorMessages);
+}
+
+}
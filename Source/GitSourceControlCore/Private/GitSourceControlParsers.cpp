@@ -0,0 +1,317 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlParsers.h"
+
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "GitSourceControlProcess.h"
+
+/**
+ * @brief Extract the relative filename from a Git status result.
+ *
+ * Examples of status results:
+M  Content/Textures/T_Perlin_Noise_M.uasset
+R  Content/Textures/T_Perlin_Noise_M.uasset -> Content/Textures/T_Perlin_Noise_M2.uasset
+?? Content/Materials/M_Basic_Wall.uasset
+!! BasicCode.sln
+ *
+ * @param[in] InResult One line of status
+ * @return Relative filename extracted from the line of status
+ *
+ * @see ParseStatusLine()
+ */
+static FString FilenameFromGitStatus(const FString& InResult)
+{
+	int32 RenameIndex;
+	if(InResult.FindLastChar('>', RenameIndex))
+	{
+		// Extract only the second part of a rename "from -> to"
+		return InResult.RightChop(RenameIndex + 2);
+	}
+	else
+	{
+		// Extract the relative filename from the Git status result (after the 2 letters status and 1 space)
+		return InResult.RightChop(3);
+	}
+}
+
+/**
+ * Extract and interpret the file state from the given Git status result.
+ * @see http://git-scm.com/docs/git-status
+ * ' ' = unmodified
+ * 'M' = modified
+ * 'A' = added
+ * 'D' = deleted
+ * 'R' = renamed
+ * 'C' = copied
+ * 'U' = updated but unmerged
+ * '?' = unknown/untracked
+ * '!' = ignored
+*/
+static EWorkingCopyState::Type StateFromGitStatus(const FString& InResult)
+{
+	TCHAR IndexState = InResult[0];
+	TCHAR WCopyState = InResult[1];
+	if(   (IndexState == 'U' || WCopyState == 'U')
+	   || (IndexState == 'A' && WCopyState == 'A')
+	   || (IndexState == 'D' && WCopyState == 'D'))
+	{
+		// "Unmerged" conflict cases are generally marked with a "U",
+		// but there are also the special cases of both "A"dded, or both "D"eleted
+		return EWorkingCopyState::Conflicted;
+	}
+	else if(IndexState == 'A')
+	{
+		return EWorkingCopyState::Added;
+	}
+	else if(IndexState == 'D')
+	{
+		return EWorkingCopyState::Deleted;
+	}
+	else if(WCopyState == 'D')
+	{
+		return EWorkingCopyState::Missing;
+	}
+	else if(IndexState == 'M' || WCopyState == 'M')
+	{
+		return EWorkingCopyState::Modified;
+	}
+	else if(IndexState == 'R')
+	{
+		return EWorkingCopyState::Renamed;
+	}
+	else if(IndexState == 'C')
+	{
+		return EWorkingCopyState::Copied;
+	}
+	else if(IndexState == '?' || WCopyState == '?')
+	{
+		return EWorkingCopyState::NotControlled;
+	}
+	else if(IndexState == '!' || WCopyState == '!')
+	{
+		return EWorkingCopyState::Ignored;
+	}
+	else
+	{
+		// Unmodified never yield a status
+		return EWorkingCopyState::Unknown;
+	}
+}
+
+/**
+ * Translate file actions from the given Git log --name-status command to keywords used by the Editor UI.
+ *
+ * @see https://www.kernel.org/pub/software/scm/git/docs/git-log.html
+ * ' ' = unmodified
+ * 'M' = modified
+ * 'A' = added
+ * 'D' = deleted
+ * 'R' = renamed
+ * 'C' = copied
+ * 'T' = type changed
+ * 'U' = updated but unmerged
+ * 'X' = unknown
+ * 'B' = broken pairing
+ *
+ * @see SHistoryRevisionListRowContent::GenerateWidgetForColumn(): "add", "edit", "delete", "branch" and "integrate" (everything else is taken like "edit")
+*/
+static FString LogStatusToString(TCHAR InStatus)
+{
+	switch(InStatus)
+	{
+	case TEXT(' '):
+		return FString("unmodified");
+	case TEXT('M'):
+		return FString("modified");
+	case TEXT('A'): // added: keyword "add" to display a specific icon instead of the default "edit" action one
+		return FString("add");
+	case TEXT('D'): // deleted: keyword "delete" to display a specific icon instead of the default "edit" action one
+		return FString("delete");
+	case TEXT('R'): // renamed keyword "branch" to display a specific icon instead of the default "edit" action one
+		return FString("branch");
+	case TEXT('C'): // copied keyword "branch" to display a specific icon instead of the default "edit" action one
+		return FString("branch");
+	case TEXT('T'):
+		return FString("type changed");
+	case TEXT('U'):
+		return FString("unmerged");
+	case TEXT('X'):
+		return FString("unknown");
+	case TEXT('B'):
+		return FString("broked pairing");
+	}
+
+	return FString();
+}
+
+namespace GitSourceControlCore
+{
+
+FGitStatusEntry ParseStatusLine(const FString& InResult)
+{
+	FGitStatusEntry Entry;
+	Entry.Filename = FilenameFromGitStatus(InResult);
+	Entry.State = StateFromGitStatus(InResult);
+	return Entry;
+}
+
+/**
+ * Parse the array of strings results of a 'git log' command
+ *
+ * Example git log results:
+commit 97a4e7626681895e073aaefd68b8ac087db81b0b
+Author: Sébastien Rombauts <sebastien.rombauts@gmail.com>
+Date:   2014-2015-05-15 21:32:27 +0200
+
+    Another commit used to test History
+
+     - with many lines
+     - some <xml>
+     - and strange characteres $*+
+
+M	Content/Blueprints/Blueprint_CeilingLight.uasset
+R100	Content/Textures/T_Concrete_Poured_D.uasset Content/Textures/T_Concrete_Poured_D2.uasset
+
+commit 355f0df26ebd3888adbb558fd42bb8bd3e565000
+Author: Sébastien Rombauts <sebastien.rombauts@gmail.com>
+Date:   2014-2015-05-12 11:28:14 +0200
+
+    Testing git status, edit, and revert
+
+A	Content/Blueprints/Blueprint_CeilingLight.uasset
+C099	Content/Textures/T_Concrete_Poured_N.uasset Content/Textures/T_Concrete_Poured_N2.uasset
+*/
+void ParseLogResults(const TArray<FString>& InResults, TArray<FGitLogEntry>& OutEntries)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(GitSourceControlCore::ParseLogResults);
+	SCOPE_CYCLE_COUNTER(STAT_GitParseLog);
+	FGitLogEntry* Entry = nullptr;
+	for(const auto& Result : InResults)
+	{
+		if(Result.StartsWith(TEXT("commit "))) // Start of a new commit
+		{
+			Entry = &OutEntries.AddDefaulted_GetRef();
+			Entry->CommitId = Result.RightChop(7); // Full commit SHA1 hexadecimal string
+			Entry->ShortCommitId = Entry->CommitId.Left(8); // Short revision ; first 8 hex characters (max that can hold a 32 bit integer)
+			Entry->CommitIdNumber = FParse::HexNumber(*Entry->ShortCommitId);
+		}
+		else if(Entry == nullptr)
+		{
+			// Nothing to parse before the first commit
+			continue;
+		}
+		else if(Result.StartsWith(TEXT("Author: "))) // Author name & email
+		{
+			// Remove the 'email' part of the UserName
+			FString UserNameEmail = Result.RightChop(8);
+			int32 EmailIndex = 0;
+			if(UserNameEmail.FindLastChar('<', EmailIndex))
+			{
+				Entry->UserName = UserNameEmail.Left(EmailIndex - 1);
+			}
+		}
+		else if(Result.StartsWith(TEXT("Date:   "))) // Commit date
+		{
+			FString Date = Result.RightChop(8);
+			Entry->Date = FDateTime::FromUnixTimestamp(FCString::Atoi(*Date));
+		}
+	//	else if(Result.IsEmpty()) // empty line before/after commit message has already been taken care by FString::ParseIntoArray()
+		else if(Result.StartsWith(TEXT("    ")))  // Multi-lines commit message
+		{
+			Entry->Description += Result.RightChop(4);
+			Entry->Description += TEXT("\n");
+		}
+		else // Name of the file, starting with an uppercase status letter ("A"/"M"...)
+		{
+			const TCHAR Status = Result[0];
+			Entry->Action = LogStatusToString(Status); // Readable action string ("Added", Modified"...) instead of "A"/"M"...
+			// Take care of special case for Renamed/Copied file: extract the second filename after second tabulation
+			int32 IdxTab;
+			if(Result.FindLastChar('\t', IdxTab))
+			{
+				Entry->Filename = Result.RightChop(IdxTab + 1); // relative filename
+			}
+		}
+	}
+}
+
+/**
+ * Extract the SHA1 identifier and size of a blob (file) from a Git "ls-tree" command.
+ *
+ * Example output for the command git ls-tree --long 7fdaeb2 Content/Blueprints/BP_Test.uasset
+100644 blob a14347dc3b589b78fb19ba62a7e3982f343718bc   70731	Content/Blueprints/BP_Test.uasset
+*/
+bool ParseLsTree(const TArray<FString>& InResults, FGitLsTreeEntry& OutEntry)
+{
+	if(InResults.Num() == 0)
+	{
+		return false;
+	}
+
+	const FString& FirstResult = InResults[0];
+	OutEntry.FileHash = FirstResult.Mid(12, 40);
+	int32 IdxTab;
+	if(FirstResult.FindChar('\t', IdxTab))
+	{
+		const FString SizeString = FirstResult.Mid(53, IdxTab - 53);
+		OutEntry.FileSize = FCString::Atoi(*SizeString);
+	}
+	return true;
+}
+
+/**
+ * Extract the status of a unmerged (conflict) file
+ *
+ * Example output of git ls-files --unmerged Content/Blueprints/BP_Test.uasset
+100644 d9b33098273547b57c0af314136f35b494e16dcb 1	Content/Blueprints/BP_Test.uasset
+100644 a14347dc3b589b78fb19ba62a7e3982f343718bc 2	Content/Blueprints/BP_Test.uasset
+100644 f3137a7167c840847cd7bd2bf07eefbfb2d9bcd2 3	Content/Blueprints/BP_Test.uasset
+ *
+ * 1: The "common ancestor" of the file (the version of the file that both the current and other branch originated from).
+ * 2: The version from the current branch (the master branch in this case).
+ * 3: The version from the other branch (the test branch)
+*/
+bool ParseConflictStatus(const TArray<FString>& InResults, FString& OutCommonAncestorFileId)
+{
+	if(InResults.Num() != 3)
+	{
+		return false;
+	}
+
+	// Extract the base SHA1 identifier of the file
+	const FString& FirstResult = InResults[0]; // 1: The common ancestor of merged branches
+	OutCommonAncestorFileId = FirstResult.Mid(7, 40);
+	return true;
+}
+
+/**
+ * Parse informations on a file locked with Git LFS
+ *
+ * Example output of "git lfs locks"
+Content\ThirdPersonBP\Blueprints\ThirdPersonCharacter.uasset    SRombauts       ID:891
+Content\ThirdPersonBP\Blueprints\ThirdPersonGameMode.uasset     SRombauts       ID:896
+ */
+bool ParseLfsLock(const FString& InRepositoryRoot, const FString& InResult, const bool bAbsolutePaths, FGitLfsLock& OutLock)
+{
+	TArray<FString> Informations;
+	InResult.ParseIntoArray(Informations, TEXT("\t"), true);
+	if(Informations.Num() < 3)
+	{
+		return false;
+	}
+
+	Informations[0].TrimEndInline(); // Trim whitespace from the end of the filename
+	Informations[1].TrimEndInline(); // Trim whitespace from the end of the username
+	if (bAbsolutePaths)
+		OutLock.LocalFilename = FPaths::ConvertRelativePathToFull(InRepositoryRoot, Informations[0]);
+	else
+		OutLock.LocalFilename = Informations[0];
+	OutLock.LockUser = MoveTemp(Informations[1]);
+	return true;
+}
+
+}
@@ -0,0 +1,676 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlProcess.h"
+
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+#include <atomic>
+
+namespace GitSourceControlConstants
+{
+	/** The maximum number of files we submit in a single Git command */
+	const int32 MaxFilesPerBatch = 50;
+
+	/** Time in seconds after which FindRootDirectory() looks again for a ".git" in a directory, to notice a new (or removed) repository */
+	const double RootDirectoryCacheTimeout = 10.0;
+
+	/** The maximum number of git processes recorded, see GitSourceControlCore::GetCommandRecords() */
+	const int32 MaxCommandRecords = 1000;
+}
+
+DEFINE_STAT(STAT_GitRunProcess);
+DEFINE_STAT(STAT_GitParseLog);
+DEFINE_STAT(STAT_GitNumProcesses);
+DEFINE_STAT(STAT_GitOutputSize);
+
+/**
+ * Memoized results of FindRootDirectory(): a prefix tree of the directories already looked at, one node per path component,
+ * telling if each directory has a ".git" subdirectory (or file). Thread-safe: used to route the files of commands on worker threads.
+ */
+class FGitRootDirectoryCache
+{
+public:
+	/** Find the deepest directory with a ".git" on the path (without trailing slash), only looking again in the directories not checked recently */
+	bool Find(const FString& InPath, FString& OutRepositoryRoot)
+	{
+		TArray<FString> Components;
+		InPath.ParseIntoArray(Components, TEXT("/"), false);
+
+		FScopeLock ScopeLock(&CriticalSection);
+		const double Now = FPlatformTime::Seconds();
+		FNode* Node = &Root;
+		FString Directory;
+		bool bFound = false;
+		for(int32 Index = 0; Index < Components.Num(); Index++)
+		{
+			Directory = (Index == 0) ? Components[Index] : Directory + TEXT("/") + Components[Index];
+			TUniquePtr<FNode>& Child = Node->Children.FindOrAdd(Components[Index]);
+			if(!Child.IsValid())
+			{
+				Child = MakeUnique<FNode>();
+			}
+			Node = Child.Get();
+			if(Directory.IsEmpty())
+			{
+				continue;
+			}
+
+			if(Now - Node->CheckTime > GitSourceControlConstants::RootDirectoryCacheTimeout)
+			{
+				const FString PathToGitSubdirectory = Directory / TEXT(".git");
+				Node->bHasGit = IFileManager::Get().DirectoryExists(*PathToGitSubdirectory) || IFileManager::Get().FileExists(*PathToGitSubdirectory);
+				Node->CheckTime = Now;
+			}
+			if(Node->bHasGit)
+			{
+				OutRepositoryRoot = Directory;
+				bFound = true;
+			}
+		}
+		return bFound;
+	}
+
+private:
+	struct FNode
+	{
+		TMap<FString, TUniquePtr<FNode>> Children;
+		double CheckTime = TNumericLimits<double>::Lowest();
+		bool bHasGit = false;
+	};
+
+	FCriticalSection CriticalSection;
+	FNode Root;
+};
+
+static FGitRootDirectoryCache RootDirectoryCache;
+
+/** Number of git processes launched by the current thread, see GitSourceControlCore::GetNumProcessesOnThread() */
+static thread_local int32 NumProcessesOnThread = 0;
+
+/** Worker running on the current thread, see FGitScopedWorkerName */
+static thread_local FName WorkerOnThread;
+
+/**
+ * Ring buffer of the records of the last git processes, from all threads.
+ */
+class FGitCommandRecords
+{
+public:
+	void Add(FGitCommandRecord&& InRecord)
+	{
+		FScopeLock ScopeLock(&CriticalSection);
+		if(Records.Num() < GitSourceControlConstants::MaxCommandRecords)
+		{
+			Records.Add(MoveTemp(InRecord));
+		}
+		else
+		{
+			Records[NextIndex] = MoveTemp(InRecord);
+		}
+		NextIndex = (NextIndex + 1) % GitSourceControlConstants::MaxCommandRecords;
+	}
+
+	/** Copy of the records, the oldest first */
+	TArray<FGitCommandRecord> Get() const
+	{
+		FScopeLock ScopeLock(&CriticalSection);
+		if(Records.Num() < GitSourceControlConstants::MaxCommandRecords)
+		{
+			return Records;
+		}
+		TArray<FGitCommandRecord> OrderedRecords;
+		OrderedRecords.Reserve(Records.Num());
+		for(int32 Index = 0; Index < Records.Num(); Index++)
+		{
+			OrderedRecords.Add(Records[(NextIndex + Index) % Records.Num()]);
+		}
+		return OrderedRecords;
+	}
+
+private:
+	mutable FCriticalSection CriticalSection;
+	TArray<FGitCommandRecord> Records;
+	/** Index of the next record to write (the oldest one once the buffer is full) */
+	int32 NextIndex = 0;
+};
+
+static FGitCommandRecords CommandRecords;
+
+/** Count and record a git process that just completed */
+static void AddCommandRecord(const FString& InCommand, const double InStartTime, const int32 InReturnCode, const int32 InOutputSize, const int32 InErrorSize)
+{
+	INC_DWORD_STAT(STAT_GitNumProcesses);
+	INC_DWORD_STAT_BY(STAT_GitOutputSize, InOutputSize);
+
+	FGitCommandRecord Record;
+	Record.Command = InCommand;
+	Record.Worker = WorkerOnThread;
+	Record.StartTime = InStartTime;
+	Record.Duration = FPlatformTime::Seconds() - InStartTime;
+	Record.OutputSize = InOutputSize;
+	Record.ErrorSize = InErrorSize;
+	Record.ReturnCode = InReturnCode;
+	CommandRecords.Add(MoveTemp(Record));
+}
+
+/** Settings of the git engine, see GitSourceControlCore::SetEngineSettings() */
+static FCriticalSection EngineSettingsCriticalSection;
+static TSharedRef<const FGitEngineSettings, ESPMode::ThreadSafe> EngineSettings = MakeShared<const FGitEngineSettings, ESPMode::ThreadSafe>();
+
+/** Stand-in for the git binary, if any, see GitSourceControlCore::SetProcessInterceptor() */
+static std::atomic<IGitProcessInterceptor*> ProcessInterceptor(nullptr);
+
+FGitScopedWorkerName::FGitScopedWorkerName(const FName& InWorker)
+	: PreviousWorker(WorkerOnThread)
+{
+	WorkerOnThread = InWorker;
+}
+
+FGitScopedWorkerName::~FGitScopedWorkerName()
+{
+	WorkerOnThread = PreviousWorker;
+}
+
+
+namespace GitSourceControlCore
+{
+
+TSharedRef<const FGitEngineSettings, ESPMode::ThreadSafe> GetEngineSettings()
+{
+	FScopeLock ScopeLock(&EngineSettingsCriticalSection);
+	return EngineSettings;
+}
+
+FString FindRepositoryOfFile(const FString& InRepositoryRoot, const FString& InFile)
+{
+	if(InRepositoryRoot.IsEmpty() || FPaths::IsRelative(InFile))
+	{
+		return InRepositoryRoot;
+	}
+
+	// Only look for the ".git" of another repository for a file outside of the default one (ie. "migrate asset" to another project),
+	// or if there are repositories nested in it (submodules, or independent repositories of plugins)
+	const TSharedRef<const FGitEngineSettings, ESPMode::ThreadSafe> Settings = GetEngineSettings();
+	const TArray<FString>& NestedRepositories = Settings->NestedRepositories;
+	if(!InFile.StartsWith(InRepositoryRoot) || (NestedRepositories.Num() > 0))
+	{
+		// The root directory of a nested repository itself belongs to it (not to its parent directory)
+		const FString Directory = InFile.EndsWith(TEXT("/")) ? InFile.LeftChop(1) : InFile;
+		if(NestedRepositories.Contains(Directory))
+		{
+			return Directory;
+		}
+
+		FString FileRepositoryRoot;
+		if(FindRootDirectory(FPaths::GetPath(InFile), FileRepositoryRoot))
+		{
+			return FileRepositoryRoot;
+		}
+	}
+	return InRepositoryRoot;
+}
+
+/** Group the absolute files by the Git repository they belong to, the other ones (relative, or outside of any repository) going to the default repository */
+static TMap<FString, TArray<FString>> GroupFilesByRepository(const FString& InRepositoryRoot, const TArray<FString>& InFiles)
+{
+	TMap<FString, TArray<FString>> FilesByRepository;
+	for(const FString& File : InFiles)
+	{
+		FilesByRepository.FindOrAdd(FindRepositoryOfFile(InRepositoryRoot, File)).Add(File);
+	}
+	return FilesByRepository;
+}
+
+/** Tell if some of the files belong to another repository than the default one, so that the command has to be split by repository */
+static bool IsRoutedToOtherRepositories(const FString& InRepositoryRoot, const TMap<FString, TArray<FString>>& InFilesByRepository)
+{
+	return (InFilesByRepository.Num() > 1) || ((InFilesByRepository.Num() == 1) && !InFilesByRepository.Contains(InRepositoryRoot));
+}
+
+// Launch the Git command line process in a single repository and extract its results & errors
+static bool RunProcessInRepository(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, FString& OutResults, FString& OutErrors, const int32 ExpectedReturnCode)
+{
+	int32 ReturnCode = 0;
+	FString FullCommand;
+	FString LogableCommand; // short version of the command for logging purpose
+
+	if(!InRepositoryRoot.IsEmpty())
+	{
+		// Specify the working copy (the root) of the git repository (before the command itself)
+		FullCommand  = TEXT("-C \"");
+		FullCommand += InRepositoryRoot;
+		FullCommand += TEXT("\" ");
+	}
+	// then the git command itself ("status", "log", "commit"...)
+	LogableCommand += InCommand;
+
+	// Append to the command all parameters, and then finally the files
+	for(const auto& Parameter : InParameters)
+	{
+		LogableCommand += TEXT(" ");
+		LogableCommand += Parameter;
+	}
+	for(const auto& File : InFiles)
+	{
+		LogableCommand += TEXT(" \"");
+		LogableCommand += File;
+		LogableCommand += TEXT("\"");
+	}
+	// Also, Git does not have a "--non-interactive" option, as it auto-detects when there are no connected standard input/output streams
+
+	FullCommand += LogableCommand;
+
+	UE_LOG(LogGitSourceControl, Log, TEXT("RunCommand: 'git %s'"), *LogableCommand);
+
+	FString PathToGitOrEnvBinary = InPathToGitBinary;
+#if PLATFORM_MAC
+	// The Cocoa application does not inherit shell environment variables, so add the path expected to have git-lfs to PATH
+	FString PathEnv = FPlatformMisc::GetEnvironmentVariable(TEXT("PATH"));
+	FString GitInstallPath = FPaths::GetPath(InPathToGitBinary);
+
+	TArray<FString> PathArray;
+	PathEnv.ParseIntoArray(PathArray, FPlatformMisc::GetPathVarDelimiter());
+	bool bHasGitInstallPath = false;
+	for (auto Path : PathArray)
+	{
+		if (GitInstallPath.Equals(Path, ESearchCase::CaseSensitive))
+		{
+			bHasGitInstallPath = true;
+			break;
+		}
+	}
+
+	if (!bHasGitInstallPath)
+	{
+		PathToGitOrEnvBinary = FString("/usr/bin/env");
+		FullCommand = FString::Printf(TEXT("PATH=\"%s%s%s\" \"%s\" %s"), *GitInstallPath, FPlatformMisc::GetPathVarDelimiter(), *PathEnv, *InPathToGitBinary, *FullCommand);
+	}
+#endif
+	NumProcessesOnThread++;
+	const double StartTime = FPlatformTime::Seconds();
+	{
+		SCOPED_NAMED_EVENT_FSTRING(TEXT("git ") + InCommand, FColor::Orange);
+		SCOPE_CYCLE_COUNTER(STAT_GitRunProcess);
+		IGitProcessInterceptor* Interceptor = ProcessInterceptor;
+		if(!Interceptor || !Interceptor->Run(LogableCommand, InRepositoryRoot, OutResults, OutErrors, ReturnCode))
+		{
+			FPlatformProcess::ExecProcess(*PathToGitOrEnvBinary, *FullCommand, &ReturnCode, &OutResults, &OutErrors);
+			if(Interceptor)
+			{
+				Interceptor->Record(LogableCommand, InRepositoryRoot, OutResults, OutErrors, ReturnCode);
+			}
+		}
+	}
+	AddCommandRecord(InCommand, StartTime, ReturnCode, OutResults.Len(), OutErrors.Len());
+
+	// TODO: add a setting to easily enable Verbose logging
+	UE_LOG(LogGitSourceControl, Verbose, TEXT("RunCommand(%s) in %.3lfs:\n%s"), *InCommand, FPlatformTime::Seconds() - StartTime, *OutResults);
+	if(ReturnCode != ExpectedReturnCode || OutErrors.Len() > 0)
+	{
+		UE_LOG(LogGitSourceControl, Warning, TEXT("RunCommand(%s) ReturnCode=%d:\n%s"), *InCommand, ReturnCode, *OutErrors);
+	}
+
+	// Move push/pull progress information from the error stream to the info stream
+	if(ReturnCode == ExpectedReturnCode && OutErrors.Len() > 0)
+	{
+		OutResults.Append(OutErrors);
+		OutErrors.Empty();
+	}
+
+	return ReturnCode == ExpectedReturnCode;
+}
+
+// Launch the Git command line process (one per repository of the files) and extract its results & errors
+bool RunCommandInternalRaw(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, FString& OutResults, FString& OutErrors, const int32 ExpectedReturnCode /* = 0 */)
+{
+	if(InFiles.Num() > 0)
+	{
+		const TMap<FString, TArray<FString>> FilesByRepository = GroupFilesByRepository(InRepositoryRoot, InFiles);
+		if(IsRoutedToOtherRepositories(InRepositoryRoot, FilesByRepository))
+		{
+			// Keep the outputs of the processes on separate lines
+			auto AppendLines = [](FString& InOutOutput, const FString& InLines)
+			{
+				if(!InOutOutput.IsEmpty() && !InOutOutput.EndsWith(TEXT("\n")))
+				{
+					InOutOutput += TEXT("\n");
+				}
+				InOutOutput += InLines;
+			};
+
+			bool bResult = true;
+			for(const auto& RepositoryFiles : FilesByRepository)
+			{
+				FString RepositoryResults;
+				FString RepositoryErrors;
+				bResult &= RunProcessInRepository(InCommand, InPathToGitBinary, RepositoryFiles.Key, InParameters, RepositoryFiles.Value, RepositoryResults, RepositoryErrors, ExpectedReturnCode);
+				AppendLines(OutResults, RepositoryResults);
+				AppendLines(OutErrors, RepositoryErrors);
+			}
+			return bResult;
+		}
+	}
+
+	return RunProcessInRepository(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, OutResults, OutErrors, ExpectedReturnCode);
+}
+
+// Basic parsing or results & errors from the Git command line process
+static bool RunCommandInternal(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages)
+{
+	bool bResult;
+	FString Results;
+	FString Errors;
+
+	bResult = RunCommandInternalRaw(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, Results, Errors);
+	Results.ParseIntoArray(OutResults, TEXT("\n"), true);
+	Errors.ParseIntoArray(OutErrorMessages, TEXT("\n"), true);
+
+	return bResult;
+}
+
+bool FindRootDirectory(const FString& InPath, FString& OutRepositoryRoot)
+{
+	FString Path = InPath;
+
+	auto TrimTrailing = [](FString& Str, const TCHAR Char)
+	{
+		int32 Len = Str.Len();
+		while(Len && Str[Len - 1] == Char)
+		{
+			Str = Str.LeftChop(1);
+			Len = Str.Len();
+		}
+	};
+
+	TrimTrailing(Path, '\\');
+	TrimTrailing(Path, '/');
+
+	// Look for the ".git" subdirectory (or file) present at the root of every Git repository, in the deepest parent directory that has one
+	const bool bFound = RootDirectoryCache.Find(Path, OutRepositoryRoot);
+	if(!bFound)
+	{
+		OutRepositoryRoot = InPath; // If not found, return the provided dir as best possible root.
+	}
+	return bFound;
+}
+
+bool RunCommand(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages)
+{
+	bool bResult = true;
+
+	// Route each file of another repository (nested, or "migrate asset" to another project) to the command of its own repository,
+	// before batching the files
+	if(InFiles.Num() > 0)
+	{
+		const TMap<FString, TArray<FString>> FilesByRepository = GroupFilesByRepository(InRepositoryRoot, InFiles);
+		if(IsRoutedToOtherRepositories(InRepositoryRoot, FilesByRepository))
+		{
+			for(const auto& RepositoryFiles : FilesByRepository)
+			{
+				TArray<FString> RepositoryResults;
+				TArray<FString> RepositoryErrors;
+				bResult &= RunCommand(InCommand, InPathToGitBinary, RepositoryFiles.Key, InParameters, RepositoryFiles.Value, RepositoryResults, RepositoryErrors);
+				OutResults += RepositoryResults;
+				OutErrorMessages += RepositoryErrors;
+			}
+			return bResult;
+		}
+	}
+
+	if(InFiles.Num() > GitSourceControlConstants::MaxFilesPerBatch)
+	{
+		// Batch files up so we dont exceed command-line limits
+		int32 FileCount = 0;
+		while(FileCount < InFiles.Num())
+		{
+			TArray<FString> FilesInBatch;
+			for(int32 FileIndex = 0; FileCount < InFiles.Num() && FileIndex < GitSourceControlConstants::MaxFilesPerBatch; FileIndex++, FileCount++)
+			{
+				FilesInBatch.Add(InFiles[FileCount]);
+			}
+
+			TArray<FString> BatchResults;
+			TArray<FString> BatchErrors;
+			bResult &= RunCommandInternal(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, FilesInBatch, BatchResults, BatchErrors);
+			OutResults += BatchResults;
+			OutErrorMessages += BatchErrors;
+		}
+	}
+	else
+	{
+		bResult &= RunCommandInternal(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, OutResults, OutErrorMessages);
+	}
+
+	return bResult;
+}
+
+// Run a Git "commit" command by batches
+bool RunCommit(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages)
+{
+	bool bResult = true;
+
+	// One commit in each repository of the files: the batches below amend the commit of their own repository
+	if(InFiles.Num() > 0)
+	{
+		const TMap<FString, TArray<FString>> FilesByRepository = GroupFilesByRepository(InRepositoryRoot, InFiles);
+		if(IsRoutedToOtherRepositories(InRepositoryRoot, FilesByRepository))
+		{
+			for(const auto& RepositoryFiles : FilesByRepository)
+			{
+				TArray<FString> RepositoryResults;
+				TArray<FString> RepositoryErrors;
+				bResult &= RunCommit(InPathToGitBinary, RepositoryFiles.Key, InParameters, RepositoryFiles.Value, RepositoryResults, RepositoryErrors);
+				OutResults += RepositoryResults;
+				OutErrorMessages += RepositoryErrors;
+			}
+			return bResult;
+		}
+	}
+
+	if(InFiles.Num() > GitSourceControlConstants::MaxFilesPerBatch)
+	{
+		// Batch files up so we dont exceed command-line limits
+		int32 FileCount = 0;
+		{
+			TArray<FString> FilesInBatch;
+			for(int32 FileIndex = 0; FileIndex < GitSourceControlConstants::MaxFilesPerBatch; FileIndex++, FileCount++)
+			{
+				FilesInBatch.Add(InFiles[FileCount]);
+			}
+			// First batch is a simple "git commit" command with only the first files
+			bResult &= RunCommandInternal(TEXT("commit"), InPathToGitBinary, InRepositoryRoot, InParameters, FilesInBatch, OutResults, OutErrorMessages);
+		}
+
+		TArray<FString> Parameters;
+		for(const auto& Parameter : InParameters)
+		{
+			Parameters.Add(Parameter);
+		}
+		Parameters.Add(TEXT("--amend"));
+
+		while(FileCount < InFiles.Num())
+		{
+			TArray<FString> FilesInBatch;
+			for(int32 FileIndex = 0; FileCount < InFiles.Num() && FileIndex < GitSourceControlConstants::MaxFilesPerBatch; FileIndex++, FileCount++)
+			{
+				FilesInBatch.Add(InFiles[FileCount]);
+			}
+			// Next batches "amend" the commit with some more files
+			TArray<FString> BatchResults;
+			TArray<FString> BatchErrors;
+			bResult &= RunCommandInternal(TEXT("commit"), InPathToGitBinary, InRepositoryRoot, Parameters, FilesInBatch, BatchResults, BatchErrors);
+			OutResults += BatchResults;
+			OutErrorMessages += BatchErrors;
+		}
+	}
+	else
+	{
+		bResult = RunCommandInternal(TEXT("commit"), InPathToGitBinary, InRepositoryRoot, InParameters, InFiles, OutResults, OutErrorMessages);
+	}
+
+	return bResult;
+}
+
+// Run a Git `cat-file --filters` command to dump the binary content of a revision into a file.
+bool RunDumpToFile(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InParameter, const FString& InDumpFileName)
+{
+	int32 ReturnCode = -1;
+	FString FullCommand;
+
+	const bool bHasCatFileWithFilters = GetEngineSettings()->bHasCatFileWithFilters;
+
+	if(!InRepositoryRoot.IsEmpty())
+	{
+		// Specify the working copy (the root) of the git repository (before the command itself)
+		FullCommand  = TEXT("-C \"");
+		FullCommand += InRepositoryRoot;
+		FullCommand += TEXT("\" ");
+	}
+
+	// then the git command itself
+	if(bHasCatFileWithFilters)
+	{
+		// Newer versions (2.9.3.windows.2) support smudge/clean filters used by Git LFS, git-fat, git-annex, etc
+		FullCommand += TEXT("cat-file --filters ");
+	}
+	else
+	{
+		// Previous versions fall-back on "git show" like before
+		FullCommand += TEXT("show ");
+	}
+
+	// Append to the command the parameter
+	FullCommand += InParameter;
+
+	const bool bLaunchDetached = false;
+	const bool bLaunchHidden = true;
+	const bool bLaunchReallyHidden = bLaunchHidden;
+
+	void* PipeRead = nullptr;
+	void* PipeWrite = nullptr;
+
+	verify(FPlatformProcess::CreatePipe(PipeRead, PipeWrite));
+
+	UE_LOG(LogGitSourceControl, Log, TEXT("RunDumpToFile: 'git %s'"), *FullCommand);
+
+    FString PathToGitOrEnvBinary = InPathToGitBinary;
+    #if PLATFORM_MAC
+        // The Cocoa application does not inherit shell environment variables, so add the path expected to have git-lfs to PATH
+        FString PathEnv = FPlatformMisc::GetEnvironmentVariable(TEXT("PATH"));
+        FString GitInstallPath = FPaths::GetPath(InPathToGitBinary);
+
+        TArray<FString> PathArray;
+        PathEnv.ParseIntoArray(PathArray, FPlatformMisc::GetPathVarDelimiter());
+        bool bHasGitInstallPath = false;
+        for (auto Path : PathArray)
+        {
+            if (GitInstallPath.Equals(Path, ESearchCase::CaseSensitive))
+            {
+                bHasGitInstallPath = true;
+                break;
+            }
+        }
+
+        if (!bHasGitInstallPath)
+        {
+            PathToGitOrEnvBinary = FString("/usr/bin/env");
+            FullCommand = FString::Printf(TEXT("PATH=\"%s%s%s\" \"%s\" %s"), *GitInstallPath, FPlatformMisc::GetPathVarDelimiter(), *PathEnv, *InPathToGitBinary, *FullCommand);
+        }
+    #endif
+    
+	NumProcessesOnThread++;
+	const double StartTime = FPlatformTime::Seconds();
+	SCOPED_NAMED_EVENT_TEXT("git cat-file", FColor::Orange);
+	SCOPE_CYCLE_COUNTER(STAT_GitRunProcess);
+	FProcHandle ProcessHandle = FPlatformProcess::CreateProc(*PathToGitOrEnvBinary, *FullCommand, bLaunchDetached, bLaunchHidden, bLaunchReallyHidden, nullptr, 0, *InRepositoryRoot, PipeWrite);
+	if(ProcessHandle.IsValid())
+	{
+		FPlatformProcess::Sleep(0.01);
+
+		TArray<uint8> BinaryFileContent;
+		while(FPlatformProcess::IsProcRunning(ProcessHandle))
+		{
+			TArray<uint8> BinaryData;
+			FPlatformProcess::ReadPipeToArray(PipeRead, BinaryData);
+			if(BinaryData.Num() > 0)
+			{
+				BinaryFileContent.Append(MoveTemp(BinaryData));
+			}
+		}
+		TArray<uint8> BinaryData;
+		FPlatformProcess::ReadPipeToArray(PipeRead, BinaryData);
+		if(BinaryData.Num() > 0)
+		{
+			BinaryFileContent.Append(MoveTemp(BinaryData));
+		}
+
+		FPlatformProcess::GetProcReturnCode(ProcessHandle, &ReturnCode);
+		AddCommandRecord(bHasCatFileWithFilters ? TEXT("cat-file") : TEXT("show"), StartTime, ReturnCode, BinaryFileContent.Num(), 0);
+		if(ReturnCode == 0)
+		{
+			// Save buffer into temp file
+			if(FFileHelper::SaveArrayToFile(BinaryFileContent, *InDumpFileName))
+			{
+				UE_LOG(LogGitSourceControl, Log, TEXT("Writed '%s' (%do)"), *InDumpFileName, BinaryFileContent.Num());
+			}
+			else
+			{
+				UE_LOG(LogGitSourceControl, Error, TEXT("Could not write %s"), *InDumpFileName);
+				ReturnCode = -1;
+			}
+		}
+		else
+		{
+			UE_LOG(LogGitSourceControl, Error, TEXT("DumpToFile: ReturnCode=%d"), ReturnCode);
+		}
+
+		FPlatformProcess::CloseProc(ProcessHandle);
+	}
+	else
+	{
+		UE_LOG(LogGitSourceControl, Error, TEXT("Failed to launch 'git cat-file'"));
+	}
+
+	FPlatformProcess::ClosePipe(PipeRead, PipeWrite);
+
+	return (ReturnCode == 0);
+}
+
+void SetEngineSettings(FGitEngineSettings&& InSettings)
+{
+	TSharedRef<const FGitEngineSettings, ESPMode::ThreadSafe> NewSettings = MakeShared<const FGitEngineSettings, ESPMode::ThreadSafe>(MoveTemp(InSettings));
+	FScopeLock ScopeLock(&EngineSettingsCriticalSection);
+	EngineSettings = NewSettings;
+}
+
+int32 GetNumProcessesOnThread()
+{
+	return NumProcessesOnThread;
+}
+
+TArray<FGitCommandRecord> GetCommandRecords()
+{
+	return CommandRecords.Get();
+}
+
+FName GetWorkerOnThread()
+{
+	return WorkerOnThread;
+}
+
+void SetProcessInterceptor(IGitProcessInterceptor* InInterceptor)
+{
+	ProcessInterceptor = InInterceptor;
+}
+
+}
@@ -0,0 +1,50 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Client of the Git LFS lock server, through the "git lfs" commands of the git engine (see GitSourceControlProcess.h)
+ */
+namespace GitSourceControlCore
+{
+
+/**
+ * Run 'git lfs locks" to extract all lock information for all files in the repository
+ *
+ * @param	InPathToGitBinary	The path to the Git binary
+ * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory
+ * @param   bAbsolutePaths      Whether to report absolute filenames, false for repo-relative
+ * @param	OutErrorMessages    Any errors (from StdErr) as an array per-line
+ * @param	OutLocks		    The lock results (file, username)
+ * @returns true if the command succeeded and returned no errors
+ */
+GITSOURCECONTROLCORE_API bool GetAllLocks(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const bool bAbsolutePaths, TArray<FString>& OutErrorMessages, TMap<FString, FString>& OutLocks);
+
+/**
+ * Lock a file with "git lfs lock" (the server takes only one file at a time)
+ *
+ * @param	InFile				The file to lock, relative to the repository
+ * @returns true if the file is now locked by the user
+ */
+GITSOURCECONTROLCORE_API bool LockFile(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InFile, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages);
+
+/**
+ * Unlock files with "git lfs unlock", on batches of files instead of one process per file
+ *
+ * @param	InFiles				The files to unlock, relative to the repository
+ * @returns true if all the files were unlocked
+ */
+GITSOURCECONTROLCORE_API bool UnlockFiles(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages);
+
+/**
+ * Check that the lock server is reachable, by listing at most one of the locks
+ * @returns true if the server answered
+ */
+GITSOURCECONTROLCORE_API bool CheckLockServer(const FString& InPathToGitBinary, const FString& InRepositoryRoot, TArray<FString>& OutErrorMessages);
+
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GitSourceControlTypes.h"
+
+/** A line of a "git status --porcelain" */
+struct FGitStatusEntry
+{
+	/** Filename relative to the root of the repository (the new name of a renamed file) */
+	FString Filename;
+
+	/** State of the file, Unknown for a line that is not a file status */
+	EWorkingCopyState::Type State = EWorkingCopyState::Unknown;
+};
+
+/** A commit of a "git log --name-status --pretty=medium --date=raw" of a file */
+struct FGitLogEntry
+{
+	/** Full commit SHA1 hexadecimal string, and its first 8 hex characters (max that can hold a 32 bit integer) as a short id and as a number */
+	FString CommitId;
+	FString ShortCommitId;
+	int32 CommitIdNumber = 0;
+
+	/** Name of the author, without the email */
+	FString UserName;
+
+	FDateTime Date;
+
+	/** Multi-lines commit message */
+	FString Description;
+
+	/** Keyword of the action on the file, as used by the Editor UI ("add", "delete", "branch"...), see LogStatusToString() */
+	FString Action;
+
+	/** Filename relative to the root of the repository, at this commit */
+	FString Filename;
+};
+
+/** A file (blob) of a "git ls-tree --long" */
+struct FGitLsTreeEntry
+{
+	/** SHA1 Id of the file (warning: not the commit Id) */
+	FString FileHash;
+
+	/** Size of the file (in bytes) */
+	int32 FileSize = 0;
+};
+
+/** A file locked with Git LFS, as listed by "git lfs locks" */
+struct FGitLfsLock
+{
+	/** Filename on disk */
+	FString LocalFilename;
+
+	/** Name of user who has file locked */
+	FString LockUser;
+};
+
+namespace GitSourceControlCore
+{
+
+/**
+ * Parse one line of a "git status --porcelain".
+ * @param	InResult	One line of status, like "M  Content/Textures/T_Perlin_Noise_M.uasset"
+ */
+GITSOURCECONTROLCORE_API FGitStatusEntry ParseStatusLine(const FString& InResult);
+
+/**
+ * Parse the lines of a "git log --name-status --pretty=medium --date=raw" of a file.
+ * @param	InResults	Lines of the log
+ * @param	OutEntries	Commits of the log, the most recent first
+ */
+GITSOURCECONTROLCORE_API void ParseLogResults(const TArray<FString>& InResults, TArray<FGitLogEntry>& OutEntries);
+
+/**
+ * Parse the result of a "git ls-tree --long" of a file.
+ * @returns false if there is no file in the results
+ */
+GITSOURCECONTROLCORE_API bool ParseLsTree(const TArray<FString>& InResults, FGitLsTreeEntry& OutEntry);
+
+/**
+ * Parse the result of a "git ls-files --unmerged" of a conflicted file.
+ * @param	OutCommonAncestorFileId	SHA1 Id of the file in the common ancestor of the merged branches (warning: not the commit Id)
+ * @returns false if the results are not the 3 stages of an unmerged file
+ */
+GITSOURCECONTROLCORE_API bool ParseConflictStatus(const TArray<FString>& InResults, FString& OutCommonAncestorFileId);
+
+/**
+ * Parse one line of a "git lfs locks".
+ * @param	InRepositoryRoot	The root of the repository, to convert the filename to an absolute one
+ * @param	bAbsolutePaths		Whether to report absolute filenames, false for repo-relative
+ * @returns false if the line is not a lock
+ */
+GITSOURCECONTROLCORE_API bool ParseLfsLock(const FString& InRepositoryRoot, const FString& InResult, const bool bAbsolutePaths, FGitLfsLock& OutLock);
+
+}
@@ -0,0 +1,195 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+GITSOURCECONTROLCORE_API DECLARE_LOG_CATEGORY_EXTERN(LogGitSourceControl, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("GitSourceControl"), STATGROUP_GitSourceControl, STATCAT_Advanced);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Run git process"), STAT_GitRunProcess, STATGROUP_GitSourceControl, GITSOURCECONTROLCORE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Parse log"), STAT_GitParseLog, STATGROUP_GitSourceControl, GITSOURCECONTROLCORE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Git processes"), STAT_GitNumProcesses, STATGROUP_GitSourceControl, GITSOURCECONTROLCORE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Git output size"), STAT_GitOutputSize, STATGROUP_GitSourceControl, GITSOURCECONTROLCORE_API);
+
+/**
+ * Settings of the git engine (the process runner, and the status, dump and lock functions using it), injected by their owner when they change,
+ * instead of being looked up from the module, the settings and the provider on worker threads: so the engine runs without them (eg. in a commandlet)
+ * @see GitSourceControlCore::SetEngineSettings()
+ */
+struct FGitEngineSettings
+{
+	/** User name of the Git LFS locks, to tell the files locked by the user from the ones locked by others */
+	FString LfsUserName;
+
+	/** Root of the main repository (without trailing slash), the only one where the ignored files are looked for */
+	FString MainRepositoryRoot;
+
+	/** Roots of the submodules and other repositories nested in the main one (without trailing slash), with their own status */
+	TArray<FString> NestedRepositories;
+
+	/** Dump the files with "cat-file --filters" (Git 2.9.3+, with the smudge filters of Git LFS) instead of "show" */
+	bool bHasCatFileWithFilters = false;
+
+	/** Find which of the files of the main repository are ignored (none if not set) */
+	TFunction<TSet<FString>(const TArray<FString>&)> GetIgnoredFiles;
+};
+
+/** Record of a git process, see GitSourceControlCore::GetCommandRecords() */
+struct FGitCommandRecord
+{
+	/** Git command and subcommand if any ("status", "lfs locks", "cat-file"...), without the other parameters */
+	FString Command;
+
+	/** Worker that ran the process, or None if not run by a worker (eg. the console, or the initialization of the provider) */
+	FName Worker;
+
+	/** Launch time of the process (from FPlatformTime::Seconds()) and its wall time, in seconds */
+	double StartTime = 0.0;
+	double Duration = 0.0;
+
+	/** Size of the standard output and error streams (in characters, as decoded, but in bytes for the binary content of a dump) */
+	int32 OutputSize = 0;
+	int32 ErrorSize = 0;
+
+	int32 ReturnCode = 0;
+};
+
+/**
+ * Name the worker running on the current thread, for the records of the git processes it launches, for the lifetime of the scope
+ */
+class GITSOURCECONTROLCORE_API FGitScopedWorkerName
+{
+public:
+	explicit FGitScopedWorkerName(const FName& InWorker);
+	~FGitScopedWorkerName();
+
+private:
+	/** Name of the enclosing worker, to restore */
+	FName PreviousWorker;
+};
+
+/**
+ * Stand-in for the git binary, answering some command lines instead of running a process (eg. to replay recorded outputs with injected faults).
+ * Called from the threads running git commands, so it has to be thread-safe.
+ * @see GitSourceControlCore::SetProcessInterceptor()
+ */
+class IGitProcessInterceptor
+{
+public:
+	virtual ~IGitProcessInterceptor() {}
+
+	/**
+	 * Answer a git command line instead of running it.
+	 * @param	InCommandLine		The command line, without the git binary nor the "-C <root>"
+	 * @param	InRepositoryRoot	Root of the repository of the command
+	 * @returns false to run git
+	 */
+	virtual bool Run(const FString& InCommandLine, const FString& InRepositoryRoot, FString& OutResults, FString& OutErrors, int32& OutReturnCode) = 0;
+
+	/** Observe the outputs of a git command line that did run */
+	virtual void Record(const FString& InCommandLine, const FString& InRepositoryRoot, const FString& InResults, const FString& InErrors, const int32 InReturnCode) = 0;
+};
+
+namespace GitSourceControlCore
+{
+
+/**
+ * Run a Git command - output is a string TArray.
+ * Each file of another repository (nested, or "migrate asset" to another project) is routed to a process of its own repository,
+ * and the files are batched so that the command line does not exceed its limits.
+ *
+ * @param	InCommand			The Git command - e.g. commit
+ * @param	InPathToGitBinary	The path to the Git binary
+ * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory (can be empty)
+ * @param	InParameters		The parameters to the Git command
+ * @param	InFiles				The files to be operated on
+ * @param	OutResults			The results (from StdOut) as an array per-line
+ * @param	OutErrorMessages	Any errors (from StdErr) as an array per-line
+ * @returns true if the command succeeded and returned no errors
+ */
+GITSOURCECONTROLCORE_API bool RunCommand(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages);
+
+/**
+ * Run a Git command - output is a raw string. Like RunCommand(), each file of another repository is routed to a process of its own repository.
+ */
+GITSOURCECONTROLCORE_API bool RunCommandInternalRaw(const FString& InCommand, const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, FString& OutResults, FString& OutErrors, const int32 ExpectedReturnCode = 0);
+
+/**
+ * Run a Git "commit" command by batches (a commit in each repository of the files).
+ *
+ * @param	InPathToGitBinary	The path to the Git binary
+ * @param	InRepositoryRoot	The Git repository from where to run the command - usually the Game directory
+ * @param	InParameter			The parameters to the Git commit command
+ * @param	InFiles				The files to be operated on
+ * @param	OutErrorMessages	Any errors (from StdErr) as an array per-line
+ * @returns true if the command succeeded and returned no errors
+ */
+GITSOURCECONTROLCORE_API bool RunCommit(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const TArray<FString>& InParameters, const TArray<FString>& InFiles, TArray<FString>& OutResults, TArray<FString>& OutErrorMessages);
+
+/**
+ * Run a Git "cat-file" command to dump the binary content of a revision into a file.
+ *
+ * @param	InPathToGitBinary	The path to the Git binary
+ * @param	InRepositoryRoot	The Git repository of the revision, since the path is relative to it
+ * @param	InParameter			The parameters to the Git show command (rev:path)
+ * @param	InDumpFileName		The temporary file to dump the revision
+ * @returns true if the command succeeded and returned no errors
+*/
+GITSOURCECONTROLCORE_API bool RunDumpToFile(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InParameter, const FString& InDumpFileName);
+
+/**
+ * Find the root of the Git repository, looking from the provided path and upward in its parent directories
+ * (memoized, so that routing files to their repositories does not look for ".git" again and again: the ".git" of a directory is only
+ * looked for again after 10s, which stands for an invalidation when a repository is created or removed)
+ * @param InPath				The path to the Game Directory (or any path or file in any git repository)
+ * @param OutRepositoryRoot		The path to the root directory of the Git repository if found, else the path to the ProjectDir
+ * @returns true if the command succeeded and returned no errors
+ */
+GITSOURCECONTROLCORE_API bool FindRootDirectory(const FString& InPath, FString& OutRepositoryRoot);
+
+/**
+ * Find the Git repository of a file: the default repository, unless the file is in a nested repository or outside of the default one
+ * (ie. "migrate asset" to another project). Every command taking files routes them by this.
+ * NOTE the ".git" of each directory is looked for again at most every 10s (see FindRootDirectory()), so a repository created meanwhile is not noticed at once
+ *
+ * @param	InRepositoryRoot	The default Git repository - usually the Game directory (can be empty)
+ * @param	InFile				Absolute filename (a relative one always belongs to the default repository)
+ */
+GITSOURCECONTROLCORE_API FString FindRepositoryOfFile(const FString& InRepositoryRoot, const FString& InFile);
+
+/**
+ * Set the settings of the git engine, used by the next commands (the ones running keep the previous settings).
+ * Thread-safe: the engine takes a snapshot of its settings at the start of each status or dump.
+ */
+GITSOURCECONTROLCORE_API void SetEngineSettings(FGitEngineSettings&& InSettings);
+
+/** Snapshot of the settings of the git engine, unaffected by the next changes */
+GITSOURCECONTROLCORE_API TSharedRef<const FGitEngineSettings, ESPMode::ThreadSafe> GetEngineSettings();
+
+/**
+ * Set the stand-in answering the git command lines instead of running processes, or nullptr to always run git.
+ * The interceptor must outlive its use: reset it before destroying it.
+ */
+GITSOURCECONTROLCORE_API void SetProcessInterceptor(IGitProcessInterceptor* InInterceptor);
+
+/**
+ * Get the number of git processes launched so far by the current thread (not counting the long-running "git check-ignore"),
+ * to count the processes of a command from the difference before and after it.
+ */
+GITSOURCECONTROLCORE_API int32 GetNumProcessesOnThread();
+
+/** Get the name of the worker running on the current thread (see FGitScopedWorkerName), to hand it over to the tasks it launches */
+GITSOURCECONTROLCORE_API FName GetWorkerOnThread();
+
+/**
+ * Get the records of the last git processes (up to a thousand, kept in a ring buffer), from all threads.
+ * @returns the records, the oldest first
+ */
+GITSOURCECONTROLCORE_API TArray<FGitCommandRecord> GetCommandRecords();
+
+}
@@ -0,0 +1,37 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace EWorkingCopyState
+{
+	enum Type
+	{
+		Unknown,
+		Unchanged, // called "clean" in SVN, "Pristine" in Perforce
+		Added,
+		Deleted,
+		Modified,
+		Renamed,
+		Copied,
+		Missing,
+		Conflicted,
+		NotControlled,
+		Ignored,
+	};
+}
+
+namespace ELockState
+{
+	enum Type
+	{
+		Unknown,
+		NotLocked,
+		Locked,
+		LockedOther,
+	};
+}
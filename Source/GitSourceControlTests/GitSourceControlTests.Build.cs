@@ -0,0 +1,33 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+using System.IO;
+using UnrealBuildTool;
+
+/** Benchmark and test fixtures of the Git provider, kept out of the GitSourceControl module shipped in the Editor */
+public class GitSourceControlTests : ModuleRules
+{
+	public GitSourceControlTests(ReadOnlyTargetRules Target) : base(Target)
+	{
+		bEnforceIWYU = true;
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		// The fixtures drive the workers and the git engine of the provider, declared in its private headers
+		PrivateIncludePaths.Add(Path.Combine(ModuleDirectory, "..", "GitSourceControl", "Private"));
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[] {
+				"Core",
+				"CoreUObject",
+				"Engine",
+				"SourceControl",
+				"Json",
+				"HTTPServer",
+				"GitSourceControl",
+				"GitSourceControlCore",
+			}
+		);
+	}
+}
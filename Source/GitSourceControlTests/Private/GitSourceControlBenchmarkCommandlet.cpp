@@ -0,0 +1,725 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlBenchmarkCommandlet.h"
+
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Containers/Ticker.h"
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "ISourceControlModule.h"
+#include "SourceControlOperations.h"
+#include "GitSourceControlCheckIgnore.h"
+#include "GitSourceControlCommand.h"
+#include "GitSourceControlLfsLockServer.h"
+#include "GitSourceControlLockClient.h"
+#include "GitSourceControlModule.h"
+#include "GitSourceControlOperations.h"
+#include "GitSourceControlProcessStub.h"
+#include "GitSourceControlUtils.h"
+
+namespace GitSourceControlBenchmark
+{
+	/** Parameters of the synthetic repository and of the measures */
+	struct FParameters
+	{
+		/** Number of assets in Content/ */
+		int32 NumAssets = 1000;
+		/** Number of subdirectories of Content/ the assets are spread into */
+		int32 FanOut = 10;
+		/** Number of commits in the history */
+		int32 HistoryDepth = 10;
+		/** Ratio of assets stored as Git LFS pointers (the other ones being binary files) */
+		float LfsRatio = 0.5f;
+		/** Ratio of assets modified in the working copy */
+		float DirtyRatio = 0.05f;
+		/** Number of runs of each measure */
+		int32 Iterations = 5;
+		/** Seed of the random content, for reproducible repositories */
+		int32 Seed = 0;
+		/** Responses of the git process stub to replay instead of running git, to measure the parsers and the scheduling alone */
+		FString ReplayFile;
+		/** File to save the outputs of git to, as responses to replay later */
+		FString RecordFile;
+		/** Measure the locks against a local LFS lock server listening on this port (0 to skip them) */
+		int32 LockServerPort = 0;
+		/** Latency of each answer of the lock server, in milliseconds */
+		int32 LockLatencyMs = 0;
+		/** Number of locks of other users on the server, to list */
+		int32 NumLocks = 10000;
+		/** Number of files to lock and unlock */
+		int32 NumLockFiles = 500;
+		/** Number of users locking the same files at the same time, each from its own clone */
+		int32 NumClients = 4;
+	};
+
+	/** Durations and numbers of git processes of the runs of a measure */
+	struct FMeasure
+	{
+		FString Name;
+		TArray<double> Durations;
+		int32 NumProcesses = 0;
+		/** False if the results of a measure that also checks them were not the expected ones */
+		bool bPassed = true;
+	};
+
+	/** Size of the binary assets, and number of files committed by each run of the commit measure, or queried by the status of files */
+	const int32 AssetSize = 4096;
+	const int32 NumFilesPerCommit = 10;
+	const int32 NumFilesPerStatus = 50;
+
+	/** Number of files all the clients try to lock at the same time */
+	const int32 NumContendedFiles = 50;
+
+	/** Name of the user of the generated repository on the lock server */
+	static const FString LockOwner = TEXT("Benchmark");
+
+	static bool RunGit(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InCommand, const TArray<FString>& InParameters)
+	{
+		TArray<FString> Results;
+		TArray<FString> ErrorMessages;
+		const bool bResult = GitSourceControlCore::RunCommand(InCommand, InPathToGitBinary, InRepositoryRoot, InParameters, TArray<FString>(), Results, ErrorMessages);
+		if(!bResult)
+		{
+			UE_LOG(LogSourceControl, Error, TEXT("git %s failed: %s"), *InCommand, *FString::Join(ErrorMessages, TEXT("\n")));
+		}
+		return bResult;
+	}
+
+	static void WriteAsset(const FString& InFilename, const bool bInLfsPointer, FRandomStream& InRandom)
+	{
+		if(bInLfsPointer)
+		{
+			// Content of a file tracked by Git LFS, as seen by git without the smudge filter
+			FString Oid;
+			for(int32 Index = 0; Index < 8; Index++)
+			{
+				Oid += FString::Printf(TEXT("%08x"), InRandom.GetUnsignedInt());
+			}
+			FFileHelper::SaveStringToFile(FString::Printf(TEXT("version https://git-lfs.github.com/spec/v1\noid sha256:%s\nsize %d\n"), *Oid, InRandom.RandRange(AssetSize, 100 * AssetSize)), *InFilename);
+		}
+		else
+		{
+			TArray<uint8> Content;
+			Content.SetNumUninitialized(AssetSize);
+			for(uint8& Byte : Content)
+			{
+				Byte = (uint8)InRandom.RandRange(0, 255);
+			}
+			FFileHelper::SaveArrayToFile(Content, *InFilename);
+		}
+	}
+
+	/** Generate the repository: assets spread in subdirectories, a history of commits modifying some of them, pushed to a bare remote, and some local modifications */
+	static bool GenerateRepository(const FString& InPathToGitBinary, const FString& InWorkDir, const FParameters& InParameters, TArray<FString>& OutAssets, TArray<bool>& OutIsLfsPointer)
+	{
+		FRandomStream Random(InParameters.Seed);
+		const FString RemoteDir = InWorkDir / TEXT("Remote.git");
+		const FString RepositoryDir = InWorkDir / TEXT("Repository");
+		IFileManager::Get().MakeDirectory(*RemoteDir, true);
+		IFileManager::Get().MakeDirectory(*RepositoryDir, true);
+
+		bool bResult = RunGit(InPathToGitBinary, RemoteDir, TEXT("init"), { TEXT("--bare"), TEXT("--quiet") });
+		bResult &= RunGit(InPathToGitBinary, RepositoryDir, TEXT("init"), { TEXT("--quiet") });
+		bResult &= RunGit(InPathToGitBinary, RepositoryDir, TEXT("config"), { TEXT("user.name"), TEXT("Benchmark") });
+		bResult &= RunGit(InPathToGitBinary, RepositoryDir, TEXT("config"), { TEXT("user.email"), TEXT("benchmark@localhost") });
+		if(!bResult)
+		{
+			return false;
+		}
+
+		const int32 FanOut = FMath::Max(1, InParameters.FanOut);
+		for(int32 Index = 0; Index < InParameters.NumAssets; Index++)
+		{
+			const FString Asset = FString::Printf(TEXT("%s/Content/Dir%03d/Asset%06d.uasset"), *RepositoryDir, Index % FanOut, Index);
+			const bool bLfsPointer = (Random.FRand() < InParameters.LfsRatio);
+			WriteAsset(Asset, bLfsPointer, Random);
+			OutAssets.Add(Asset);
+			OutIsLfsPointer.Add(bLfsPointer);
+		}
+		bResult &= RunGit(InPathToGitBinary, RepositoryDir, TEXT("add"), { TEXT("--all") });
+		bResult &= RunGit(InPathToGitBinary, RepositoryDir, TEXT("commit"), { TEXT("--quiet"), TEXT("-m \"Initial commit\"") });
+
+		// History: each commit modifies 1% of the assets
+		const int32 NumAssetsPerCommit = FMath::Max(1, InParameters.NumAssets / 100);
+		for(int32 Commit = 1; bResult && (Commit < InParameters.HistoryDepth); Commit++)
+		{
+			for(int32 Index = 0; Index < NumAssetsPerCommit; Index++)
+			{
+				const int32 AssetIndex = Random.RandRange(0, OutAssets.Num() - 1);
+				WriteAsset(OutAssets[AssetIndex], OutIsLfsPointer[AssetIndex], Random);
+			}
+			bResult &= RunGit(InPathToGitBinary, RepositoryDir, TEXT("commit"), { TEXT("--quiet"), TEXT("--all"), FString::Printf(TEXT("-m \"Commit %d\""), Commit) });
+		}
+
+		bResult &= RunGit(InPathToGitBinary, RepositoryDir, TEXT("remote"), { TEXT("add"), TEXT("origin"), FString::Printf(TEXT("\"%s\""), *RemoteDir) });
+		bResult &= RunGit(InPathToGitBinary, RepositoryDir, TEXT("push"), { TEXT("--quiet"), TEXT("--set-upstream"), TEXT("origin"), TEXT("HEAD") });
+
+		// Working copy: modified assets
+		const int32 NumDirtyAssets = FMath::RoundToInt(InParameters.NumAssets * InParameters.DirtyRatio);
+		for(int32 Index = 0; Index < NumDirtyAssets; Index++)
+		{
+			const int32 AssetIndex = Random.RandRange(0, OutAssets.Num() - 1);
+			WriteAsset(OutAssets[AssetIndex], OutIsLfsPointer[AssetIndex], Random);
+		}
+
+		return bResult;
+	}
+
+	/** Sort the durations of the runs of a measure, and log them */
+	static void LogMeasure(FMeasure& InOutMeasure)
+	{
+		InOutMeasure.Durations.Sort();
+		UE_LOG(LogSourceControl, Display, TEXT("%-24s median %8.1lfms  min %8.1lfms  max %8.1lfms  (%d git process(es))"), *InOutMeasure.Name,
+			InOutMeasure.Durations[InOutMeasure.Durations.Num() / 2] * 1000.0, InOutMeasure.Durations[0] * 1000.0, InOutMeasure.Durations.Last() * 1000.0, InOutMeasure.NumProcesses);
+	}
+
+	/** Run a measure the number of iterations, counting the git processes of the first run */
+	static FMeasure Measure(const FString& InName, const int32 InIterations, TFunctionRef<void(int32)> InRun)
+	{
+		FMeasure Measure;
+		Measure.Name = InName;
+		for(int32 Iteration = 0; Iteration < InIterations; Iteration++)
+		{
+			const int32 NumProcessesBefore = GitSourceControlCore::GetNumProcessesOnThread();
+			const double StartTime = FPlatformTime::Seconds();
+			InRun(Iteration);
+			Measure.Durations.Add(FPlatformTime::Seconds() - StartTime);
+			if(Iteration == 0)
+			{
+				Measure.NumProcesses = GitSourceControlCore::GetNumProcessesOnThread() - NumProcessesBefore;
+			}
+		}
+
+		LogMeasure(Measure);
+		return Measure;
+	}
+
+	/**
+	 * Run a measure against the lock server the number of iterations, after an untimed setup of the server before each run.
+	 * The runs are on another thread, while this one ticks the core ticker for the HTTP listeners of the server to answer.
+	 */
+	static FMeasure MeasureLocks(const FString& InName, const int32 InIterations, TFunctionRef<void()> InSetup, TFunction<void()> InRun)
+	{
+		FMeasure Measure;
+		Measure.Name = InName;
+		for(int32 Iteration = 0; Iteration < InIterations; Iteration++)
+		{
+			InSetup();
+			int32 NumProcesses = 0;
+			const double StartTime = FPlatformTime::Seconds();
+			TFuture<void> Future = Async(EAsyncExecution::ThreadPool, [&InRun, &NumProcesses]()
+			{
+				const int32 NumProcessesBefore = GitSourceControlCore::GetNumProcessesOnThread();
+				InRun();
+				NumProcesses = GitSourceControlCore::GetNumProcessesOnThread() - NumProcessesBefore;
+			});
+			while(!Future.IsReady())
+			{
+#if ENGINE_MAJOR_VERSION == 5
+				FTSTicker::GetCoreTicker().Tick(0.001f);
+#else
+				FTicker::GetCoreTicker().Tick(0.001f);
+#endif
+				FPlatformProcess::Sleep(0.001f);
+			}
+			Measure.Durations.Add(FPlatformTime::Seconds() - StartTime);
+			Measure.NumProcesses = NumProcesses;
+		}
+
+		LogMeasure(Measure);
+		return Measure;
+	}
+
+	/** Point the repository to the lock server, as this user */
+	static bool ConfigureLockClient(const FString& InPathToGitBinary, const FString& InRepositoryRoot, const FString& InUrl, const FString& InOwner)
+	{
+		bool bResult = RunGit(InPathToGitBinary, InRepositoryRoot, TEXT("config"), { TEXT("lfs.url"), InUrl });
+		bResult &= RunGit(InPathToGitBinary, InRepositoryRoot, TEXT("config"), { TEXT("http.extraHeader"), FString::Printf(TEXT("\"X-Lock-Owner: %s\""), *InOwner) });
+		bResult &= RunGit(InPathToGitBinary, InRepositoryRoot, TEXT("config"), { TEXT("lfs.locksverify"), TEXT("false") });
+		return bResult;
+	}
+
+	/** Measure the listing of the locks, the locking and unlocking of files, and the contention of users locking the same files */
+	static bool MeasureLockServer(const FString& InPathToGitBinary, const FString& InWorkDir, const FParameters& InParameters, const TArray<FString>& InAssets, TArray<FMeasure>& OutMeasures)
+	{
+		const FString RepositoryDir = InWorkDir / TEXT("Repository");
+		FGitLfsLockServer LockServer;
+		if(!LockServer.Start(InParameters.LockServerPort, InParameters.LockLatencyMs / 1000.0) || !ConfigureLockClient(InPathToGitBinary, RepositoryDir, LockServer.GetUrl(), LockOwner))
+		{
+			return false;
+		}
+
+		// Locks of another user on files of the server only, to be listed
+		TArray<FString> OtherLocks;
+		for(int32 Index = 0; Index < InParameters.NumLocks; Index++)
+		{
+			OtherLocks.Add(FString::Printf(TEXT("Content/Other/File%06d.uasset"), Index));
+		}
+		LockServer.AddLocks(OtherLocks, TEXT("Other"));
+
+		TArray<FString> LockFiles;
+		for(int32 Index = 0; Index < FMath::Min(InParameters.NumLockFiles, InAssets.Num()); Index++)
+		{
+			LockFiles.Add(InAssets[Index]);
+		}
+		LockFiles = GitSourceControlUtils::RelativeFilenames(LockFiles, RepositoryDir);
+
+		OutMeasures.Add(MeasureLocks(TEXT("Locks.List"), InParameters.Iterations, []() {}, [&]()
+		{
+			TArray<FString> ErrorMessages;
+			TMap<FString, FString> Locks;
+			GitSourceControlCore::GetAllLocks(InPathToGitBinary, RepositoryDir, true, ErrorMessages, Locks);
+		}));
+
+		// Lock one file at a time, and unlock them all at once, like the CheckOut and Revert workers
+		OutMeasures.Add(MeasureLocks(TEXT("Locks.Lock"), InParameters.Iterations, [&]() { LockServer.RemoveLocks(LockOwner); }, [&]()
+		{
+			for(const FString& File : LockFiles)
+			{
+				TArray<FString> Results;
+				TArray<FString> ErrorMessages;
+				GitSourceControlCore::LockFile(InPathToGitBinary, RepositoryDir, File, Results, ErrorMessages);
+			}
+		}));
+		UE_LOG(LogSourceControl, Display, TEXT("%d/%d file(s) locked"), LockServer.GetNumLocks(LockOwner), LockFiles.Num());
+		OutMeasures.Add(MeasureLocks(TEXT("Locks.Unlock"), InParameters.Iterations, [&]() { LockServer.AddLocks(LockFiles, LockOwner); }, [&]()
+		{
+			TArray<FString> Results;
+			TArray<FString> ErrorMessages;
+			GitSourceControlCore::UnlockFiles(InPathToGitBinary, RepositoryDir, LockFiles, Results, ErrorMessages);
+		}));
+
+		// Each client is a clone, as another user, and they all lock the same files at the same time: only one lock of each file must succeed
+		TArray<FString> Clients;
+		for(int32 Client = 0; Client < InParameters.NumClients; Client++)
+		{
+			const FString ClientDir = InWorkDir / FString::Printf(TEXT("Client%d"), Client);
+			if(!RunGit(InPathToGitBinary, InWorkDir, TEXT("clone"), { TEXT("--quiet"), TEXT("--shared"), FString::Printf(TEXT("\"%s\" \"%s\""), *(InWorkDir / TEXT("Remote.git")), *ClientDir) })
+				|| !ConfigureLockClient(InPathToGitBinary, ClientDir, LockServer.GetUrl(), FString::Printf(TEXT("Client%d"), Client)))
+			{
+				return false;
+			}
+			Clients.Add(ClientDir);
+		}
+		const TArray<FString> ContendedFiles(LockFiles.GetData(), FMath::Min(NumContendedFiles, LockFiles.Num()));
+		FMeasure Contention = MeasureLocks(TEXT("Locks.Contention"), InParameters.Iterations, [&]()
+		{
+			for(int32 Client = 0; Client < Clients.Num(); Client++)
+			{
+				LockServer.RemoveLocks(FString::Printf(TEXT("Client%d"), Client));
+			}
+		}, [&]()
+		{
+			// NOTE the calling thread runs clients too, so this cannot starve even when the workers are all busy
+			ParallelFor(Clients.Num(), [&InPathToGitBinary, &ContendedFiles, &Clients](const int32 InClient)
+			{
+				for(const FString& File : ContendedFiles)
+				{
+					TArray<FString> Results;
+					TArray<FString> ErrorMessages;
+					GitSourceControlCore::LockFile(InPathToGitBinary, Clients[InClient], File, Results, ErrorMessages);
+				}
+			});
+		});
+		// NOTE the processes of the clients run on other threads
+		Contention.NumProcesses = Clients.Num() * ContendedFiles.Num();
+		int32 NumContendedLocks = 0;
+		for(int32 Client = 0; Client < Clients.Num(); Client++)
+		{
+			NumContendedLocks += LockServer.GetNumLocks(FString::Printf(TEXT("Client%d"), Client));
+		}
+		UE_LOG(LogSourceControl, Display, TEXT("%d/%d contended file(s) locked by %d client(s)"), NumContendedLocks, ContendedFiles.Num(), Clients.Num());
+		OutMeasures.Add(MoveTemp(Contention));
+
+		LockServer.Stop();
+		return true;
+	}
+
+	/** Check that a Sync reported exactly the expected files, logging the differences */
+	static bool CheckSyncedFiles(const TCHAR* InWhat, const TArray<FString>& InFiles, const TArray<FString>& InExpectedFiles)
+	{
+		const TSet<FString> Files(InFiles);
+		const TSet<FString> ExpectedFiles(InExpectedFiles);
+		const TSet<FString> MissingFiles = ExpectedFiles.Difference(Files);
+		const TSet<FString> UnexpectedFiles = Files.Difference(ExpectedFiles);
+		for(const FString& File : MissingFiles)
+		{
+			UE_LOG(LogSourceControl, Error, TEXT("Sync: %s file '%s' not reported"), InWhat, *File);
+		}
+		for(const FString& File : UnexpectedFiles)
+		{
+			UE_LOG(LogSourceControl, Error, TEXT("Sync: '%s' unexpectedly reported as %s"), *File, InWhat);
+		}
+		return (MissingFiles.Num() == 0) && (UnexpectedFiles.Num() == 0);
+	}
+
+	/**
+	 * Sync scenario: another user pushes from a second clone (files added, modified and deleted in a directory not modified locally),
+	 * then a SyncAll of the repository must report exactly these files as changed, and the deleted ones as to be removed from the cache.
+	 * The repository has local modifications and commits, so the pull rebases them and stashes the modifications meanwhile.
+	 */
+	static bool MeasureSync(const FString& InPathToGitBinary, const FString& InWorkDir, const FParameters& InParameters, FRandomStream& InRandom, TArray<FMeasure>& OutMeasures)
+	{
+		const FString RepositoryDir = InWorkDir / TEXT("Repository");
+		const FString UpstreamDir = InWorkDir / TEXT("Upstream");
+		bool bResult = RunGit(InPathToGitBinary, InWorkDir, TEXT("clone"), { TEXT("--quiet"), FString::Printf(TEXT("\"%s\" \"%s\""), *(InWorkDir / TEXT("Remote.git")), *UpstreamDir) });
+		bResult &= RunGit(InPathToGitBinary, UpstreamDir, TEXT("config"), { TEXT("user.name"), TEXT("Upstream") });
+		bResult &= RunGit(InPathToGitBinary, UpstreamDir, TEXT("config"), { TEXT("user.email"), TEXT("upstream@localhost") });
+		if(!bResult)
+		{
+			return false;
+		}
+
+		// Push from the other clone: half of the files of the previous push are modified, the other half deleted, and new files are added
+		TArray<FString> UpstreamFiles;
+		auto PushUpstream = [&](const int32 InPush, TArray<FString>& OutChangedFiles, TArray<FString>& OutDeletedFiles)
+		{
+			TArray<FString> NewUpstreamFiles;
+			for(int32 Index = 0; Index < UpstreamFiles.Num(); Index++)
+			{
+				if(Index % 2 == 0)
+				{
+					WriteAsset(UpstreamDir / UpstreamFiles[Index], false, InRandom);
+					NewUpstreamFiles.Add(UpstreamFiles[Index]);
+				}
+				else
+				{
+					IFileManager::Get().Delete(*(UpstreamDir / UpstreamFiles[Index]));
+					OutDeletedFiles.Add(FPaths::ConvertRelativePathToFull(RepositoryDir, UpstreamFiles[Index]));
+				}
+				OutChangedFiles.Add(FPaths::ConvertRelativePathToFull(RepositoryDir, UpstreamFiles[Index]));
+			}
+			for(int32 Index = 0; Index < NumFilesPerCommit; Index++)
+			{
+				const FString File = FString::Printf(TEXT("Content/Upstream/Push%03d_%03d.uasset"), InPush, Index);
+				WriteAsset(UpstreamDir / File, false, InRandom);
+				NewUpstreamFiles.Add(File);
+				OutChangedFiles.Add(FPaths::ConvertRelativePathToFull(RepositoryDir, File));
+			}
+			UpstreamFiles = MoveTemp(NewUpstreamFiles);
+
+			bool bPushed = RunGit(InPathToGitBinary, UpstreamDir, TEXT("add"), { TEXT("--all") });
+			bPushed &= RunGit(InPathToGitBinary, UpstreamDir, TEXT("commit"), { TEXT("--quiet"), FString::Printf(TEXT("-m \"Upstream %d\""), InPush) });
+			bPushed &= RunGit(InPathToGitBinary, UpstreamDir, TEXT("push"), { TEXT("--quiet"), TEXT("origin"), TEXT("HEAD") });
+			return bPushed;
+		};
+
+		// SyncAll as issued by the menu, checking the files it reports
+		auto SyncAll = [&](const TArray<FString>& InExpectedChangedFiles, const TArray<FString>& InExpectedDeletedFiles)
+		{
+			TSharedRef<FGitSyncAll, ESPMode::ThreadSafe> Operation = ISourceControlOperation::Create<FGitSyncAll>();
+			TSharedRef<FGitSyncWorker, ESPMode::ThreadSafe> Worker = MakeShared<FGitSyncWorker, ESPMode::ThreadSafe>();
+			FGitSourceControlCommand Command(Operation, Worker);
+			Command.PathToGitBinary = InPathToGitBinary;
+			Command.PathToRepositoryRoot = RepositoryDir;
+			Command.bUsingGitLfsLocking = false;
+			bool bPassed = Command.DoWork();
+			if(!bPassed)
+			{
+				UE_LOG(LogSourceControl, Error, TEXT("Sync failed: %s"), *FString::Join(Command.ErrorMessages, TEXT("\n")));
+			}
+			bPassed &= CheckSyncedFiles(TEXT("changed"), Operation->ChangedFiles, InExpectedChangedFiles);
+			bPassed &= CheckSyncedFiles(TEXT("deleted"), Worker->DeletedFiles, InExpectedDeletedFiles);
+			return bPassed;
+		};
+
+		// A first push and Sync (not measured) so that each measured one also modifies and deletes files
+		TArray<FString> ChangedFiles;
+		TArray<FString> DeletedFiles;
+		if(!PushUpstream(0, ChangedFiles, DeletedFiles))
+		{
+			return false;
+		}
+		FMeasure Measure;
+		Measure.Name = TEXT("SyncAll");
+		Measure.bPassed = SyncAll(ChangedFiles, DeletedFiles);
+		for(int32 Iteration = 0; Iteration < InParameters.Iterations; Iteration++)
+		{
+			ChangedFiles.Reset();
+			DeletedFiles.Reset();
+			if(!PushUpstream(Iteration + 1, ChangedFiles, DeletedFiles))
+			{
+				return false;
+			}
+			const int32 NumProcessesBefore = GitSourceControlCore::GetNumProcessesOnThread();
+			const double StartTime = FPlatformTime::Seconds();
+			const bool bPassed = SyncAll(ChangedFiles, DeletedFiles);
+			Measure.Durations.Add(FPlatformTime::Seconds() - StartTime);
+			if(Iteration == 0)
+			{
+				Measure.NumProcesses = GitSourceControlCore::GetNumProcessesOnThread() - NumProcessesBefore;
+			}
+			Measure.bPassed &= bPassed;
+		}
+		UE_LOG(LogSourceControl, Display, TEXT("Sync: changed and deleted files %s"), Measure.bPassed ? TEXT("as expected") : TEXT("NOT as expected"));
+		LogMeasure(Measure);
+		OutMeasures.Add(MoveTemp(Measure));
+		return true;
+	}
+
+	/** @param	InNumReplayed, InNumNotReplayed		Numbers of git command lines answered by the stub, and run by git for lack of a matching response, if replaying */
+	static bool WriteResults(const FString& InFilename, const FString& InPathToGitBinary, const FParameters& InParameters, const TArray<FMeasure>& InMeasures, const int32 InNumReplayed, const int32 InNumNotReplayed)
+	{
+		TSharedRef<FJsonObject> Parameters = MakeShared<FJsonObject>();
+		Parameters->SetNumberField(TEXT("Assets"), InParameters.NumAssets);
+		Parameters->SetNumberField(TEXT("FanOut"), InParameters.FanOut);
+		Parameters->SetNumberField(TEXT("History"), InParameters.HistoryDepth);
+		Parameters->SetNumberField(TEXT("LfsRatio"), InParameters.LfsRatio);
+		Parameters->SetNumberField(TEXT("DirtyRatio"), InParameters.DirtyRatio);
+		Parameters->SetNumberField(TEXT("Iterations"), InParameters.Iterations);
+		Parameters->SetNumberField(TEXT("Seed"), InParameters.Seed);
+		Parameters->SetStringField(TEXT("Replay"), FPaths::GetCleanFilename(InParameters.ReplayFile));
+		if(InParameters.LockServerPort != 0)
+		{
+			Parameters->SetNumberField(TEXT("LockLatencyMs"), InParameters.LockLatencyMs);
+			Parameters->SetNumberField(TEXT("Locks"), InParameters.NumLocks);
+			Parameters->SetNumberField(TEXT("LockFiles"), InParameters.NumLockFiles);
+			Parameters->SetNumberField(TEXT("Clients"), InParameters.NumClients);
+		}
+
+		TArray<TSharedPtr<FJsonValue>> Measures;
+		for(const FMeasure& Measure : InMeasures)
+		{
+			double Total = 0.0;
+			TArray<TSharedPtr<FJsonValue>> Durations;
+			for(const double Duration : Measure.Durations)
+			{
+				Total += Duration;
+				Durations.Add(MakeShared<FJsonValueNumber>(Duration * 1000.0));
+			}
+			TSharedRef<FJsonObject> Result = MakeShared<FJsonObject>();
+			Result->SetStringField(TEXT("Name"), Measure.Name);
+			Result->SetNumberField(TEXT("MedianMs"), Measure.Durations[Measure.Durations.Num() / 2] * 1000.0);
+			Result->SetNumberField(TEXT("MeanMs"), Total / Measure.Durations.Num() * 1000.0);
+			Result->SetNumberField(TEXT("MinMs"), Measure.Durations[0] * 1000.0);
+			Result->SetNumberField(TEXT("MaxMs"), Measure.Durations.Last() * 1000.0);
+			Result->SetNumberField(TEXT("Processes"), Measure.NumProcesses);
+			Result->SetBoolField(TEXT("Passed"), Measure.bPassed);
+			Result->SetArrayField(TEXT("DurationsMs"), Durations);
+			Measures.Add(MakeShared<FJsonValueObject>(Result));
+		}
+
+		FString GitVersion;
+		FString ErrorMessages;
+		GitSourceControlCore::RunCommandInternalRaw(TEXT("version"), InPathToGitBinary, FString(), TArray<FString>(), TArray<FString>(), GitVersion, ErrorMessages);
+
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetStringField(TEXT("Date"), FDateTime::UtcNow().ToIso8601());
+		Root->SetStringField(TEXT("Platform"), FPlatformProperties::IniPlatformName());
+		Root->SetStringField(TEXT("GitVersion"), GitVersion.TrimStartAndEnd());
+		Root->SetObjectField(TEXT("Parameters"), Parameters);
+		if(!InParameters.ReplayFile.IsEmpty())
+		{
+			Root->SetNumberField(TEXT("Replayed"), InNumReplayed);
+			Root->SetNumberField(TEXT("NotReplayed"), InNumNotReplayed);
+		}
+		Root->SetArrayField(TEXT("Results"), Measures);
+
+		FString Json;
+		const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+		return FJsonSerializer::Serialize(Root, Writer) && FFileHelper::SaveStringToFile(Json, *InFilename);
+	}
+}
+
+UGitSourceControlBenchmarkCommandlet::UGitSourceControlBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UGitSourceControlBenchmarkCommandlet::Main(const FString& Params)
+{
+	using namespace GitSourceControlBenchmark;
+
+	FParameters Parameters;
+	FParse::Value(*Params, TEXT("Assets="), Parameters.NumAssets);
+	FParse::Value(*Params, TEXT("FanOut="), Parameters.FanOut);
+	FParse::Value(*Params, TEXT("History="), Parameters.HistoryDepth);
+	FParse::Value(*Params, TEXT("LfsRatio="), Parameters.LfsRatio);
+	FParse::Value(*Params, TEXT("DirtyRatio="), Parameters.DirtyRatio);
+	FParse::Value(*Params, TEXT("Iterations="), Parameters.Iterations);
+	FParse::Value(*Params, TEXT("Seed="), Parameters.Seed);
+	FParse::Value(*Params, TEXT("Replay="), Parameters.ReplayFile);
+	FParse::Value(*Params, TEXT("Record="), Parameters.RecordFile);
+	FParse::Value(*Params, TEXT("LockServerPort="), Parameters.LockServerPort);
+	FParse::Value(*Params, TEXT("LockLatencyMs="), Parameters.LockLatencyMs);
+	FParse::Value(*Params, TEXT("Locks="), Parameters.NumLocks);
+	FParse::Value(*Params, TEXT("LockFiles="), Parameters.NumLockFiles);
+	FParse::Value(*Params, TEXT("Clients="), Parameters.NumClients);
+	Parameters.NumAssets = FMath::Max(Parameters.NumAssets, NumFilesPerStatus);
+	Parameters.Iterations = FMath::Max(Parameters.Iterations, 1);
+
+	FGitSourceControlModule& GitSourceControl = FModuleManager::LoadModuleChecked<FGitSourceControlModule>("GitSourceControl");
+	FString PathToGitBinary;
+	if(!FParse::Value(*Params, TEXT("Git="), PathToGitBinary))
+	{
+		PathToGitBinary = GitSourceControl.AccessSettings().GetBinaryPath();
+		if(PathToGitBinary.IsEmpty())
+		{
+			PathToGitBinary = GitSourceControlUtils::FindGitBinaryPath();
+		}
+	}
+	FGitVersion GitVersion;
+	if(PathToGitBinary.IsEmpty() || !GitSourceControlUtils::CheckGitAvailability(PathToGitBinary, &GitVersion))
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("Git not found, use -Git=<path to git>"));
+		return 1;
+	}
+
+	FString WorkDir;
+	if(!FParse::Value(*Params, TEXT("WorkDir="), WorkDir))
+	{
+		WorkDir = FPaths::ProjectSavedDir() / TEXT("GitBenchmark") / FDateTime::Now().ToString();
+	}
+	WorkDir = FPaths::ConvertRelativePathToFull(WorkDir);
+	FString Output;
+	if(!FParse::Value(*Params, TEXT("Output="), Output))
+	{
+		Output = FPaths::ProjectSavedDir() / TEXT("GitBenchmark") / TEXT("Results.json");
+	}
+
+	UE_LOG(LogSourceControl, Display, TEXT("Generating a repository of %d assets in %d directories with %d commits in %s..."), Parameters.NumAssets, Parameters.FanOut, Parameters.HistoryDepth, *WorkDir);
+	TArray<FString> Assets;
+	TArray<bool> IsLfsPointer;
+	if(!GenerateRepository(PathToGitBinary, WorkDir, Parameters, Assets, IsLfsPointer))
+	{
+		return 1;
+	}
+	const FString RepositoryDir = WorkDir / TEXT("Repository");
+
+	// The git engine runs on the generated repository, independently of the provider (and of the project)
+	FGitCheckIgnore CheckIgnore;
+	CheckIgnore.Init(PathToGitBinary, RepositoryDir);
+	{
+		FGitEngineSettings EngineSettings;
+		EngineSettings.LfsUserName = LockOwner;
+		EngineSettings.MainRepositoryRoot = RepositoryDir;
+		EngineSettings.bHasCatFileWithFilters = GitVersion.bHasCatFileWithFilters;
+		EngineSettings.GetIgnoredFiles = [&CheckIgnore](const TArray<FString>& InFiles) { return CheckIgnore.GetIgnoredFiles(InFiles); };
+		GitSourceControlCore::SetEngineSettings(MoveTemp(EngineSettings));
+	}
+
+	FRandomStream Random(Parameters.Seed + 1);
+	TArray<FString> StatusFiles;
+	for(int32 Index = 0; Index < NumFilesPerStatus; Index++)
+	{
+		StatusFiles.Add(Assets[Random.RandRange(0, Assets.Num() - 1)]);
+	}
+	const FString HistoryFile = Assets[0];
+	const FString DumpFile = FPaths::CreateTempFilename(*WorkDir, TEXT("Dump-"), TEXT(".uasset"));
+	FString DumpParameter = TEXT("HEAD:") + HistoryFile;
+	DumpParameter.ReplaceInline(*(RepositoryDir + TEXT("/")), TEXT(""));
+
+	// NOTE the repository is generated by git in any case, as the stub replays the outputs of the measured commands only
+	if(!Parameters.ReplayFile.IsEmpty())
+	{
+		if(!FGitProcessStub::Get().LoadResponses(Parameters.ReplayFile))
+		{
+			return 1;
+		}
+	}
+	else if(!Parameters.RecordFile.IsEmpty())
+	{
+		FGitProcessStub::Get().StartRecording();
+	}
+
+	TArray<FMeasure> Measures;
+	Measures.Add(Measure(TEXT("UpdateStatus.Directory"), Parameters.Iterations, [&](int32)
+	{
+		TArray<FString> ErrorMessages;
+		TArray<FGitSourceControlState> States;
+		GitSourceControlUtils::RunUpdateStatus(PathToGitBinary, RepositoryDir, false, { RepositoryDir / TEXT("Content/") }, ErrorMessages, States);
+	}));
+	Measures.Add(Measure(TEXT("UpdateStatus.Files"), Parameters.Iterations, [&](int32)
+	{
+		TArray<FString> ErrorMessages;
+		TArray<FGitSourceControlState> States;
+		GitSourceControlUtils::RunUpdateStatus(PathToGitBinary, RepositoryDir, false, StatusFiles, ErrorMessages, States);
+	}));
+	Measures.Add(Measure(TEXT("GetHistory"), Parameters.Iterations, [&](int32)
+	{
+		TArray<FString> ErrorMessages;
+		TGitSourceControlHistory History;
+		GitSourceControlUtils::RunGetHistory(PathToGitBinary, RepositoryDir, HistoryFile, false, ErrorMessages, History);
+	}));
+	Measures.Add(Measure(TEXT("DumpToFile"), Parameters.Iterations, [&](int32)
+	{
+		GitSourceControlCore::RunDumpToFile(PathToGitBinary, RepositoryDir, DumpParameter, DumpFile);
+	}));
+	Measures.Add(Measure(TEXT("Connect"), Parameters.Iterations, [&](int32)
+	{
+		FGitSourceControlCommand Command(ISourceControlOperation::Create<FConnect>(), MakeShared<FGitConnectWorker, ESPMode::ThreadSafe>());
+		Command.PathToGitBinary = PathToGitBinary;
+		Command.PathToRepositoryRoot = RepositoryDir;
+		Command.DoWork();
+	}));
+	Measures.Add(Measure(TEXT("Commit"), Parameters.Iterations, [&](int32 Iteration)
+	{
+		// NOTE the durations include writing the files to commit
+		TArray<FString> Files;
+		for(int32 Index = 0; Index < NumFilesPerCommit; Index++)
+		{
+			const int32 AssetIndex = Random.RandRange(0, Assets.Num() - 1);
+			WriteAsset(Assets[AssetIndex], IsLfsPointer[AssetIndex], Random);
+			Files.AddUnique(Assets[AssetIndex]);
+		}
+		TArray<FString> Results;
+		TArray<FString> ErrorMessages;
+		GitSourceControlCore::RunCommit(PathToGitBinary, RepositoryDir, { FString::Printf(TEXT("-m \"Benchmark %d\""), Iteration) }, Files, Results, ErrorMessages);
+	}));
+
+	if(Parameters.ReplayFile.IsEmpty() && !Parameters.RecordFile.IsEmpty() && !FGitProcessStub::Get().SaveResponses(Parameters.RecordFile))
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("Failed to write the responses to %s"), *Parameters.RecordFile);
+	}
+	const int32 NumReplayed = FGitProcessStub::Get().GetNumMatched();
+	const int32 NumNotReplayed = FGitProcessStub::Get().GetNumUnmatched();
+	if(!Parameters.ReplayFile.IsEmpty() && (NumNotReplayed > 0))
+	{
+		UE_LOG(LogSourceControl, Warning, TEXT("%d git command(s) without a matching response were run by git (%d replayed): the measures include git"), NumNotReplayed, NumReplayed);
+	}
+	FGitProcessStub::Get().Disable();
+
+	// The Sync and lock measures run git, in any case (the Sync also checks its results, which requires actual pulls)
+	if(!MeasureSync(PathToGitBinary, WorkDir, Parameters, Random, Measures))
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("Failed to set up the Sync scenario"));
+	}
+	if((Parameters.LockServerPort != 0) && !MeasureLockServer(PathToGitBinary, WorkDir, Parameters, Assets, Measures))
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("Failed to measure the locks on the local LFS lock server"));
+	}
+
+	// Give the git engine back to the provider
+	GitSourceControl.GetProvider().UpdateEngineSettings();
+	CheckIgnore.Close();
+
+	IFileManager::Get().Delete(*DumpFile);
+	if(!FParse::Param(*Params, TEXT("KeepRepository")))
+	{
+		IFileManager::Get().DeleteDirectory(*WorkDir, false, true);
+	}
+
+	if(!WriteResults(Output, PathToGitBinary, Parameters, Measures, NumReplayed, NumNotReplayed))
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("Failed to write the results to %s"), *Output);
+		return 1;
+	}
+	UE_LOG(LogSourceControl, Display, TEXT("Results written to %s"), *FPaths::ConvertRelativePathToFull(Output));
+	return Measures.ContainsByPredicate([](const FMeasure& InMeasure) { return !InMeasure.bPassed; }) ? 1 : 0;
+}
@@ -0,0 +1,43 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "GitSourceControlBenchmarkCommandlet.generated.h"
+
+/**
+ * Headless benchmark of the Git provider, on a synthetic repository generated locally with a bare remote (no network access).
+ *
+ * Times RunUpdateStatus (of a directory and of files), RunGetHistory, RunCommit, RunDumpToFile and the Connect worker,
+ * and writes the durations and numbers of git processes to a JSON file, to be tracked over time.
+ *
+ * Also runs a Sync scenario: pushes from a second clone (added, modified and deleted files), then times the SyncAll of the repository
+ * and checks the changed and deleted files it reports (the exit code is then 1 if they are not the expected ones).
+ *
+ * UnrealEditor-Cmd <Project>.uproject -run=GitSourceControlBenchmark [-Assets=1000] [-FanOut=10] [-History=10] [-LfsRatio=0.5]
+ *     [-DirtyRatio=0.05] [-Iterations=5] [-Seed=0] [-Git=<path to git>] [-WorkDir=<directory>] [-Output=<file.json>] [-KeepRepository]
+ *     [-Record=<responses.json> | -Replay=<responses.json>] [-LockServerPort=<port> [-LockLatencyMs=0] [-Locks=10000] [-LockFiles=500] [-Clients=4]]
+ *
+ * -Record saves the outputs of git during the measures, that -Replay then answers in-process (see FGitProcessStub),
+ * to measure the parsers and the scheduling independently of the speed of git (with the same -Seed, as the command lines contain the paths of the files,
+ * relative to the repository); the command lines without a matching response are still run by git, and counted in the results.
+ *
+ * -LockServerPort also measures the listing of the locks, the locking and unlocking of files, and the contention of users (clones) locking
+ * the same files, against a local LFS lock server (see FGitLfsLockServer), with git-lfs installed.
+ */
+UCLASS()
+class UGitSourceControlBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UGitSourceControlBenchmarkCommandlet();
+
+	// UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,318 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlLfsLockServer.h"
+
+#include "Algo/BinarySearch.h"
+#include "Algo/Count.h"
+#include "Containers/Ticker.h"
+#include "Dom/JsonObject.h"
+#include "HttpPath.h"
+#include "HttpServerModule.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "IHttpRouter.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "ISourceControlModule.h"
+
+namespace GitLfsLockServerConstants
+{
+	/** Content type of the requests and responses of the Git LFS API */
+	static const FString ContentType = TEXT("application/vnd.git-lfs+json");
+
+	/** Header giving the owner of the locks of a request, and the owner if there is none */
+	static const FString OwnerHeader = TEXT("X-Lock-Owner");
+	static const FString DefaultOwner = TEXT("Anonymous");
+
+	/** Number of locks in a page of a list, if the client does not ask for a limit */
+	const int32 DefaultLimit = 100;
+}
+
+FGitLfsLockServer::~FGitLfsLockServer()
+{
+	Stop();
+}
+
+bool FGitLfsLockServer::Start(const uint32 InPort, const double InLatency)
+{
+	Router = FHttpServerModule::Get().GetHttpRouter(InPort);
+	if(!Router.IsValid())
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("LFS lock server: failed to listen on port %u"), InPort);
+		return false;
+	}
+
+	// NOTE the router dispatches "/locks/verify" and "/locks/<id>/unlock" to the handler of their parent path "/locks"
+#if ENGINE_MAJOR_VERSION == 5 && ENGINE_MINOR_VERSION >= 1
+	RouteHandle = Router->BindRoute(FHttpPath(TEXT("/locks")), EHttpServerRequestVerbs::VERB_GET | EHttpServerRequestVerbs::VERB_POST, FHttpRequestHandler::CreateRaw(this, &FGitLfsLockServer::HandleRequest));
+#else
+	RouteHandle = Router->BindRoute(FHttpPath(TEXT("/locks")), EHttpServerRequestVerbs::VERB_GET | EHttpServerRequestVerbs::VERB_POST, [this](const FHttpServerRequest& InRequest, const FHttpResultCallback& InOnComplete) { return HandleRequest(InRequest, InOnComplete); });
+#endif
+	if(!RouteHandle.IsValid())
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("LFS lock server: failed to bind the locks API on port %u"), InPort);
+		Router.Reset();
+		return false;
+	}
+	FHttpServerModule::Get().StartAllListeners();
+	Port = InPort;
+	Latency = InLatency;
+	UE_LOG(LogSourceControl, Log, TEXT("LFS lock server: listening on %s"), *GetUrl());
+	return true;
+}
+
+void FGitLfsLockServer::Stop()
+{
+	if(Router.IsValid())
+	{
+		Router->UnbindRoute(RouteHandle);
+		RouteHandle.Reset();
+		Router.Reset();
+		FHttpServerModule::Get().StopAllListeners();
+	}
+	Locks.Empty();
+	LockIdByPath.Empty();
+}
+
+FString FGitLfsLockServer::GetUrl() const
+{
+	return FString::Printf(TEXT("http://127.0.0.1:%u/"), Port);
+}
+
+void FGitLfsLockServer::AddLocks(const TArray<FString>& InPaths, const FString& InOwner)
+{
+	for(const FString& Path : InPaths)
+	{
+		if(!LockIdByPath.Contains(Path))
+		{
+			AddLock(Path, InOwner);
+		}
+	}
+}
+
+void FGitLfsLockServer::RemoveLocks(const FString& InOwner)
+{
+	Locks.RemoveAll([this, &InOwner](const FLock& InLock)
+	{
+		if(InLock.Owner == InOwner)
+		{
+			LockIdByPath.Remove(InLock.Path);
+			return true;
+		}
+		return false;
+	});
+}
+
+int32 FGitLfsLockServer::GetNumLocks(const FString& InOwner) const
+{
+	return Algo::CountIf(Locks, [&InOwner](const FLock& InLock) { return InLock.Owner == InOwner; });
+}
+
+const FGitLfsLockServer::FLock& FGitLfsLockServer::AddLock(const FString& InPath, const FString& InOwner)
+{
+	FLock& Lock = Locks.AddDefaulted_GetRef();
+	Lock.Id = NextId++;
+	Lock.Path = InPath;
+	Lock.Owner = InOwner;
+	Lock.LockedAt = FDateTime::UtcNow();
+	LockIdByPath.Add(InPath, Lock.Id);
+	return Lock;
+}
+
+int32 FGitLfsLockServer::FindLock(const int32 InId) const
+{
+	return Algo::BinarySearchBy(Locks, InId, [](const FLock& InLock) { return InLock.Id; });
+}
+
+static TSharedRef<FJsonObject> LockToJson(const int32 InId, const FString& InPath, const FString& InOwner, const FDateTime& InLockedAt)
+{
+	TSharedRef<FJsonObject> Owner = MakeShared<FJsonObject>();
+	Owner->SetStringField(TEXT("name"), InOwner);
+	TSharedRef<FJsonObject> Lock = MakeShared<FJsonObject>();
+	Lock->SetStringField(TEXT("id"), FString::FromInt(InId));
+	Lock->SetStringField(TEXT("path"), InPath);
+	Lock->SetStringField(TEXT("locked_at"), InLockedAt.ToIso8601());
+	Lock->SetObjectField(TEXT("owner"), Owner);
+	return Lock;
+}
+
+static TSharedRef<FJsonObject> MessageToJson(const FString& InMessage)
+{
+	TSharedRef<FJsonObject> Body = MakeShared<FJsonObject>();
+	Body->SetStringField(TEXT("message"), InMessage);
+	return Body;
+}
+
+bool FGitLfsLockServer::HandleRequest(const FHttpServerRequest& InRequest, const FHttpResultCallback& InOnComplete)
+{
+	FString Owner = GitLfsLockServerConstants::DefaultOwner;
+	for(const auto& Header : InRequest.Headers)
+	{
+		if(Header.Key.Equals(GitLfsLockServerConstants::OwnerHeader, ESearchCase::IgnoreCase) && (Header.Value.Num() > 0))
+		{
+			Owner = Header.Value[0].TrimStartAndEnd();
+		}
+	}
+
+	TSharedPtr<FJsonObject> Request = MakeShared<FJsonObject>();
+	if(InRequest.Body.Num() > 0)
+	{
+		const FUTF8ToTCHAR Body(reinterpret_cast<const ANSICHAR*>(InRequest.Body.GetData()), InRequest.Body.Num());
+		if(!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(FString(Body.Length(), Body.Get())), Request) || !Request.IsValid())
+		{
+			Respond(InOnComplete, 400, MessageToJson(TEXT("invalid JSON body")));
+			return true;
+		}
+	}
+
+	// Sub-path after "/locks": empty, "/verify" or "/<id>/unlock"
+	FString SubPath = InRequest.RelativePath.GetPath();
+	SubPath.RemoveFromStart(TEXT("/locks"));
+	TArray<FString> Segments;
+	SubPath.ParseIntoArray(Segments, TEXT("/"));
+
+	if((Segments.Num() == 0) && (InRequest.Verb == EHttpServerRequestVerbs::VERB_POST))
+	{
+		// Create a lock
+		FString Path;
+		if(!Request->TryGetStringField(TEXT("path"), Path) || Path.IsEmpty())
+		{
+			Respond(InOnComplete, 422, MessageToJson(TEXT("missing path")));
+			return true;
+		}
+		TSharedRef<FJsonObject> Body = MakeShared<FJsonObject>();
+		if(const int32* ExistingId = LockIdByPath.Find(Path))
+		{
+			const FLock& Lock = Locks[FindLock(*ExistingId)];
+			Body->SetObjectField(TEXT("lock"), LockToJson(Lock.Id, Lock.Path, Lock.Owner, Lock.LockedAt));
+			Body->SetStringField(TEXT("message"), TEXT("already created lock"));
+			Respond(InOnComplete, 409, Body);
+			return true;
+		}
+		const FLock& Lock = AddLock(Path, Owner);
+		Body->SetObjectField(TEXT("lock"), LockToJson(Lock.Id, Lock.Path, Lock.Owner, Lock.LockedAt));
+		Respond(InOnComplete, 201, Body);
+		return true;
+	}
+
+	if(((Segments.Num() == 0) && (InRequest.Verb == EHttpServerRequestVerbs::VERB_GET)) || ((Segments.Num() == 1) && (Segments[0] == TEXT("verify"))))
+	{
+		// List the locks (filtered by path or identifier), or verify them (split into ours and theirs), a page after the cursor
+		const bool bVerify = (Segments.Num() == 1);
+		FString Cursor;
+		int32 Limit = 0;
+		FString PathFilter;
+		FString IdFilter;
+		if(bVerify)
+		{
+			Request->TryGetStringField(TEXT("cursor"), Cursor);
+			Request->TryGetNumberField(TEXT("limit"), Limit);
+		}
+		else
+		{
+			const FString* Value = InRequest.QueryParams.Find(TEXT("cursor"));
+			Cursor = Value ? *Value : FString();
+			Value = InRequest.QueryParams.Find(TEXT("limit"));
+			Limit = Value ? FCString::Atoi(**Value) : 0;
+			Value = InRequest.QueryParams.Find(TEXT("path"));
+			PathFilter = Value ? *Value : FString();
+			Value = InRequest.QueryParams.Find(TEXT("id"));
+			IdFilter = Value ? *Value : FString();
+		}
+		if(Limit <= 0)
+		{
+			Limit = GitLfsLockServerConstants::DefaultLimit;
+		}
+
+		// The cursor is the identifier of the first lock of the page
+		const int32 FirstId = Cursor.IsEmpty() ? 0 : FCString::Atoi(*Cursor);
+		TArray<TSharedPtr<FJsonValue>> Ours;
+		TArray<TSharedPtr<FJsonValue>> Theirs;
+		int32 Index = Algo::LowerBoundBy(Locks, FirstId, [](const FLock& InLock) { return InLock.Id; });
+		for(; (Index < Locks.Num()) && (Ours.Num() + Theirs.Num() < Limit); Index++)
+		{
+			const FLock& Lock = Locks[Index];
+			if((PathFilter.IsEmpty() || (Lock.Path == PathFilter)) && (IdFilter.IsEmpty() || (FString::FromInt(Lock.Id) == IdFilter)))
+			{
+				TArray<TSharedPtr<FJsonValue>>& List = (bVerify && (Lock.Owner != Owner)) ? Theirs : Ours;
+				List.Add(MakeShared<FJsonValueObject>(LockToJson(Lock.Id, Lock.Path, Lock.Owner, Lock.LockedAt)));
+			}
+		}
+
+		TSharedRef<FJsonObject> Body = MakeShared<FJsonObject>();
+		if(bVerify)
+		{
+			Body->SetArrayField(TEXT("ours"), Ours);
+			Body->SetArrayField(TEXT("theirs"), Theirs);
+		}
+		else
+		{
+			Body->SetArrayField(TEXT("locks"), Ours);
+		}
+		if(Index < Locks.Num())
+		{
+			Body->SetStringField(TEXT("next_cursor"), FString::FromInt(Locks[Index].Id));
+		}
+		Respond(InOnComplete, 200, Body);
+		return true;
+	}
+
+	if((Segments.Num() == 2) && (Segments[1] == TEXT("unlock")) && (InRequest.Verb == EHttpServerRequestVerbs::VERB_POST))
+	{
+		// Delete a lock, only by its owner unless forced
+		const int32 Index = FindLock(FCString::Atoi(*Segments[0]));
+		if(Index == INDEX_NONE)
+		{
+			Respond(InOnComplete, 404, MessageToJson(TEXT("unable to find lock")));
+			return true;
+		}
+		bool bForce = false;
+		Request->TryGetBoolField(TEXT("force"), bForce);
+		const FLock Lock = Locks[Index];
+		if((Lock.Owner != Owner) && !bForce)
+		{
+			Respond(InOnComplete, 403, MessageToJson(FString::Printf(TEXT("lock owned by %s"), *Lock.Owner)));
+			return true;
+		}
+		Locks.RemoveAt(Index);
+		LockIdByPath.Remove(Lock.Path);
+		TSharedRef<FJsonObject> Body = MakeShared<FJsonObject>();
+		Body->SetObjectField(TEXT("lock"), LockToJson(Lock.Id, Lock.Path, Lock.Owner, Lock.LockedAt));
+		Respond(InOnComplete, 200, Body);
+		return true;
+	}
+
+	Respond(InOnComplete, 404, MessageToJson(TEXT("not found")));
+	return true;
+}
+
+void FGitLfsLockServer::Respond(const FHttpResultCallback& InOnComplete, const int32 InCode, const TSharedRef<FJsonObject>& InBody) const
+{
+	FString Json;
+	FJsonSerializer::Serialize(InBody, TJsonWriterFactory<>::Create(&Json));
+
+	// NOTE the response is built when sent, as the callback of the ticker has to be copyable
+	auto Send = [InOnComplete, InCode, Json]()
+	{
+		TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Create(Json, GitLfsLockServerConstants::ContentType);
+		Response->Code = static_cast<EHttpServerResponseCodes>(InCode);
+		InOnComplete(MoveTemp(Response));
+	};
+	if(Latency > 0.0)
+	{
+		// Answer later, without blocking the other requests
+#if ENGINE_MAJOR_VERSION == 5
+		FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Send](float) { Send(); return false; }), Latency);
+#else
+		FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Send](float) { Send(); return false; }), Latency);
+#endif
+	}
+	else
+	{
+		Send();
+	}
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HttpRouteHandle.h"
+#include "HttpResultCallback.h"
+
+class IHttpRouter;
+struct FHttpServerRequest;
+
+/**
+ * Local stand-in for a Git LFS server, implementing only the File Locking API (create, list, verify and unlock), in memory,
+ * to measure and test the lock code paths without external services: point the "lfs.url" of a repository to GetUrl().
+ *
+ * As the API has no notion of user without authentication, the owner of a lock is given by the "X-Lock-Owner" header
+ * (set by "git config http.extraHeader 'X-Lock-Owner: <name>'"), so that clones of a repository act as different users.
+ *
+ * Runs on the game thread, like the listeners of the HTTP server: a process waiting for its answers must run on another thread
+ * while the game thread ticks the core ticker.
+ * @see https://github.com/git-lfs/git-lfs/blob/main/docs/api/locking.md
+ */
+class FGitLfsLockServer
+{
+public:
+	~FGitLfsLockServer();
+
+	/** Start listening on the port; the server answers each request after the latency (in seconds) */
+	bool Start(const uint32 InPort, const double InLatency = 0.0);
+
+	/** Stop listening and drop all locks */
+	void Stop();
+
+	/** @returns the URL to use as "lfs.url" */
+	FString GetUrl() const;
+
+	/** Lock these paths (relative to the root of the repository) directly, without any request */
+	void AddLocks(const TArray<FString>& InPaths, const FString& InOwner);
+
+	/** Unlock all the locks of this owner directly, without any request */
+	void RemoveLocks(const FString& InOwner);
+
+	/** @returns the number of locks of this owner */
+	int32 GetNumLocks(const FString& InOwner) const;
+
+private:
+	struct FLock
+	{
+		int32 Id;
+		FString Path;
+		FString Owner;
+		FDateTime LockedAt;
+	};
+
+	bool HandleRequest(const FHttpServerRequest& InRequest, const FHttpResultCallback& InOnComplete);
+
+	/** Answer a request with a status code and a JSON body, after the latency */
+	void Respond(const FHttpResultCallback& InOnComplete, const int32 InCode, const TSharedRef<class FJsonObject>& InBody) const;
+
+	/** Add a lock to the end of the list (the identifiers being increasing, the list is sorted by identifier) */
+	const FLock& AddLock(const FString& InPath, const FString& InOwner);
+
+	/** @returns the index of the lock in the list, or INDEX_NONE */
+	int32 FindLock(const int32 InId) const;
+
+	TSharedPtr<IHttpRouter> Router;
+	FHttpRouteHandle RouteHandle;
+	uint32 Port = 0;
+	double Latency = 0.0;
+
+	/** Locks sorted by identifier, the identifier of the lock of each path, and the next identifier */
+	TArray<FLock> Locks;
+	TMap<FString, int32> LockIdByPath;
+	int32 NextId = 1;
+};
@@ -0,0 +1,212 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlProcessStub.h"
+
+#include "Dom/JsonObject.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "ISourceControlModule.h"
+
+const TCHAR* FGitProcessStub::RootToken = TEXT("{Root}");
+
+/** Replace the root of the repository by the token, in a command line or an output, for the responses not to depend on where the repository is */
+static FString TokenizeRoot(const FString& InText, const FString& InRepositoryRoot)
+{
+	return InRepositoryRoot.IsEmpty() ? InText : InText.Replace(*InRepositoryRoot, FGitProcessStub::RootToken, ESearchCase::CaseSensitive);
+}
+
+/** Replace the token by the root of the repository, in a replayed output */
+static FString DetokenizeRoot(const FString& InText, const FString& InRepositoryRoot)
+{
+	return InText.Replace(FGitProcessStub::RootToken, *InRepositoryRoot, ESearchCase::CaseSensitive);
+}
+
+FGitProcessStub::FGitProcessStub()
+{
+	ReleaseEvent = FPlatformProcess::GetSynchEventFromPool(true);
+}
+
+FGitProcessStub::~FGitProcessStub()
+{
+	Disable();
+	FPlatformProcess::ReturnSynchEventToPool(ReleaseEvent);
+	ReleaseEvent = nullptr;
+}
+
+FGitProcessStub& FGitProcessStub::Get()
+{
+	static FGitProcessStub ProcessStub;
+	return ProcessStub;
+}
+
+void FGitProcessStub::SetResponses(TArray<FGitStubResponse>&& InResponses)
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	Responses = MoveTemp(InResponses);
+	ReleaseEvent->Reset();
+	FPlatformAtomics::InterlockedExchange(&NumMatched, 0);
+	FPlatformAtomics::InterlockedExchange(&NumUnmatched, 0);
+	FPlatformAtomics::InterlockedExchange(&bRecording, 0);
+	FPlatformAtomics::InterlockedExchange(&bReplaying, 1);
+	UE_LOG(LogSourceControl, Log, TEXT("Git process stub: replaying %d response(s)"), Responses.Num());
+}
+
+bool FGitProcessStub::LoadResponses(const FString& InFilename)
+{
+	FString Json;
+	TArray<TSharedPtr<FJsonValue>> Values;
+	if(!FFileHelper::LoadFileToString(Json, *InFilename) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Values))
+	{
+		UE_LOG(LogSourceControl, Error, TEXT("Git process stub: failed to read the responses from '%s'"), *InFilename);
+		return false;
+	}
+
+	TArray<FGitStubResponse> LoadedResponses;
+	for(const TSharedPtr<FJsonValue>& Value : Values)
+	{
+		const TSharedPtr<FJsonObject>* Object;
+		if(Value->TryGetObject(Object))
+		{
+			FGitStubResponse Response;
+			(*Object)->TryGetStringField(TEXT("Pattern"), Response.Pattern);
+			(*Object)->TryGetStringField(TEXT("Output"), Response.Output);
+			(*Object)->TryGetStringField(TEXT("Errors"), Response.Errors);
+			(*Object)->TryGetNumberField(TEXT("ReturnCode"), Response.ReturnCode);
+			(*Object)->TryGetNumberField(TEXT("Latency"), Response.Latency);
+			(*Object)->TryGetNumberField(TEXT("OutputLimit"), Response.OutputLimit);
+			(*Object)->TryGetBoolField(TEXT("Hang"), Response.bHang);
+			LoadedResponses.Add(MoveTemp(Response));
+		}
+	}
+	SetResponses(MoveTemp(LoadedResponses));
+	return true;
+}
+
+bool FGitProcessStub::SaveResponses(const FString& InFilename) const
+{
+	TArray<TSharedPtr<FJsonValue>> Values;
+	{
+		FScopeLock ScopeLock(&CriticalSection);
+		for(const FGitStubResponse& Response : Responses)
+		{
+			TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+			Object->SetStringField(TEXT("Pattern"), Response.Pattern);
+			Object->SetStringField(TEXT("Output"), Response.Output);
+			Object->SetStringField(TEXT("Errors"), Response.Errors);
+			Object->SetNumberField(TEXT("ReturnCode"), Response.ReturnCode);
+			Object->SetNumberField(TEXT("Latency"), Response.Latency);
+			Object->SetNumberField(TEXT("OutputLimit"), Response.OutputLimit);
+			Object->SetBoolField(TEXT("Hang"), Response.bHang);
+			Values.Add(MakeShared<FJsonValueObject>(Object));
+		}
+	}
+
+	FString Json;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	return FJsonSerializer::Serialize(Values, Writer) && FFileHelper::SaveStringToFile(Json, *InFilename, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM);
+}
+
+void FGitProcessStub::StartRecording()
+{
+	FScopeLock ScopeLock(&CriticalSection);
+	Responses.Empty();
+	FPlatformAtomics::InterlockedExchange(&bReplaying, 0);
+	FPlatformAtomics::InterlockedExchange(&bRecording, 1);
+	UE_LOG(LogSourceControl, Log, TEXT("Git process stub: recording"));
+}
+
+void FGitProcessStub::Disable()
+{
+	FPlatformAtomics::InterlockedExchange(&bReplaying, 0);
+	FPlatformAtomics::InterlockedExchange(&bRecording, 0);
+	ReleaseHangs();
+}
+
+void FGitProcessStub::ReleaseHangs()
+{
+	ReleaseEvent->Trigger();
+}
+
+int32 FGitProcessStub::GetNumHanging() const
+{
+	return FPlatformAtomics::AtomicRead(&NumHanging);
+}
+
+int32 FGitProcessStub::GetNumMatched() const
+{
+	return FPlatformAtomics::AtomicRead(&NumMatched);
+}
+
+int32 FGitProcessStub::GetNumUnmatched() const
+{
+	return FPlatformAtomics::AtomicRead(&NumUnmatched);
+}
+
+bool FGitProcessStub::Run(const FString& InCommandLine, const FString& InRepositoryRoot, FString& OutResults, FString& OutErrors, int32& OutReturnCode)
+{
+	if(!FPlatformAtomics::AtomicRead(&bReplaying))
+	{
+		return false;
+	}
+
+	// Copy the response, to wait without holding the lock
+	const FString CommandLine = TokenizeRoot(InCommandLine, InRepositoryRoot);
+	FGitStubResponse Response;
+	{
+		FScopeLock ScopeLock(&CriticalSection);
+		const FGitStubResponse* MatchingResponse = Responses.FindByPredicate([&CommandLine](const FGitStubResponse& InResponse) { return CommandLine.MatchesWildcard(InResponse.Pattern, ESearchCase::CaseSensitive); });
+		if(MatchingResponse == nullptr)
+		{
+			// NOTE counted and logged so that a measure replaying responses does not silently measure git instead
+			FPlatformAtomics::InterlockedIncrement(&NumUnmatched);
+			UE_LOG(LogSourceControl, Log, TEXT("Git process stub: no response for 'git %s', running git"), *CommandLine);
+			return false;
+		}
+		Response = *MatchingResponse;
+	}
+	FPlatformAtomics::InterlockedIncrement(&NumMatched);
+
+	if(Response.Latency > 0.0)
+	{
+		FPlatformProcess::Sleep(static_cast<float>(Response.Latency));
+	}
+	if(Response.bHang)
+	{
+		FPlatformAtomics::InterlockedIncrement(&NumHanging);
+		ReleaseEvent->Wait();
+		FPlatformAtomics::InterlockedDecrement(&NumHanging);
+	}
+
+	OutResults = DetokenizeRoot((Response.OutputLimit >= 0) ? Response.Output.Left(Response.OutputLimit) : Response.Output, InRepositoryRoot);
+	OutErrors = DetokenizeRoot(Response.Errors, InRepositoryRoot);
+	OutReturnCode = Response.ReturnCode;
+	return true;
+}
+
+void FGitProcessStub::Record(const FString& InCommandLine, const FString& InRepositoryRoot, const FString& InResults, const FString& InErrors, const int32 InReturnCode)
+{
+	if(!FPlatformAtomics::AtomicRead(&bRecording))
+	{
+		return;
+	}
+
+	const FString CommandLine = TokenizeRoot(InCommandLine, InRepositoryRoot);
+	FScopeLock ScopeLock(&CriticalSection);
+	// The last output of a command line is the one replayed
+	FGitStubResponse* Response = Responses.FindByPredicate([&CommandLine](const FGitStubResponse& InResponse) { return InResponse.Pattern == CommandLine; });
+	if(Response == nullptr)
+	{
+		Response = &Responses.AddDefaulted_GetRef();
+		Response->Pattern = CommandLine;
+	}
+	Response->Output = TokenizeRoot(InResults, InRepositoryRoot);
+	Response->Errors = TokenizeRoot(InErrors, InRepositoryRoot);
+	Response->ReturnCode = InReturnCode;
+}
@@ -0,0 +1,109 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Event.h"
+#include "GitSourceControlProcess.h"
+
+/** Response replayed for the git command lines matching a pattern, with the faults to inject */
+struct FGitStubResponse
+{
+	/**
+	 * Wildcard matched against the command line, without the git binary nor the "-C <root>" (eg. "status *", "lfs locks*"),
+	 * where the root of the repository is replaced by "{Root}" (eg. "status --porcelain \"{Root}/Content/\"")
+	 */
+	FString Pattern;
+
+	/** Standard output and error streams (where "{Root}" stands for the root of the repository too), and exit code */
+	FString Output;
+	FString Errors;
+	int32 ReturnCode = 0;
+
+	/** Time to wait before answering, in seconds */
+	double Latency = 0.0;
+
+	/** Partial output: only the first characters of Output (-1 for the whole output) */
+	int32 OutputLimit = -1;
+
+	/** Do not answer until the hanging processes are released (or the stub disabled) */
+	bool bHang = false;
+};
+
+/**
+ * In-process stand-in for the git binary, to measure the parsers and the scheduling of commands independently of the speed of git,
+ * and to inject faults (latency, partial output, hangs, non-zero exit codes) deterministically.
+ *
+ * When enabled, the git command lines matching the pattern of a response get this response instead of running a process;
+ * the other ones still run git, so that only some commands can be stubbed (eg. "lfs locks" to stand in for the server).
+ * When recording, the outputs of the git processes are captured as responses, to be saved and replayed later.
+ * Thread-safe: used by the commands of worker threads, as the process interceptor of the git engine (see GitSourceControlCore::SetProcessInterceptor()).
+ */
+class FGitProcessStub : public IGitProcessInterceptor
+{
+public:
+	FGitProcessStub();
+	virtual ~FGitProcessStub();
+
+	static FGitProcessStub& Get();
+
+	/** Token standing for the root of the repository in the patterns and outputs, so that responses do not depend on where the repository is */
+	static const TCHAR* RootToken;
+
+	/** Replay these responses, the first matching response of a command line being used */
+	void SetResponses(TArray<FGitStubResponse>&& InResponses);
+
+	/** Replay the responses of a JSON file, as saved by SaveResponses() */
+	bool LoadResponses(const FString& InFilename);
+
+	/** Save the responses (replayed or recorded) to a JSON file */
+	bool SaveResponses(const FString& InFilename) const;
+
+	/** Capture the outputs of the git processes, replacing the current responses */
+	void StartRecording();
+
+	/** Stop replaying and recording, and release the hanging processes */
+	void Disable();
+
+	/** Release the processes hanging, to let them answer */
+	void ReleaseHangs();
+
+	/** @returns the number of processes hanging */
+	int32 GetNumHanging() const;
+
+	/** @returns the number of command lines answered by a response, and the number of the ones without a matching response (run by git), since replaying */
+	int32 GetNumMatched() const;
+	int32 GetNumUnmatched() const;
+
+	/**
+	 * Answer a git command line with the first response matching it, if any.
+	 * @param	InRepositoryRoot	Root of the repository of the command, replaced by RootToken to match the patterns
+	 * @returns false if the stub is not replaying, or if no response matches (then git has to be run, and the command line is logged)
+	 */
+	virtual bool Run(const FString& InCommandLine, const FString& InRepositoryRoot, FString& OutResults, FString& OutErrors, int32& OutReturnCode) override;
+
+	/** Capture the outputs of a git process, if recording, with the root of the repository replaced by RootToken */
+	virtual void Record(const FString& InCommandLine, const FString& InRepositoryRoot, const FString& InResults, const FString& InErrors, const int32 InReturnCode) override;
+
+private:
+	/** A critical section for the responses */
+	mutable FCriticalSection CriticalSection;
+
+	TArray<FGitStubResponse> Responses;
+
+	/** Fast check of the mode without locking, from each git process */
+	volatile int32 bReplaying = 0;
+	volatile int32 bRecording = 0;
+
+	/** Triggered to release the hanging processes (manual reset) */
+	FEvent* ReleaseEvent = nullptr;
+	volatile int32 NumHanging = 0;
+
+	/** Command lines answered by a response, and without any matching response, since replaying */
+	volatile int32 NumMatched = 0;
+	volatile int32 NumUnmatched = 0;
+};
@@ -0,0 +1,168 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "CoreMinimal.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+#include "GitSourceControlCommand.h"
+#include "GitSourceControlModule.h"
+#include "GitSourceControlOperations.h"
+#include "GitSourceControlUtils.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Local fixture of a Sync: a bare remote, a clone of the user with local changes, and a clone of another user pushing to the remote.
+ * Runs git, but needs no network access (nor Git LFS).
+ */
+class FGitSyncFixture
+{
+public:
+	FGitSyncFixture(FAutomationTestBase& InTest, const FString& InPathToGitBinary)
+		: Test(InTest)
+		, PathToGitBinary(InPathToGitBinary)
+		, WorkDir(FPaths::ConvertRelativePathToFull(FPaths::CreateTempFilename(*FPaths::ProjectIntermediateDir(), TEXT("GitSyncTest-"))))
+		, RemoteDir(WorkDir / TEXT("Remote.git"))
+		, RepositoryDir(WorkDir / TEXT("Repository"))
+		, UpstreamDir(WorkDir / TEXT("Upstream"))
+	{
+	}
+
+	~FGitSyncFixture()
+	{
+		IFileManager::Get().DeleteDirectory(*WorkDir, false, true);
+	}
+
+	/** Create the remote with a first commit, and the two clones */
+	bool SetUp()
+	{
+		IFileManager::Get().MakeDirectory(*RemoteDir, true);
+		IFileManager::Get().MakeDirectory(*UpstreamDir, true);
+		bool bResult = RunGit(RemoteDir, TEXT("init"), { TEXT("--bare"), TEXT("--quiet") });
+		bResult &= RunGit(UpstreamDir, TEXT("init"), { TEXT("--quiet") });
+		bResult &= ConfigUser(UpstreamDir, TEXT("Upstream"));
+		bResult &= WriteFile(UpstreamDir, TEXT("Content/Modified.uasset"), TEXT("Initial"));
+		bResult &= WriteFile(UpstreamDir, TEXT("Content/Deleted.uasset"), TEXT("Initial"));
+		bResult &= WriteFile(UpstreamDir, TEXT("Content/Unchanged.uasset"), TEXT("Initial"));
+		bResult &= WriteFile(UpstreamDir, TEXT("Content/Local.uasset"), TEXT("Initial"));
+		bResult &= RunGit(UpstreamDir, TEXT("add"), { TEXT("--all") });
+		bResult &= RunGit(UpstreamDir, TEXT("commit"), { TEXT("--quiet"), TEXT("-m \"Initial commit\"") });
+		bResult &= RunGit(UpstreamDir, TEXT("remote"), { TEXT("add"), TEXT("origin"), FString::Printf(TEXT("\"%s\""), *RemoteDir) });
+		bResult &= RunGit(UpstreamDir, TEXT("push"), { TEXT("--quiet"), TEXT("--set-upstream"), TEXT("origin"), TEXT("HEAD") });
+		bResult &= RunGit(WorkDir, TEXT("clone"), { TEXT("--quiet"), FString::Printf(TEXT("\"%s\" \"%s\""), *RemoteDir, *RepositoryDir) });
+		bResult &= ConfigUser(RepositoryDir, TEXT("User"));
+		return bResult;
+	}
+
+	bool RunGit(const FString& InRepositoryRoot, const FString& InCommand, const TArray<FString>& InParameters)
+	{
+		TArray<FString> Results;
+		TArray<FString> ErrorMessages;
+		const bool bResult = GitSourceControlCore::RunCommand(InCommand, PathToGitBinary, InRepositoryRoot, InParameters, TArray<FString>(), Results, ErrorMessages);
+		if(!bResult)
+		{
+			Test.AddError(FString::Printf(TEXT("git %s failed: %s"), *InCommand, *FString::Join(ErrorMessages, TEXT("\n"))));
+		}
+		return bResult;
+	}
+
+	bool WriteFile(const FString& InRepositoryRoot, const FString& InFile, const FString& InContent)
+	{
+		return FFileHelper::SaveStringToFile(InContent, *(InRepositoryRoot / InFile));
+	}
+
+	/** Absolute filename of a file of the clone of the user, as reported by the Sync */
+	FString RepositoryFile(const FString& InFile) const
+	{
+		return RepositoryDir / InFile;
+	}
+
+	FAutomationTestBase& Test;
+	const FString PathToGitBinary;
+	const FString WorkDir;
+	const FString RemoteDir;
+	const FString RepositoryDir;
+	const FString UpstreamDir;
+
+private:
+	bool ConfigUser(const FString& InRepositoryRoot, const FString& InName)
+	{
+		bool bResult = RunGit(InRepositoryRoot, TEXT("config"), { TEXT("user.name"), InName });
+		bResult &= RunGit(InRepositoryRoot, TEXT("config"), { TEXT("user.email"), InName.ToLower() + TEXT("@localhost") });
+		return bResult;
+	}
+};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGitSourceControlSyncTest, "Editor.SourceControl.Git.Sync", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+/**
+ * A SyncAll must report exactly the files changed by the pull (added, modified and deleted), and the deleted ones as to be removed from the cache,
+ * while the local commit is rebased and the local modification stashed meanwhile.
+ */
+bool FGitSourceControlSyncTest::RunTest(const FString& Parameters)
+{
+	const FString PathToGitBinary = GitSourceControlUtils::FindGitBinaryPath();
+	if(PathToGitBinary.IsEmpty() || !GitSourceControlUtils::CheckGitAvailability(PathToGitBinary))
+	{
+		AddError(TEXT("Git not found"));
+		return false;
+	}
+
+	FGitSyncFixture Fixture(*this, PathToGitBinary);
+	if(!Fixture.SetUp())
+	{
+		return false;
+	}
+
+	// The user commits a new file, and modifies another one without committing it
+	bool bResult = Fixture.WriteFile(Fixture.RepositoryDir, TEXT("Content/Committed.uasset"), TEXT("User"));
+	bResult &= Fixture.RunGit(Fixture.RepositoryDir, TEXT("add"), { TEXT("--all") });
+	bResult &= Fixture.RunGit(Fixture.RepositoryDir, TEXT("commit"), { TEXT("--quiet"), TEXT("-m \"Local commit\"") });
+	bResult &= Fixture.WriteFile(Fixture.RepositoryDir, TEXT("Content/Local.uasset"), TEXT("User"));
+
+	// Meanwhile, the other user adds, modifies and deletes files
+	bResult &= Fixture.WriteFile(Fixture.UpstreamDir, TEXT("Content/Added.uasset"), TEXT("Upstream"));
+	bResult &= Fixture.WriteFile(Fixture.UpstreamDir, TEXT("Content/Modified.uasset"), TEXT("Upstream"));
+	bResult &= IFileManager::Get().Delete(*(Fixture.UpstreamDir / TEXT("Content/Deleted.uasset")));
+	bResult &= Fixture.RunGit(Fixture.UpstreamDir, TEXT("add"), { TEXT("--all") });
+	bResult &= Fixture.RunGit(Fixture.UpstreamDir, TEXT("commit"), { TEXT("--quiet"), TEXT("-m \"Upstream commit\"") });
+	bResult &= Fixture.RunGit(Fixture.UpstreamDir, TEXT("push"), { TEXT("--quiet"), TEXT("origin"), TEXT("HEAD") });
+	if(!bResult)
+	{
+		return false;
+	}
+
+	// SyncAll as issued by the menu
+	TSharedRef<FGitSyncAll, ESPMode::ThreadSafe> Operation = ISourceControlOperation::Create<FGitSyncAll>();
+	TSharedRef<FGitSyncWorker, ESPMode::ThreadSafe> Worker = MakeShared<FGitSyncWorker, ESPMode::ThreadSafe>();
+	FGitSourceControlCommand Command(Operation, Worker);
+	Command.PathToGitBinary = PathToGitBinary;
+	Command.PathToRepositoryRoot = Fixture.RepositoryDir;
+	Command.bUsingGitLfsLocking = false;
+	if(!TestTrue(TEXT("Sync succeeded"), Command.DoWork()))
+	{
+		AddError(FString::Join(Command.ErrorMessages, TEXT("\n")));
+		return false;
+	}
+
+	TArray<FString> ChangedFiles = Operation->ChangedFiles;
+	ChangedFiles.Sort();
+	const TArray<FString> ExpectedChangedFiles = { Fixture.RepositoryFile(TEXT("Content/Added.uasset")), Fixture.RepositoryFile(TEXT("Content/Deleted.uasset")), Fixture.RepositoryFile(TEXT("Content/Modified.uasset")) };
+	TestEqual(TEXT("Changed files"), ChangedFiles, ExpectedChangedFiles);
+	TestEqual(TEXT("Deleted files"), Worker->DeletedFiles, TArray<FString>({ Fixture.RepositoryFile(TEXT("Content/Deleted.uasset")) }));
+
+	// The local commit was rebased, and the local modification restored
+	FString LocalContent;
+	FFileHelper::LoadFileToString(LocalContent, *Fixture.RepositoryFile(TEXT("Content/Local.uasset")));
+	TestEqual(TEXT("Local modification"), LocalContent, FString(TEXT("User")));
+	TestTrue(TEXT("Local commit"), FPaths::FileExists(Fixture.RepositoryFile(TEXT("Content/Committed.uasset"))));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
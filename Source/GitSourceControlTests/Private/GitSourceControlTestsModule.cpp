@@ -0,0 +1,72 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#include "GitSourceControlTestsModule.h"
+
+#include "Modules/ModuleManager.h"
+#include "ISourceControlModule.h"
+#include "GitSourceControlProcess.h"
+#include "GitSourceControlProcessStub.h"
+
+void FGitSourceControlTestsModule::StartupModule()
+{
+	// Let the stand-in for git answer the command lines of the git engine once it replays responses (see the "git.Stub" console command)
+	GitSourceControlCore::SetProcessInterceptor(&FGitProcessStub::Get());
+
+	StubConsoleCommand = MakeUnique<FAutoConsoleCommand>(
+		TEXT("git.Stub"),
+		TEXT("Answer git commands in-process with recorded responses, to measure and test without depending on git nor on a server.\n")
+		TEXT("'git.Stub Load <responses.json>' replays responses (Pattern, Output, Errors, ReturnCode, Latency, OutputLimit, Hang),\n")
+		TEXT("'git.Stub Record' captures the outputs of git, 'git.Stub Save <responses.json>' saves them,\n")
+		TEXT("'git.Stub Release' releases the hanging processes, and 'git.Stub Off' runs git again."),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FGitSourceControlTestsModule::ExecuteStubConsoleCommand)
+	);
+}
+
+void FGitSourceControlTestsModule::ShutdownModule()
+{
+	StubConsoleCommand.Reset();
+
+	// Release the processes hanging in the stub before it goes away with this module
+	GitSourceControlCore::SetProcessInterceptor(nullptr);
+	FGitProcessStub::Get().Disable();
+}
+
+void FGitSourceControlTestsModule::ExecuteStubConsoleCommand(const TArray<FString>& a_args)
+{
+	FGitProcessStub& ProcessStub = FGitProcessStub::Get();
+	const FString Action = (a_args.Num() > 0) ? a_args[0] : FString();
+	if ((Action == TEXT("Load")) && (a_args.Num() > 1))
+	{
+		ProcessStub.LoadResponses(a_args[1]);
+	}
+	else if (Action == TEXT("Record"))
+	{
+		ProcessStub.StartRecording();
+	}
+	else if ((Action == TEXT("Save")) && (a_args.Num() > 1))
+	{
+		if (ProcessStub.SaveResponses(a_args[1]))
+		{
+			UE_LOG(LogSourceControl, Log, TEXT("Git process stub: responses saved to '%s'"), *a_args[1]);
+		}
+	}
+	else if (Action == TEXT("Release"))
+	{
+		UE_LOG(LogSourceControl, Log, TEXT("Git process stub: releasing %d hanging process(es)"), ProcessStub.GetNumHanging());
+		ProcessStub.ReleaseHangs();
+	}
+	else if (Action == TEXT("Off"))
+	{
+		UE_LOG(LogSourceControl, Log, TEXT("Git process stub: %d command(s) answered, %d without a matching response"), ProcessStub.GetNumMatched(), ProcessStub.GetNumUnmatched());
+		ProcessStub.Disable();
+	}
+	else
+	{
+		UE_LOG(LogSourceControl, Warning, TEXT("Usage: git.Stub Load <responses.json> | Record | Save <responses.json> | Release | Off"));
+	}
+}
+
+IMPLEMENT_MODULE(FGitSourceControlTestsModule, GitSourceControlTests);
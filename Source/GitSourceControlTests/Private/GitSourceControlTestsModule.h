@@ -0,0 +1,30 @@
+// Copyright (c) 2014-2022 Sebastien Rombauts (sebastien.rombauts@gmail.com)
+//
+// Distributed under the MIT License (MIT) (See accompanying file LICENSE.txt
+// or copy at http://opensource.org/licenses/MIT)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "Modules/ModuleInterface.h"
+
+/**
+ * Benchmark and test fixtures of the Git provider.
+ *
+ * Plugs the in-process stand-in for git (FGitProcessStub) into the git engine, driven by the "git.Stub" console command.
+ */
+class FGitSourceControlTestsModule : public IModuleInterface
+{
+public:
+	/** IModuleInterface implementation */
+	virtual void StartupModule() override;
+	virtual void ShutdownModule() override;
+
+private:
+	// Drive the in-process stand-in for the git binary: replay responses, record them, release hanging processes
+	void ExecuteStubConsoleCommand(const TArray<FString>& a_args);
+
+	/** Console command for the git process stub */
+	TUniquePtr<FAutoConsoleCommand> StubConsoleCommand;
+};